@@ -0,0 +1,27 @@
+#pragma once
+
+#include <libasm/Register.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace asmlsp
+{
+
+/**
+ * Effective address of a memory operand: [base + index * scale + displacement].
+ */
+struct AddressingMode
+{
+	Register base;             //!< base register, if any
+	Register index;            //!< index register, if any
+	uint8_t scale = 1;         //!< 1, 2, 4 or 8
+	int64_t displacement = 0;
+	bool ripRelative = false;  //!< [rip + displacement], i.e. a reference to a data symbol
+	std::string symbol;        //!< referenced symbol the displacement is relative to, if any
+
+	/** Tests whether an index register is used, which affects uop fusion. */
+	bool isIndexed() const noexcept { return static_cast<bool>(index); }
+};
+
+}
@@ -0,0 +1,228 @@
+#include <libasm/AvxTransitionAnalysis.hpp>
+#include <libasm/Dataflow.hpp>
+#include <libasm/InstructionDefinition.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <unordered_set>
+
+namespace asmlsp
+{
+
+namespace
+{
+	const char* describe(uint8_t state)
+	{
+		return state == AvxTransitionAnalysis::Dirty ? "are dirty" : "may be dirty";
+	}
+}
+
+void AvxTransitionAnalysis::analyze(const std::vector<FunctionDefinition*>& functions)
+{
+	functions_.clear();
+	for (FunctionDefinition* function: functions)
+		functions_[function];
+
+	for (FunctionDefinition* function: functions)
+		buildCallGraph(function);
+
+	solve(functions);
+}
+
+void AvxTransitionAnalysis::update(FunctionDefinition* function)
+{
+	for (auto& [_, state]: functions_)
+	{
+		auto& callers = state.callers;
+		callers.erase(std::remove(callers.begin(), callers.end(), function), callers.end());
+	}
+
+	// Restart from the lattice bottom, the edit may have removed dirtying instructions.
+	FunctionSummary const previous = functions_[function].summary;
+	functions_[function].summary = FunctionSummary{};
+	buildCallGraph(function);
+
+	solve({function}, &previous);
+}
+
+const AvxTransitionAnalysis::FunctionSummary* AvxTransitionAnalysis::summaryOf(const FunctionDefinition* function) const
+{
+	auto const i = functions_.find(function);
+	return i != functions_.end() ? &i->second.summary : nullptr;
+}
+
+std::vector<Diagnostic> AvxTransitionAnalysis::diagnostics() const
+{
+	std::vector<Diagnostic> result;
+	for (auto const& [_, state]: functions_)
+		result.insert(result.end(), state.diagnostics.begin(), state.diagnostics.end());
+	return result;
+}
+
+const std::vector<Diagnostic>& AvxTransitionAnalysis::diagnostics(const FunctionDefinition* function) const
+{
+	static const std::vector<Diagnostic> none;
+	auto const i = functions_.find(function);
+	return i != functions_.end() ? i->second.diagnostics : none;
+}
+
+void AvxTransitionAnalysis::buildCallGraph(FunctionDefinition* function)
+{
+	for (auto const& bb: function->basicBlocks())
+	{
+		for (auto const& instr: bb->instructions())
+		{
+			auto const* call = dynamic_cast<const CallInstr*>(instr.get());
+			if (!call || !call->callee())
+				continue;
+
+			auto const callee = functions_.find(call->callee());
+			if (callee == functions_.end())
+				continue;
+
+			auto& callers = callee->second.callers;
+			if (std::find(callers.begin(), callers.end(), function) == callers.end())
+				callers.push_back(function);
+		}
+	}
+}
+
+void AvxTransitionAnalysis::solve(std::vector<FunctionDefinition*> initial, const FunctionSummary* previous)
+{
+	FunctionDefinition const* const edited = previous ? initial.front() : nullptr;
+
+	std::deque<FunctionDefinition*> worklist(initial.begin(), initial.end());
+	std::unordered_set<FunctionDefinition*> queued(initial.begin(), initial.end());
+	std::unordered_set<FunctionDefinition*> visited;
+
+	while (!worklist.empty())
+	{
+		FunctionDefinition* function = worklist.front();
+		worklist.pop_front();
+		queued.erase(function);
+		visited.insert(function);
+
+		FunctionState& state = functions_[function];
+		FunctionSummary const summary = analyzeFunction(function, nullptr);
+		bool const changed = summary != state.summary;
+		state.summary = summary;
+
+		// Callers of the edited function saw its summary from before the edit, not the bottom it restarted from.
+		bool const callersStale = function == edited ? summary != *previous : changed;
+		for (FunctionDefinition* caller: state.callers)
+			if ((caller == function ? changed : callersStale) && queued.insert(caller).second)
+				worklist.push_back(caller);
+	}
+
+	// Summaries are final now, so a single reporting pass per function suffices.
+	for (FunctionDefinition* function: visited)
+	{
+		FunctionState& state = functions_[function];
+		state.diagnostics.clear();
+		analyzeFunction(function, &state.diagnostics);
+	}
+}
+
+AvxTransitionAnalysis::FunctionSummary AvxTransitionAnalysis::analyzeFunction(
+	FunctionDefinition* function, std::vector<Diagnostic>* diagnostics) const
+{
+	FunctionSummary summary{0, false};
+	if (!function->entryBlock())
+		return summary;
+
+	FunctionSummary scratch;
+	auto const result = solveForward<uint8_t>(
+		function->entryBlock(), Entry, 0, MeetOperator::Union, [&](BasicBlock& bb, uint8_t state) {
+			for (auto const& instr: bb.instructions())
+				state = transfer(*instr, state, scratch, nullptr);
+			return state;
+		});
+
+	// Replay every reachable block once from its fixpoint in-state.
+	for (BasicBlock* bb: result.order())
+	{
+		uint8_t state = result.in(bb);
+		for (auto const& instr: bb->instructions())
+			state = transfer(*instr, state, summary, diagnostics);
+	}
+
+	return summary;
+}
+
+uint8_t AvxTransitionAnalysis::transfer(Instr& instr,
+										uint8_t state,
+										FunctionSummary& summary,
+										std::vector<Diagnostic>* diagnostics) const
+{
+	auto const report = [&](std::string message) {
+		if (diagnostics)
+			diagnostics->emplace_back(Diagnostic{Severity::Warning, "avx-sse-transition", std::move(message), &instr});
+	};
+
+	auto const callUnknown = [&](const std::string& name) -> uint8_t {
+		// The ABI demands clean upper halves at call boundaries in both directions.
+		if (state & Dirty)
+			report("calling " + name + " while upper vector halves " + describe(state) + "; insert vzeroupper before the call");
+		if (state & Entry)
+			summary.requiresCleanEntry = true;
+		return Clean;
+	};
+
+	if (auto* call = dynamic_cast<CallInstr*>(&instr))
+	{
+		const FunctionSummary* callee = call->callee() ? summaryOf(call->callee()) : nullptr;
+		if (!callee)
+			return callUnknown(call->callee() ? "'" + call->callee()->name() + "'" : "unknown function");
+
+		if (callee->requiresCleanEntry)
+		{
+			if (state & Dirty)
+				report("calling '" + call->callee()->name() + "', which executes legacy SSE, while upper vector halves "
+					   + describe(state) + "; insert vzeroupper before the call");
+			if (state & Entry)
+				summary.requiresCleanEntry = true;
+		}
+
+		uint8_t out = callee->exitState & ~Entry;
+		if (callee->exitState & Entry)
+			out |= state;
+		return out;
+	}
+
+	auto* cpu = dynamic_cast<CpuInstr*>(&instr);
+	if (!cpu || !cpu->definition())
+		return state;
+
+	InstructionDefinition const& def = *cpu->definition();
+
+	if (def.hasFlag(InstructionFlags::ClearsUpperVector))
+		return Clean;
+
+	if (def.hasFlag(InstructionFlags::Call))
+		return callUnknown("indirect target");
+
+	if (def.hasFlag(InstructionFlags::Return))
+	{
+		if (state & Dirty)
+			report("returning while upper vector halves " + std::string(describe(state)) + "; insert vzeroupper before ret");
+		summary.exitState |= state;
+		return state;
+	}
+
+	if (def.isLegacySSE())
+	{
+		if (state & Dirty)
+			report("legacy SSE instruction '" + def.mnemonic() + "' executed while upper vector halves "
+				   + describe(state) + "; insert vzeroupper after the last 256/512 bit instruction");
+		if (state & Entry)
+			summary.requiresCleanEntry = true;
+		return state;
+	}
+
+	if (def.isWideVector())
+		return Dirty;
+
+	return state;
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <libasm/Diagnostic.hpp>
+#include <libasm/SSA.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Detects AVX/SSE transition penalties.
+ *
+ * Executing a legacy SSE instruction while the upper halves of the YMM/ZMM
+ * registers are dirty (i.e. after a 256/512 bit VEX/EVEX instruction without
+ * an intermediate vzeroupper) causes either a state transition stall or a
+ * false dependency on every SSE write, depending on the microarchitecture.
+ *
+ * The analysis is a forward may-dataflow over a small bitset lattice
+ * (see UpperState). Calls are handled through per-function summaries that
+ * are computed bottom-up over the call graph until a fixpoint is reached.
+ *
+ * Reported are:
+ * <ul>
+ *   <li>legacy SSE instructions reached with possibly dirty upper halves</li>
+ *   <li>ret instructions reached with possibly dirty upper halves</li>
+ *   <li>calls to unknown functions or functions executing legacy SSE with
+ *       possibly dirty upper halves</li>
+ * </ul>
+ */
+class AvxTransitionAnalysis
+{
+public:
+	/**
+	 * Lattice bits describing the state of the upper vector register halves.
+	 */
+	enum UpperState : uint8_t
+	{
+		Clean = 1 << 0, //!< upper halves are known to be zero
+		Dirty = 1 << 1, //!< upper halves may contain non-zero data
+		Entry = 1 << 2, //!< whatever state the function was entered with
+	};
+
+	/**
+	 * What callers need to know about a function.
+	 */
+	struct FunctionSummary
+	{
+		/**
+		 * Possible states upon return, where Entry denotes a pass-through of the
+		 * caller's state, and no bits at all denote a function that never returns.
+		 */
+		uint8_t exitState = 0;
+
+		/** Whether the function executes legacy SSE before establishing a clean state itself. */
+		bool requiresCleanEntry = false;
+
+		bool operator==(const FunctionSummary& other) const noexcept
+		{
+			return exitState == other.exitState && requiresCleanEntry == other.requiresCleanEntry;
+		}
+		bool operator!=(const FunctionSummary& other) const noexcept { return !(*this == other); }
+	};
+
+	/**
+	 * Analyzes all given functions, computing summaries for the whole call graph.
+	 *
+	 * Previously computed results are discarded.
+	 */
+	void analyze(const std::vector<FunctionDefinition*>& functions);
+
+	/**
+	 * Re-analyzes a single edited function using the cached summaries of
+	 * all other functions, and re-analyzes its transitive callers only
+	 * if its summary changed.
+	 */
+	void update(FunctionDefinition* function);
+
+	/**
+	 * Retrieves the summary of the given function or nullptr if unknown.
+	 */
+	const FunctionSummary* summaryOf(const FunctionDefinition* function) const;
+
+	/**
+	 * Retrieves all diagnostics of the most recent run, grouped by function.
+	 */
+	std::vector<Diagnostic> diagnostics() const;
+
+	/**
+	 * Retrieves the diagnostics of the most recent run for the given function.
+	 */
+	const std::vector<Diagnostic>& diagnostics(const FunctionDefinition* function) const;
+
+private:
+	struct FunctionState
+	{
+		FunctionSummary summary;
+		std::vector<Diagnostic> diagnostics;
+		std::vector<FunctionDefinition*> callers;
+	};
+
+	void buildCallGraph(FunctionDefinition* function);
+
+	/**
+	 * Iterates summaries to a fixpoint, starting from @p worklist.
+	 *
+	 * @param previous summary of the single function in @p worklist from before
+	 *                 its reset; its callers are re-analyzed only if the new
+	 *                 summary differs from that
+	 */
+	void solve(std::vector<FunctionDefinition*> worklist, const FunctionSummary* previous = nullptr);
+	FunctionSummary analyzeFunction(FunctionDefinition* function, std::vector<Diagnostic>* diagnostics) const;
+	uint8_t transfer(Instr& instr, uint8_t state, FunctionSummary& summary, std::vector<Diagnostic>* diagnostics) const;
+
+	std::unordered_map<const FunctionDefinition*, FunctionState> functions_;
+};
+
+}
@@ -0,0 +1,232 @@
+#include <libasm/BackgroundIndexer.hpp>
+#include <libasm/LabelIndex.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace asmlsp
+{
+
+namespace
+{
+	bool hasExtension(const std::string& path, const std::vector<std::string>& extensions)
+	{
+		return std::any_of(extensions.begin(), extensions.end(), [&](const std::string& extension) {
+			return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+		});
+	}
+
+	/** Combines a queued change with a newer one of the same file. */
+	FileChangeType merge(FileChangeType queued, FileChangeType latest)
+	{
+		if (latest == FileChangeType::Deleted)
+			return FileChangeType::Deleted;
+		if (queued == FileChangeType::Deleted)
+			return FileChangeType::Changed; // deleted and recreated
+		return queued;
+	}
+}
+
+BackgroundIndexer::BackgroundIndexer(SymbolIndex& symbols, Options options):
+	symbols_{symbols},
+	options_{std::move(options)}
+{
+	concurrency_ = options_.threads;
+	if (concurrency_ == 0)
+		concurrency_ = std::max(1u, std::thread::hardware_concurrency() / 4);
+}
+
+BackgroundIndexer::~BackgroundIndexer()
+{
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	tasks_.wait();
+}
+
+void BackgroundIndexer::enqueue(std::vector<FileEvent> events)
+{
+	std::unique_lock lock(mutex_);
+	bool const wasIdle = queue_.empty() && active_ == 0;
+
+	size_t added = 0;
+	for (FileEvent& event: events)
+	{
+		if (!hasExtension(event.path, options_.extensions))
+			continue;
+
+		if (auto const busy = indexing_.find(event.path); busy != indexing_.end())
+		{
+			// indexed again once the current run is done, see drain()
+			busy->second = busy->second ? merge(*busy->second, event.type) : event.type;
+			continue;
+		}
+
+		auto [i, inserted] = pending_.try_emplace(event.path, event.type);
+		if (!inserted)
+		{
+			i->second = merge(i->second, event.type);
+			continue;
+		}
+		queue_.push_back(std::move(event.path));
+		++added;
+	}
+
+	if (added == 0)
+		return;
+
+	if (wasIdle)
+	{
+		done_ = 0;
+		total_ = 0;
+	}
+	total_ += added;
+	if (wasIdle)
+		report(Progress::Begin);
+
+	spawn();
+}
+
+void BackgroundIndexer::beginInteractive()
+{
+	std::lock_guard lock(mutex_);
+	++interactive_;
+}
+
+void BackgroundIndexer::endInteractive()
+{
+	std::lock_guard lock(mutex_);
+	if (--interactive_ == 0)
+		spawn();
+}
+
+void BackgroundIndexer::wait()
+{
+	std::unique_lock lock(mutex_);
+	idle_.wait(lock, [&]() { return queue_.empty() && active_ == 0; });
+}
+
+size_t BackgroundIndexer::pending() const
+{
+	std::lock_guard lock(mutex_);
+	return queue_.size();
+}
+
+void BackgroundIndexer::report(Progress::Kind kind)
+{
+	if (!options_.progress)
+		return;
+
+	auto const now = std::chrono::steady_clock::now();
+	if (kind == Progress::Report && now - lastReport_ < options_.progressInterval)
+		return;
+	lastReport_ = now;
+
+	options_.progress(Progress{kind, done_, total_, std::to_string(done_) + "/" + std::to_string(total_) + " files"});
+}
+
+void BackgroundIndexer::spawn()
+{
+	while (!stop_ && interactive_ == 0 && drainers_ < std::min(concurrency_, queue_.size()))
+	{
+		++drainers_;
+		tasks_.run([this]() { drain(); }, TaskPriority::Background);
+	}
+}
+
+void BackgroundIndexer::drain()
+{
+	std::unique_lock lock(mutex_);
+	while (!stop_ && interactive_ == 0 && !queue_.empty())
+	{
+		// Rather than sleeping on a worker, continue once reading is within budget again.
+		if (auto const due = budgetDue(); due > std::chrono::steady_clock::now())
+		{
+			tasks_.runAt(due, [this]() { drain(); }, TaskPriority::Background);
+			return; // still counted in drainers_
+		}
+
+		std::string path = std::move(queue_.front());
+		queue_.pop_front();
+		FileChangeType const type = pending_.at(path);
+		pending_.erase(path);
+		indexing_.emplace(path, std::nullopt);
+		++active_;
+
+		lock.unlock();
+		index(path, type);
+		lock.lock();
+
+		auto const busy = indexing_.find(path);
+		if (std::optional<FileChangeType> const since = busy->second)
+		{
+			pending_.emplace(path, *since);
+			queue_.push_back(std::move(path));
+			++total_;
+		}
+		indexing_.erase(busy);
+		--active_;
+		++done_;
+		if (queue_.empty() && active_ == 0)
+		{
+			report(Progress::End);
+			idle_.notify_all();
+		}
+		else
+			report(Progress::Report);
+	}
+	--drainers_;
+}
+
+void BackgroundIndexer::index(const std::string& path, FileChangeType type)
+{
+	if (type == FileChangeType::Deleted)
+	{
+		symbols_.remove(path);
+		return;
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		symbols_.remove(path);
+		return;
+	}
+
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	std::string const source = std::move(contents).str();
+	consumeBudget(source.size());
+
+	symbols_.update(path, LabelIndex(source).symbols());
+}
+
+void BackgroundIndexer::consumeBudget(size_t bytes)
+{
+	if (options_.bytesPerSecond == 0)
+		return;
+
+	std::lock_guard lock(throttleMutex_);
+	auto const now = std::chrono::steady_clock::now();
+	if (throttleBytes_ == 0 || now - throttleStart_ >= std::chrono::seconds(1))
+	{
+		throttleStart_ = now;
+		throttleBytes_ = 0;
+	}
+	throttleBytes_ += bytes;
+}
+
+std::chrono::steady_clock::time_point BackgroundIndexer::budgetDue()
+{
+	if (options_.bytesPerSecond == 0)
+		return {};
+
+	// as late as reading what was read should have taken
+	std::lock_guard lock(throttleMutex_);
+	return throttleStart_ + std::chrono::microseconds(throttleBytes_ * 1'000'000 / options_.bytesPerSecond);
+}
+
+}
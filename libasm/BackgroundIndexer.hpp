@@ -0,0 +1,138 @@
+#pragma once
+
+#include <libasm/FileWatcher.hpp>
+#include <libasm/SymbolIndex.hpp>
+#include <libasm/ThreadPool.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Keeps the workspace SymbolIndex up to date with files changed on disk.
+ *
+ * File events are deduplicated by path, so a file changed several times
+ * before it got indexed is indexed once, with its latest state. A file
+ * changed while being indexed is queued again once that is done, rather
+ * than indexed twice concurrently. Files are
+ * indexed by a few Background tasks on the shared ThreadPool, reading at
+ * most a configured number of bytes per second: a task that used up the
+ * budget returns its worker to the pool and is resubmitted for the time
+ * the budget allows more reading. Whenever an interactive
+ * request is being served (see InteractiveScope), tasks finish the file at
+ * hand and return their worker to the pool, and are resubmitted once the
+ * request is done, so that a branch switch touching thousands of files
+ * neither saturates all cores nor delays hover or completion.
+ *
+ * Indexing builds a LabelIndex per file, which neither parses instructions
+ * nor lowers anything, so a file costs about as much as reading it.
+ */
+class BackgroundIndexer
+{
+public:
+	/**
+	 * Progress of a batch of indexing work, mapped to $/progress by the server.
+	 */
+	struct Progress
+	{
+		enum Kind
+		{
+			Begin,
+			Report,
+			End,
+		};
+
+		Kind kind;
+		size_t done;
+		size_t total;
+		std::string message;
+	};
+
+	struct Options
+	{
+		size_t threads = 0;                         //!< concurrent indexing tasks, 0 for a quarter of the cores, at least one
+		size_t bytesPerSecond = size_t{64} << 20;   //!< read throttle, 0 for unlimited
+		std::vector<std::string> extensions = {".asm", ".s", ".S", ".nasm", ".inc"};
+		std::function<void(const Progress&)> progress; //!< called with the indexer locked, must not call back into it
+		std::chrono::milliseconds progressInterval{200};
+	};
+
+	/**
+	 * Marks an interactive request being served for its lifetime.
+	 */
+	class InteractiveScope
+	{
+	public:
+		explicit InteractiveScope(BackgroundIndexer& indexer): indexer_{indexer} { indexer_.beginInteractive(); }
+		~InteractiveScope() { indexer_.endInteractive(); }
+
+		InteractiveScope(const InteractiveScope&) = delete;
+		InteractiveScope& operator=(const InteractiveScope&) = delete;
+
+	private:
+		BackgroundIndexer& indexer_;
+	};
+
+	BackgroundIndexer(SymbolIndex& symbols, Options options);
+	~BackgroundIndexer();
+
+	BackgroundIndexer(const BackgroundIndexer&) = delete;
+	BackgroundIndexer& operator=(const BackgroundIndexer&) = delete;
+
+	/**
+	 * Queues @p events, e.g. from workspace/didChangeWatchedFiles or a FileWatcher.
+	 */
+	void enqueue(std::vector<FileEvent> events);
+
+	void beginInteractive();
+	void endInteractive();
+
+	/** Blocks until all queued files are indexed. */
+	void wait();
+
+	/** Number of files queued but not yet picked up. */
+	size_t pending() const;
+
+private:
+	void spawn();
+	void drain();
+	void index(const std::string& path, FileChangeType type);
+	void consumeBudget(size_t bytes);
+	std::chrono::steady_clock::time_point budgetDue();
+	void report(Progress::Kind kind);
+
+	SymbolIndex& symbols_;
+	Options options_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable idle_;
+	std::deque<std::string> queue_;
+	std::unordered_map<std::string, FileChangeType> pending_; //!< latest change of each queued path
+	std::unordered_map<std::string, std::optional<FileChangeType>> indexing_; //!< paths being indexed, with any change since
+	size_t active_ = 0;       //!< files being indexed right now
+	size_t drainers_ = 0;     //!< indexing tasks submitted or running
+	size_t concurrency_ = 1;  //!< maximum of drainers_
+	size_t interactive_ = 0;  //!< interactive requests being served
+	size_t done_ = 0;         //!< files indexed in the current batch
+	size_t total_ = 0;        //!< files queued in the current batch
+	std::chrono::steady_clock::time_point lastReport_;
+	bool stop_ = false;
+
+	std::mutex throttleMutex_;
+	std::chrono::steady_clock::time_point throttleStart_;
+	size_t throttleBytes_ = 0;
+
+	TaskGroup tasks_;
+};
+
+}
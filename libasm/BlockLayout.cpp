@@ -0,0 +1,389 @@
+#include <libasm/BlockLayout.hpp>
+#include <libasm/Dataflow.hpp>
+#include <libasm/InstructionDefinition.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <tuple>
+#include <unordered_set>
+
+namespace asmlsp
+{
+
+namespace
+{
+	constexpr double BackEdgeProbability = 0.88;
+	constexpr double ReturnProbability = 0.28;
+	constexpr double LoopScale = 8.0;
+
+	const InstructionDefinition* terminatorOf(const BasicBlock& bb)
+	{
+		if (bb.empty())
+			return nullptr;
+		auto const* cpu = dynamic_cast<const CpuInstr*>(bb.back());
+		return cpu ? cpu->definition() : nullptr;
+	}
+
+	/** Tests whether control may continue into the next block in linear order. */
+	bool canFallThrough(const BasicBlock& bb)
+	{
+		const InstructionDefinition* def = terminatorOf(bb);
+		return !def || !(def->hasFlag(InstructionFlags::Branch) || def->hasFlag(InstructionFlags::Return));
+	}
+
+	bool endsWithJump(const BasicBlock& bb)
+	{
+		const InstructionDefinition* def = terminatorOf(bb);
+		return def && def->hasFlag(InstructionFlags::Branch);
+	}
+
+	double fallThroughWeight(const std::vector<BasicBlock*>& order, const EdgeWeights& weights)
+	{
+		double sum = 0;
+		for (size_t i = 1; i < order.size(); ++i)
+		{
+			auto const& successors = order[i - 1]->successors();
+			if (std::find(successors.begin(), successors.end(), order[i]) != successors.end())
+				sum += weights.get(order[i - 1], order[i]);
+		}
+		return sum;
+	}
+
+	size_t lineStartOf(std::string_view source, size_t offset)
+	{
+		size_t const newline = offset ? source.rfind('\n', offset - 1) : std::string_view::npos;
+		return newline == std::string_view::npos ? 0 : newline + 1;
+	}
+
+	/** Offset just past the line containing @p offset, including its newline. */
+	size_t nextLineOf(std::string_view source, size_t offset)
+	{
+		size_t const newline = source.find('\n', offset);
+		return newline == std::string_view::npos ? source.size() : newline + 1;
+	}
+
+	std::string_view indentOf(std::string_view source, size_t offset)
+	{
+		size_t const begin = lineStartOf(source, offset);
+		size_t const end = source.find_first_not_of(" \t", begin);
+		return source.substr(begin, (end == std::string_view::npos ? source.size() : end) - begin);
+	}
+
+	/** Tests whether the first line of @p text that is not blank or a comment declares the label @p name. */
+	bool startsWithLabel(std::string_view text, std::string_view name)
+	{
+		for (size_t pos = 0; pos < text.size(); pos = nextLineOf(text, pos))
+		{
+			size_t const begin = text.find_first_not_of(" \t\r", pos);
+			if (begin == std::string_view::npos)
+				return false;
+			if (text[begin] == '\n' || text[begin] == ';')
+				continue;
+
+			std::string_view const rest = text.substr(begin);
+			size_t const colon = rest.find_first_not_of(" \t", name.size());
+			return rest.substr(0, name.size()) == name && colon != std::string_view::npos && rest[colon] == ':';
+		}
+		return false;
+	}
+}
+
+// {{{ EdgeWeights
+void EdgeWeights::set(const BasicBlock* from, const BasicBlock* to, double weight)
+{
+	weights_[{from, to}] = weight;
+}
+
+void EdgeWeights::addSamples(const BasicBlock* from, const BasicBlock* to, uint64_t count)
+{
+	weights_[{from, to}] += static_cast<double>(count);
+}
+
+double EdgeWeights::get(const BasicBlock* from, const BasicBlock* to) const
+{
+	auto const i = weights_.find({from, to});
+	return i != weights_.end() ? i->second : 0.0;
+}
+
+EdgeWeights EdgeWeights::fromHeuristics(const FunctionDefinition& function)
+{
+	EdgeWeights weights;
+
+	std::vector<BasicBlock*> const order = reversePostOrder(function.entryBlock());
+	std::unordered_map<const BasicBlock*, size_t> index;
+	for (size_t i = 0; i < order.size(); ++i)
+		index[order[i]] = i;
+
+	auto const isBackEdge = [&](const BasicBlock* from, const BasicBlock* to) {
+		return index.at(to) <= index.at(from);
+	};
+
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		BasicBlock* bb = order[i];
+
+		double frequency = i == 0 ? 1.0 : 0.0;
+		bool isLoopHeader = false;
+		for (BasicBlock* pred: bb->predecessors())
+		{
+			if (!index.count(pred))
+				continue;
+			if (isBackEdge(pred, bb))
+				isLoopHeader = true;
+			else
+				frequency += weights.get(pred, bb);
+		}
+		if (isLoopHeader)
+			frequency *= LoopScale;
+
+		auto const& successors = bb->successors();
+		std::vector<double> probabilities(successors.size(), 1.0 / static_cast<double>(std::max<size_t>(1, successors.size())));
+
+		if (successors.size() == 2)
+		{
+			auto const likely = [&](size_t taken, double probability) {
+				probabilities[taken] = probability;
+				probabilities[1 - taken] = 1.0 - probability;
+			};
+
+			if (isBackEdge(bb, successors[0]) != isBackEdge(bb, successors[1]))
+				likely(isBackEdge(bb, successors[0]) ? 0 : 1, BackEdgeProbability);
+			else if (successors[0]->successors().empty() != successors[1]->successors().empty())
+				likely(successors[0]->successors().empty() ? 0 : 1, ReturnProbability);
+		}
+
+		for (size_t k = 0; k < successors.size(); ++k)
+			weights.set(bb, successors[k], frequency * probabilities[k]);
+	}
+
+	return weights;
+}
+// }}}
+
+// {{{ BlockLayout
+LayoutProposal BlockLayout::compute(const FunctionDefinition& function, const EdgeWeights& weights)
+{
+	LayoutProposal proposal;
+
+	std::vector<BasicBlock*> original;
+	for (auto const& bb: function.basicBlocks())
+		original.push_back(bb.get());
+
+	size_t const count = original.size();
+	if (count == 0)
+		return proposal;
+
+	std::unordered_map<const BasicBlock*, size_t> position;
+	for (size_t i = 0; i < count; ++i)
+		position[original[i]] = i;
+
+	struct Edge
+	{
+		size_t from;
+		size_t to;
+		double weight;
+	};
+
+	std::vector<Edge> edges;
+	for (size_t i = 0; i < count; ++i)
+		for (BasicBlock* succ: original[i]->successors())
+			if (auto const p = position.find(succ); p != position.end() && p->second != i && p->second != 0)
+				edges.push_back(Edge{i, p->second, weights.get(original[i], succ)});
+
+	std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.weight > b.weight; });
+
+	// Chains as linked lists, with head and tail kept at the union-find root.
+	std::vector<size_t> parent(count), head(count), tail(count), next(count, count), size(count, 1);
+	std::iota(parent.begin(), parent.end(), 0);
+	std::iota(head.begin(), head.end(), 0);
+	std::iota(tail.begin(), tail.end(), 0);
+
+	auto const find = [&](size_t x) {
+		while (parent[x] != x)
+			x = parent[x] = parent[parent[x]];
+		return x;
+	};
+
+	for (Edge const& edge: edges)
+	{
+		if (edge.weight <= 0)
+			break;
+
+		size_t a = find(edge.from);
+		size_t b = find(edge.to);
+		if (a == b || tail[a] != edge.from || head[b] != edge.to)
+			continue;
+
+		next[edge.from] = edge.to;
+		size_t const h = head[a];
+		size_t const t = tail[b];
+		if (size[a] < size[b])
+			std::swap(a, b);
+		parent[b] = a;
+		size[a] += size[b];
+		head[a] = h;
+		tail[a] = t;
+	}
+
+	// Place chains, entry chain first, then by connection strength to what is placed.
+	std::vector<bool> placed(count, false);
+	std::vector<double> connection(count, 0.0);
+	using Candidate = std::tuple<double, long, size_t>; // (strength, -position of head, chain root)
+	std::priority_queue<Candidate> candidates;
+
+	for (size_t i = 0; i < count; ++i)
+		if (find(i) == i)
+			candidates.emplace(0.0, -static_cast<long>(head[i]), i);
+
+	auto const place = [&](size_t root) {
+		placed[root] = true;
+		for (size_t block = head[root]; block != count; block = next[block])
+		{
+			proposal.order.push_back(original[block]);
+			auto const connect = [&](const BasicBlock* other, double weight) {
+				size_t const r = find(position.at(other));
+				if (!placed[r] && weight > 0)
+				{
+					connection[r] += weight;
+					candidates.emplace(connection[r], -static_cast<long>(head[r]), r);
+				}
+			};
+			for (BasicBlock* succ: original[block]->successors())
+				if (position.count(succ))
+					connect(succ, weights.get(original[block], succ));
+			for (BasicBlock* pred: original[block]->predecessors())
+				if (position.count(pred))
+					connect(pred, weights.get(pred, original[block]));
+		}
+	};
+
+	place(find(0));
+	while (!candidates.empty())
+	{
+		auto const [strength, negativeHead, root] = candidates.top();
+		candidates.pop();
+		if (!placed[root] && strength == connection[root])
+			place(root);
+	}
+
+	proposal.fallThroughBefore = fallThroughWeight(original, weights);
+	proposal.fallThroughAfter = fallThroughWeight(proposal.order, weights);
+
+	// Determine the jumps to insert or remove when rewriting the source.
+	for (size_t i = 0; i < count; ++i)
+	{
+		BasicBlock* bb = proposal.order[i];
+		BasicBlock* nextInLayout = i + 1 < count ? proposal.order[i + 1] : nullptr;
+		size_t const originalPosition = position.at(bb);
+		BasicBlock* fallThrough = originalPosition + 1 < count ? original[originalPosition + 1] : nullptr;
+		auto const& successors = bb->successors();
+
+		if (canFallThrough(*bb) && fallThrough
+			&& std::find(successors.begin(), successors.end(), fallThrough) != successors.end()
+			&& nextInLayout != fallThrough)
+			proposal.fixups.push_back({LayoutProposal::Fixup::InsertJump, bb, fallThrough});
+		else if (endsWithJump(*bb) && successors.size() == 1 && nextInLayout == successors.front())
+			proposal.fixups.push_back({LayoutProposal::Fixup::RemoveJump, bb, successors.front()});
+	}
+
+	return proposal;
+}
+
+std::vector<TextEdit> BlockLayout::edits(const FunctionDefinition& function, const LayoutProposal& proposal,
+										 std::string_view source)
+{
+	std::vector<BasicBlock*> original;
+	for (auto const& bb: function.basicBlocks())
+		original.push_back(bb.get());
+
+	size_t const count = original.size();
+	if (count == 0 || proposal.order.size() != count || proposal.order == original)
+		return {};
+
+	// Split the function's source into the text of each block.
+	std::unordered_map<const BasicBlock*, SourceRange> textOf;
+	for (size_t i = 0; i < count; ++i)
+	{
+		SourceRange const range = original[i]->sourceRange();
+		if (range.empty() || range.end > source.size())
+			return {};
+		size_t const begin = lineStartOf(source, range.begin);
+		if (i > 0 && begin <= textOf.at(original[i - 1]).begin)
+			return {}; // blocks out of source order
+		textOf[original[i]] = SourceRange{begin, nextLineOf(source, range.end - 1)};
+		if (i > 0)
+			textOf.at(original[i - 1]).end = begin;
+	}
+	SourceRange const whole{textOf.at(original.front()).begin, textOf.at(original.back()).end};
+
+	std::unordered_map<const BasicBlock*, const LayoutProposal::Fixup*> fixupOf;
+	std::unordered_set<const BasicBlock*> jumpTargets;
+	for (LayoutProposal::Fixup const& fixup: proposal.fixups)
+	{
+		fixupOf[fixup.block] = &fixup;
+		if (fixup.kind == LayoutProposal::Fixup::InsertJump)
+		{
+			if (fixup.target->name().empty())
+				return {};
+			jumpTargets.insert(fixup.target);
+		}
+	}
+
+	std::string text;
+	for (BasicBlock* bb: proposal.order)
+	{
+		SourceRange const range = textOf.at(bb);
+		std::string_view const block = source.substr(range.begin, range.length());
+		if (jumpTargets.count(bb) && !startsWithLabel(block, bb->name()))
+			text += bb->name() + ":\n";
+
+		auto const i = fixupOf.find(bb);
+		if (i == fixupOf.end())
+		{
+			text += block;
+			if (!text.empty() && text.back() != '\n')
+				text += '\n';
+			continue;
+		}
+
+		// The jump goes right after the block's last instruction, ahead of
+		// any comments leading into the next block.
+		SourceRange const last = bb->empty() ? SourceRange{} : bb->back()->sourceRange();
+		if (!bb->empty() && last.empty())
+			return {};
+		size_t const lineBegin = bb->empty() ? block.size() : lineStartOf(source, last.begin) - range.begin;
+		size_t const lineEnd = bb->empty() ? block.size() : nextLineOf(source, last.end - 1) - range.begin;
+
+		if (i->second->kind == LayoutProposal::Fixup::RemoveJump)
+		{
+			text += block.substr(0, lineBegin);
+			text += block.substr(lineEnd);
+		}
+		else
+		{
+			text += block.substr(0, lineEnd);
+			if (!text.empty() && text.back() != '\n')
+				text += '\n';
+			text += std::string(bb->empty() ? std::string_view{"\t"} : indentOf(source, last.begin)) + "jmp "
+					+ i->second->target->name() + "\n";
+			text += block.substr(lineEnd);
+		}
+		if (!text.empty() && text.back() != '\n')
+			text += '\n';
+	}
+
+	if (source[whole.end - 1] != '\n' && !text.empty() && text.back() == '\n')
+		text.pop_back(); // the function ends the source without a newline
+
+	return {TextEdit{whole, std::move(text)}};
+}
+
+void BlockLayout::apply(const LayoutProposal& proposal)
+{
+	for (size_t i = 1; i < proposal.order.size(); ++i)
+		proposal.order[i]->moveAfter(proposal.order[i - 1]);
+}
+// }}}
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <libasm/SSA.hpp>
+#include <libasm/SourceLocation.hpp>
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Execution frequencies of the CFG edges of a function.
+ *
+ * Weights either come from an ingested profile (e.g. perf branch records
+ * mapped to basic blocks) or are estimated by static branch heuristics.
+ */
+class EdgeWeights
+{
+public:
+	void set(const BasicBlock* from, const BasicBlock* to, double weight);
+
+	/** Accumulates @p count samples of the branch from @p from to @p to. */
+	void addSamples(const BasicBlock* from, const BasicBlock* to, uint64_t count);
+
+	double get(const BasicBlock* from, const BasicBlock* to) const;
+
+	bool empty() const noexcept { return weights_.empty(); }
+
+	/**
+	 * Estimates edge frequencies from the CFG structure alone.
+	 *
+	 * Back edges are taken with a probability of 88%, branches to blocks that
+	 * merely return are assumed unlikely, and loop headers execute 8 times as
+	 * often as their loop's entry.
+	 */
+	static EdgeWeights fromHeuristics(const FunctionDefinition& function);
+
+private:
+	struct EdgeHash
+	{
+		size_t operator()(const std::pair<const BasicBlock*, const BasicBlock*>& edge) const noexcept
+		{
+			return std::hash<const void*>()(edge.first) * 31 ^ std::hash<const void*>()(edge.second);
+		}
+	};
+
+	std::unordered_map<std::pair<const BasicBlock*, const BasicBlock*>, double, EdgeHash> weights_;
+};
+
+/**
+ * A proposed linear order of a function's basic blocks.
+ */
+struct LayoutProposal
+{
+	/**
+	 * Source edit needed to keep the semantics when reordering a block.
+	 */
+	struct Fixup
+	{
+		enum Kind
+		{
+			InsertJump, //!< block used to fall through to target, which is no longer next
+			RemoveJump, //!< block ends with a jmp to target, which is now next
+		};
+
+		Kind kind;
+		BasicBlock* block;
+		BasicBlock* target;
+	};
+
+	std::vector<BasicBlock*> order;  //!< new linear order, entry block first
+	std::vector<Fixup> fixups;
+	double fallThroughBefore = 0;    //!< summed weight of fall-through edges in the current order
+	double fallThroughAfter = 0;     //!< summed weight of fall-through edges in the proposed order
+
+	/** Tests whether applying the proposal is worthwhile. */
+	bool isImprovement() const noexcept { return fallThroughAfter > fallThroughBefore; }
+};
+
+/**
+ * Chooses a basic block order that maximizes fall-through on hot paths.
+ *
+ * Implements Pettis-Hansen style bottom-up chain merging: edges are visited
+ * by descending weight, and the chains ending in the edge's source and
+ * starting with its target are concatenated. The resulting chains are placed
+ * entry chain first, followed by the chain most strongly connected to the
+ * already placed ones. Runs in O(E log E), which is fine for functions with
+ * tens of thousands of blocks.
+ *
+ * edits() turns a proposal into the source rewrite a code action offers.
+ */
+class BlockLayout
+{
+public:
+	static LayoutProposal compute(const FunctionDefinition& function, const EdgeWeights& weights);
+
+	/**
+	 * Rewrites @p source to the block order of @p proposal.
+	 *
+	 * Each block's text reaches from the line of its source range's start up
+	 * to the next block, so comments and blank lines move with the block
+	 * before them. Blocks that lost their fall-through get a jmp to it,
+	 * labelled with the target block's name if it had no label, and jumps to
+	 * what is now the next block are dropped.
+	 *
+	 * @returns a single edit replacing the function's blocks, or none if the
+	 *          order is unchanged or a block has no source range
+	 */
+	static std::vector<TextEdit> edits(const FunctionDefinition& function, const LayoutProposal& proposal,
+									   std::string_view source);
+
+	/**
+	 * Reorders the basic blocks of the IR according to @p proposal.
+	 */
+	static void apply(const LayoutProposal& proposal);
+};
+
+}
@@ -0,0 +1,279 @@
+#include <libasm/CodeLens.hpp>
+#include <libasm/Dataflow.hpp>
+#include <libasm/StackAnalysis.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_set>
+
+namespace asmlsp
+{
+
+namespace
+{
+	struct Loop
+	{
+		BasicBlock* header;
+		std::vector<BasicBlock*> latches;
+		std::vector<BasicBlock*> body; //!< in reverse post order, header first
+		unsigned depth = 0;
+	};
+
+	/** Natural loops of the function, one per header, given its reverse post order. */
+	std::vector<Loop> findLoops(const std::vector<BasicBlock*>& order, const std::unordered_map<const BasicBlock*, size_t>& rpo)
+	{
+		std::vector<Loop> loops;
+		std::unordered_map<const BasicBlock*, size_t> loopOf;
+
+		for (BasicBlock* bb: order)
+		{
+			for (BasicBlock* succ: bb->successors())
+			{
+				if (!rpo.count(succ) || rpo.at(succ) > rpo.at(bb))
+					continue;
+				auto [i, inserted] = loopOf.try_emplace(succ, loops.size());
+				if (inserted)
+					loops.push_back(Loop{succ, {}, {}, 0});
+				loops[i->second].latches.push_back(bb);
+			}
+		}
+
+		for (Loop& loop: loops)
+		{
+			std::unordered_set<const BasicBlock*> inLoop{loop.header};
+			std::vector<BasicBlock*> work(loop.latches.begin(), loop.latches.end());
+			while (!work.empty())
+			{
+				BasicBlock* bb = work.back();
+				work.pop_back();
+				if (!inLoop.insert(bb).second)
+					continue;
+				for (BasicBlock* pred: bb->predecessors())
+					if (rpo.count(pred))
+						work.push_back(pred);
+			}
+
+			for (BasicBlock* bb: order)
+				if (inLoop.count(bb))
+					loop.body.push_back(bb);
+		}
+
+		for (Loop& loop: loops)
+			for (Loop const& outer: loops)
+				if (std::find(outer.body.begin(), outer.body.end(), loop.header) != outer.body.end())
+					++loop.depth;
+
+		return loops;
+	}
+}
+
+FunctionSummary FunctionSummaries::summarize(const FunctionDefinition& function) const
+{
+	FunctionSummary summary;
+	BasicBlock* entry = function.entryBlock();
+	if (!entry)
+		return summary;
+
+	struct Cost
+	{
+		double latency;
+		double throughput;
+	};
+	auto const costOf = [&](const CpuInstr& instr) {
+		if (instr.definition())
+			if (auto const timing = docs_.timing(instr.definition()->id(), uarch_))
+				return Cost{static_cast<double>(timing->latency), timing->reciprocalThroughput()};
+		return Cost{1, 1};
+	};
+
+	// {{{ hottest loop
+	std::vector<BasicBlock*> const order = reversePostOrder(entry);
+	std::unordered_map<const BasicBlock*, size_t> rpo;
+	for (size_t i = 0; i < order.size(); ++i)
+		rpo[order[i]] = i;
+
+	std::unordered_map<const BasicBlock*, size_t> blockIndex;
+	for (size_t i = 0; i < function.basicBlocks().size(); ++i)
+		blockIndex[function.basicBlocks()[i].get()] = i;
+
+	unsigned hottestDepth = 0;
+	for (Loop const& loop: findLoops(order, rpo))
+	{
+		double throughput = 0;
+		for (BasicBlock* bb: loop.body)
+			for (auto const& instr: bb->instructions())
+				if (auto const* cpu = dynamic_cast<const CpuInstr*>(instr.get()))
+					throughput += costOf(*cpu).throughput;
+
+		// longest chain from a header phi to its value coming back around the loop
+		double recurrence = 0;
+		size_t const skip = loop.header == entry ? 1 : 0;
+		for (auto const& headerInstr: loop.header->instructions())
+		{
+			auto const* phi = dynamic_cast<const PhiNode*>(headerInstr.get());
+			if (!phi)
+				continue;
+
+			std::unordered_map<const Value*, double> distance{{phi, 0.0}};
+			for (BasicBlock* bb: loop.body)
+			{
+				for (auto const& instr: bb->instructions())
+				{
+					if (instr.get() == phi || (bb == loop.header && dynamic_cast<const PhiNode*>(instr.get())))
+						continue;
+
+					std::optional<double> longest;
+					for (Value const* operand: instr->operands())
+						if (auto const d = distance.find(operand); d != distance.end())
+							longest = std::max(longest.value_or(0.0), d->second);
+					if (!longest)
+						continue;
+
+					auto const* cpu = dynamic_cast<const CpuInstr*>(instr.get());
+					distance[instr.get()] = *longest + (cpu ? costOf(*cpu).latency : 0.0);
+				}
+			}
+
+			auto const& predecessors = loop.header->predecessors();
+			for (size_t n = 0; n < predecessors.size() && n + skip < phi->operands().size(); ++n)
+				if (std::find(loop.latches.begin(), loop.latches.end(), predecessors[n]) != loop.latches.end())
+					if (auto const d = distance.find(phi->operand(n + skip)); d != distance.end())
+						recurrence = std::max(recurrence, d->second);
+		}
+
+		double const cycles = std::max(throughput, recurrence);
+		if (loop.depth > hottestDepth || (loop.depth == hottestDepth && cycles > summary.loopCycles))
+		{
+			hottestDepth = loop.depth;
+			summary.hottestLoop = blockIndex.at(loop.header);
+			summary.loopCycles = cycles;
+		}
+	}
+	// }}}
+
+	// {{{ clobbered registers and extensions
+	std::unordered_map<unsigned, Register> written;
+	std::unordered_set<unsigned> pushed;
+	std::unordered_set<unsigned> popped;
+	std::vector<bool> extensions;
+
+	for (auto const& bb: function.basicBlocks())
+	{
+		for (auto const& instr: bb->instructions())
+		{
+			auto const* cpu = dynamic_cast<const CpuInstr*>(instr.get());
+			if (!cpu || !cpu->definition())
+				continue;
+
+			std::string const& mnemonic = cpu->definition()->mnemonic();
+			if (mnemonic == "push" && !cpu->operandRegisters().empty() && cpu->operandRegisters().front())
+				pushed.insert(cpu->operandRegisters().front().family());
+			if (mnemonic == "pop" && !cpu->outputRegisters().empty())
+				popped.insert(cpu->outputRegisters().front().family());
+
+			for (Register const reg: cpu->outputRegisters())
+			{
+				auto [i, inserted] = written.try_emplace(reg.family(), reg);
+				if (!inserted && reg.width() > i->second.width())
+					i->second = reg;
+			}
+
+			auto const extension = static_cast<size_t>(cpu->definition()->extension());
+			if (extension >= extensions.size())
+				extensions.resize(extension + 1);
+			extensions[extension] = true;
+		}
+	}
+
+	Register const rsp = *Register::parse("rsp");
+	for (auto const& [family, reg]: written)
+		if (family != rsp.family() && !(pushed.count(family) && popped.count(family)))
+			summary.clobbered.push_back(reg);
+	std::sort(summary.clobbered.begin(), summary.clobbered.end(),
+			  [](Register a, Register b) { return a.family() < b.family(); });
+
+	for (size_t i = 1; i < extensions.size(); ++i)
+		if (extensions[i])
+			summary.extensions.push_back(static_cast<Extension>(i));
+	// }}}
+
+	summary.frameSize = frameSize(stackOffsets(function));
+	return summary;
+}
+
+const FunctionSummary& FunctionSummaries::summaryOf(const FunctionDefinition& function, std::optional<uint64_t> contentHash)
+{
+	auto const i = summaries_.find(&function);
+	if (i != summaries_.end())
+		return *i->second;
+
+	std::shared_ptr<const FunctionSummary> summary;
+	if (shared_ && contentHash)
+		summary = shared_->getOrCompute<FunctionSummary>(hashCombine(*contentHash, static_cast<uint64_t>(uarch_)),
+														 [&]() { return summarize(function); });
+	else
+		summary = std::make_shared<const FunctionSummary>(summarize(function));
+
+	return *summaries_.emplace(&function, std::move(summary)).first->second;
+}
+
+std::vector<CodeLens> codeLenses(const std::vector<std::unique_ptr<FunctionDefinition>>& functions, const PositionIndex& index)
+{
+	std::vector<CodeLens> lenses;
+	for (auto const& function: functions)
+	{
+		if (function->sourceRange().empty())
+			continue;
+		SourceRange const range = index.currentRange(function->sourceRange());
+		lenses.push_back(CodeLens{SourceRange{range.begin, std::min(range.end, range.begin + function->name().size())},
+								  function.get(), std::nullopt, std::nullopt});
+	}
+	return lenses;
+}
+
+void resolve(CodeLens& lens, FunctionSummaries& summaries, std::string_view source, const PositionIndex& index)
+{
+	if (lens.title || !lens.function)
+		return;
+
+	if (!lens.contentHash)
+	{
+		SourceRange const range = index.currentRange(lens.function->sourceRange());
+		if (range.begin <= range.end && range.end <= source.size())
+			lens.contentHash = normalizedHash(source.substr(range.begin, range.length()));
+	}
+	lens.title = formatSummary(summaries.summaryOf(*lens.function, lens.contentHash), *lens.function);
+}
+
+std::string formatSummary(const FunctionSummary& summary, const FunctionDefinition& function)
+{
+	std::string title;
+	if (summary.hottestLoop && *summary.hottestLoop < function.basicBlocks().size())
+	{
+		char cycles[32];
+		std::snprintf(cycles, sizeof(cycles), "~%.1f", summary.loopCycles);
+		title = std::string(cycles) + " cycles/iter in " + function.basicBlocks()[*summary.hottestLoop]->name();
+	}
+	else
+		title = "no loops";
+
+	title += " | clobbers ";
+	if (summary.clobbered.empty())
+		title += "nothing";
+	for (size_t i = 0; i < summary.clobbered.size(); ++i)
+		title += (i ? ", " : "") + summary.clobbered[i].name();
+
+	if (summary.frameSize && *summary.frameSize > 0)
+		title += " | frame " + std::to_string(*summary.frameSize) + " bytes";
+
+	if (!summary.extensions.empty())
+	{
+		title += " | ";
+		for (size_t i = 0; i < summary.extensions.size(); ++i)
+			title += (i ? ", " : "") + std::string(nameOf(summary.extensions[i]));
+	}
+
+	return title;
+}
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <libasm/ContentCache.hpp>
+#include <libasm/InstructionDefinition.hpp>
+#include <libasm/InstructionDocs.hpp>
+#include <libasm/Microarchitecture.hpp>
+#include <libasm/PositionIndex.hpp>
+#include <libasm/Register.hpp>
+#include <libasm/SSA.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Performance relevant facts about a function, as shown in its code lens.
+ */
+struct FunctionSummary
+{
+	std::optional<size_t> hottestLoop;       //!< index of the innermost, most expensive loop's header in basicBlocks()
+	double loopCycles = 0;                   //!< estimated cycles per iteration of hottestLoop
+	std::vector<Register> clobbered;         //!< registers written and not restored, widest name per register
+	std::optional<int64_t> frameSize;        //!< bytes allocated on the stack
+	std::vector<Extension> extensions;       //!< ISA extensions used, besides the base instruction set
+};
+
+/**
+ * Per function cache of FunctionSummary, computed on first request.
+ *
+ * A loop's cycles per iteration are estimated as the larger of its
+ * reciprocal throughputs summed up and its longest loop carried dependency
+ * chain, from the timings of @p uarch. Instructions without timings count
+ * as one cycle of latency and throughput. Without profile data, the hottest
+ * loop is the most deeply nested one, ties broken by cycles.
+ *
+ * Summaries refer to nothing document specific, so with a ContentCache,
+ * functions of identical normalizedHash() share a single summary across
+ * all documents.
+ */
+class FunctionSummaries
+{
+public:
+	FunctionSummaries(const InstructionDocs& docs, Microarchitecture uarch, ContentCache* shared = nullptr):
+		docs_{docs}, uarch_{uarch}, shared_{shared} {}
+
+	/**
+	 * Retrieves the summary of @p function, looking it up in the shared
+	 * ContentCache by @p contentHash if given.
+	 */
+	const FunctionSummary& summaryOf(const FunctionDefinition& function, std::optional<uint64_t> contentHash = std::nullopt);
+
+	bool contains(const FunctionDefinition& function) const { return summaries_.count(&function) != 0; }
+
+	void invalidate(const FunctionDefinition& function) { summaries_.erase(&function); }
+
+	void clear() { summaries_.clear(); }
+
+private:
+	FunctionSummary summarize(const FunctionDefinition& function) const;
+
+	const InstructionDocs& docs_;
+	Microarchitecture uarch_;
+	ContentCache* shared_;
+	std::unordered_map<const FunctionDefinition*, std::shared_ptr<const FunctionSummary>> summaries_;
+};
+
+/**
+ * A code lens on a function's label, modelled after LSP's CodeLens.
+ *
+ * Lenses are listed unresolved, which is cheap, and only get their title
+ * once the client resolves the visible ones.
+ */
+struct CodeLens
+{
+	SourceRange range;                   //!< the function's name at its label
+	const FunctionDefinition* function;  //!< identifies the function when resolving
+	std::optional<uint64_t> contentHash; //!< normalizedHash() of the function, if known
+	std::optional<std::string> title;
+};
+
+/**
+ * Lists the unresolved code lenses of @p functions.
+ */
+std::vector<CodeLens> codeLenses(const std::vector<std::unique_ptr<FunctionDefinition>>& functions, const PositionIndex& index);
+
+/**
+ * Fills in the title of @p lens from its function's summary, such as
+ * "~3.5 cycles/iter in .loop | clobbers rax, rcx | frame 32 bytes | AVX2, FMA".
+ *
+ * Hashes the function's text in @p source, the current text @p index maps
+ * into, so that the summary is shared through the ContentCache.
+ */
+void resolve(CodeLens& lens, FunctionSummaries& summaries, std::string_view source, const PositionIndex& index);
+
+/**
+ * Renders the title of a code lens for @p summary of @p function.
+ */
+std::string formatSummary(const FunctionSummary& summary, const FunctionDefinition& function);
+
+}
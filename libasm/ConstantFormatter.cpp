@@ -0,0 +1,99 @@
+#include <libasm/ConstantFormatter.hpp>
+
+#include <charconv>
+#include <cstdio>
+
+namespace asmlsp
+{
+
+namespace
+{
+	template <typename T>
+	std::string formatFloat(T value)
+	{
+		char buf[64];
+		auto const result = std::to_chars(buf, buf + sizeof(buf), value);
+		return std::string(buf, result.ptr);
+	}
+
+	std::string formatHex(uint64_t value, unsigned digits)
+	{
+		char buf[24];
+		std::snprintf(buf, sizeof(buf), "0x%0*llx", static_cast<int>(digits), static_cast<unsigned long long>(value));
+		return buf;
+	}
+
+	template <typename T, size_t Bits, typename Format>
+	std::string formatLanes(const VectorBits<Bits>& vector, Format format)
+	{
+		size_t const count = VectorBits<Bits>::Size / sizeof(T);
+
+		bool uniform = true;
+		for (size_t i = 1; i < count && uniform; ++i)
+			uniform = vector.template lane<T>(i) == vector.template lane<T>(0);
+
+		if (uniform)
+			return std::to_string(count) + " x " + format(vector.template lane<T>(0));
+
+		std::string text = "{";
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (i)
+				text += ", ";
+			text += format(vector.template lane<T>(i));
+		}
+		text += '}';
+		return text;
+	}
+
+	template <size_t Bits>
+	std::string formatVector(const VectorBits<Bits>& vector, LaneFormat lanes)
+	{
+		switch (lanes)
+		{
+			case LaneFormat::Hex8:
+				return formatLanes<uint8_t>(vector, [](uint8_t v) { return formatHex(v, 2); });
+			case LaneFormat::Hex16:
+				return formatLanes<uint16_t>(vector, [](uint16_t v) { return formatHex(v, 4); });
+			case LaneFormat::Hex32:
+				return formatLanes<uint32_t>(vector, [](uint32_t v) { return formatHex(v, 8); });
+			case LaneFormat::Hex64:
+				return formatLanes<uint64_t>(vector, [](uint64_t v) { return formatHex(v, 16); });
+			case LaneFormat::Float32:
+				return formatLanes<float>(vector, [](float v) { return formatFloat(v); });
+			case LaneFormat::Float64:
+				return formatLanes<double>(vector, [](double v) { return formatFloat(v); });
+		}
+		return {};
+	}
+}
+
+std::string formatConstant(const Constant& constant, LaneFormat lanes)
+{
+	switch (constant.type())
+	{
+		case LiteralType::Int:
+			return std::to_string(static_cast<const ConstantInt&>(constant).get());
+		case LiteralType::UInt:
+		{
+			uint64_t const value = static_cast<const ConstantUInt&>(constant).get();
+			return value < 10 ? std::to_string(value) : std::to_string(value) + " (" + formatHex(value, 0) + ")";
+		}
+		case LiteralType::Float32:
+			return formatFloat(static_cast<const ConstantFloat32&>(constant).get());
+		case LiteralType::Float64:
+			return formatFloat(static_cast<const ConstantFloat64&>(constant).get());
+		case LiteralType::Vector128:
+			return formatVector(static_cast<const ConstantVector128&>(constant).value(), lanes);
+		case LiteralType::Vector256:
+			return formatVector(static_cast<const ConstantVector256&>(constant).value(), lanes);
+		case LiteralType::Vector512:
+			return formatVector(static_cast<const ConstantVector512&>(constant).value(), lanes);
+		case LiteralType::String:
+		case LiteralType::Void:
+			break;
+	}
+	return constant.name();
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <libasm/SSA.hpp>
+
+#include <string>
+
+namespace asmlsp
+{
+
+/**
+ * Lane interpretation used when rendering vector constants.
+ */
+enum class LaneFormat
+{
+	Hex8,
+	Hex16,
+	Hex32,
+	Hex64,
+	Float32,
+	Float64,
+};
+
+/**
+ * Renders the given constant for hover previews.
+ *
+ * Vectors are rendered lane by lane, or as "16 x 0x80" if all lanes are equal.
+ */
+std::string formatConstant(const Constant& constant, LaneFormat lanes = LaneFormat::Hex8);
+
+}
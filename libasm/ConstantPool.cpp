@@ -0,0 +1,140 @@
+#include <libasm/ConstantPool.hpp>
+
+#include <cstring>
+
+namespace asmlsp
+{
+
+namespace
+{
+	constexpr size_t InitialCapacity = 64; // must be a power of two
+
+	uint64_t mix(uint64_t x) noexcept
+	{
+		// splitmix64 finalizer, spreading small immediates over the whole table
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+	uint64_t hashOf(LiteralType type, uint64_t key) noexcept
+	{
+		return mix(key + 0x9E3779B97F4A7C15ull * (static_cast<uint64_t>(type) + 1));
+	}
+
+	template <size_t Bits>
+	uint64_t contentHashOf(const VectorBits<Bits>& value) noexcept
+	{
+		uint64_t hash = 0;
+		for (size_t i = 0; i < VectorBits<Bits>::Size / 8; ++i)
+			hash = mix(hash ^ value.template lane<uint64_t>(i));
+		return hash;
+	}
+
+	template <typename T>
+	uint64_t bitsOf(T value) noexcept
+	{
+		uint64_t bits = 0;
+		std::memcpy(&bits, &value, sizeof(T));
+		return bits;
+	}
+}
+
+ConstantPool::ConstantPool(): slots_(InitialCapacity)
+{
+}
+
+ConstantInt* ConstantPool::getInt(int64_t value)
+{
+	return getOrCreate(LiteralType::Int, bitsOf(value), value, ints_);
+}
+
+ConstantUInt* ConstantPool::getUInt(uint64_t value)
+{
+	return getOrCreate(LiteralType::UInt, value, value, uints_);
+}
+
+ConstantFloat32* ConstantPool::getFloat32(float value)
+{
+	return getOrCreate(LiteralType::Float32, bitsOf(value), value, floats32_);
+}
+
+ConstantFloat64* ConstantPool::getFloat64(double value)
+{
+	return getOrCreate(LiteralType::Float64, bitsOf(value), value, floats64_);
+}
+
+ConstantVector128* ConstantPool::getVector(const VectorBits<128>& value)
+{
+	return getOrCreate(LiteralType::Vector128, contentHashOf(value), value, vectors128_);
+}
+
+ConstantVector256* ConstantPool::getVector(const VectorBits<256>& value)
+{
+	return getOrCreate(LiteralType::Vector256, contentHashOf(value), value, vectors256_);
+}
+
+ConstantVector512* ConstantPool::getVector(const VectorBits<512>& value)
+{
+	return getOrCreate(LiteralType::Vector512, contentHashOf(value), value, vectors512_);
+}
+
+void ConstantPool::clear()
+{
+	slots_.assign(InitialCapacity, Slot{});
+	size_ = 0;
+	ints_.clear();
+	uints_.clear();
+	floats32_.clear();
+	floats64_.clear();
+	vectors128_.clear();
+	vectors256_.clear();
+	vectors512_.clear();
+}
+
+template <typename T, typename V>
+T* ConstantPool::getOrCreate(LiteralType type, uint64_t key, const V& value, std::deque<T>& storage)
+{
+	// Scalars are keyed by their exact bit pattern, vectors by a hash of their contents.
+	constexpr bool exactKey = sizeof(V) <= sizeof(uint64_t);
+
+	size_t const mask = slots_.size() - 1;
+	for (size_t i = hashOf(type, key) & mask; slots_[i].constant; i = (i + 1) & mask)
+	{
+		Slot const& slot = slots_[i];
+		if (slot.type == type && slot.key == key)
+			if (exactKey || static_cast<T*>(slot.constant)->value() == value)
+				return static_cast<T*>(slot.constant);
+	}
+
+	// keep the load factor at or below 1/2
+	if ((size_ + 1) * 2 > slots_.size())
+		grow();
+
+	T* constant = &storage.emplace_back(value);
+	Slot& slot = emptySlotFor(hashOf(type, key));
+	slot = Slot{key, type, constant};
+	++size_;
+	return constant;
+}
+
+ConstantPool::Slot& ConstantPool::emptySlotFor(uint64_t hash)
+{
+	size_t const mask = slots_.size() - 1;
+	size_t i = hash & mask;
+	while (slots_[i].constant)
+		i = (i + 1) & mask;
+	return slots_[i];
+}
+
+void ConstantPool::grow()
+{
+	std::vector<Slot> old(slots_.size() * 2);
+	old.swap(slots_);
+
+	for (Slot const& slot: old)
+		if (slot.constant)
+			emptySlotFor(hashOf(slot.type, slot.key)) = slot;
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <libasm/SSA.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Uniquing pool of the constants of a module.
+ *
+ * Each distinct (LiteralType, value) pair is materialized at most once, so
+ * that constants can be compared by pointer (e.g. for value numbering), and
+ * immediates that are repeated thousands of times share one object.
+ * Floating point constants are uniqued by their bit pattern, so that 0.0
+ * and -0.0 as well as different NaN payloads remain distinct.
+ *
+ * Lookups go through a flat open-addressing hash table with linear probing,
+ * the constants themselves are allocated in chunks and never move.
+ */
+class ConstantPool
+{
+public:
+	ConstantPool();
+
+	ConstantPool(const ConstantPool&) = delete;
+	ConstantPool& operator=(const ConstantPool&) = delete;
+
+	/** Retrieves the unique signed integer constant of the given value. */
+	ConstantInt* getInt(int64_t value);
+
+	/** Retrieves the unique unsigned integer constant of the given value. */
+	ConstantUInt* getUInt(uint64_t value);
+
+	ConstantFloat32* getFloat32(float value);
+	ConstantFloat64* getFloat64(double value);
+
+	ConstantVector128* getVector(const VectorBits<128>& value);
+	ConstantVector256* getVector(const VectorBits<256>& value);
+	ConstantVector512* getVector(const VectorBits<512>& value);
+
+	/** Number of distinct constants in this pool. */
+	size_t size() const noexcept { return size_; }
+
+	/**
+	 * Destroys all constants.
+	 *
+	 * No instruction may reference any of them anymore.
+	 */
+	void clear();
+
+private:
+	struct Slot
+	{
+		uint64_t key = 0;             //!< scalar bit pattern, or content hash of vectors
+		LiteralType type = LiteralType::Void;
+		Constant* constant = nullptr; //!< nullptr denotes an empty slot
+	};
+
+	template <typename T, typename V>
+	T* getOrCreate(LiteralType type, uint64_t key, const V& value, std::deque<T>& storage);
+
+	Slot& emptySlotFor(uint64_t hash);
+	void grow();
+
+	std::vector<Slot> slots_;
+	size_t size_ = 0;
+
+	std::deque<ConstantInt> ints_;
+	std::deque<ConstantUInt> uints_;
+	std::deque<ConstantFloat32> floats32_;
+	std::deque<ConstantFloat64> floats64_;
+	std::deque<ConstantVector128> vectors128_;
+	std::deque<ConstantVector256> vectors256_;
+	std::deque<ConstantVector512> vectors512_;
+};
+
+}
@@ -0,0 +1,172 @@
+#include <libasm/ContentCache.hpp>
+#include <libasm/Parser.hpp>
+
+#include <string>
+#include <unordered_map>
+
+namespace asmlsp
+{
+
+namespace
+{
+	class Fnv1a
+	{
+	public:
+		void add(std::string_view text) noexcept
+		{
+			for (char const ch: text)
+				hash_ = (hash_ ^ static_cast<uint8_t>(ch)) * 0x100000001b3;
+		}
+
+		void add(char ch) noexcept { hash_ = (hash_ ^ static_cast<uint8_t>(ch)) * 0x100000001b3; }
+
+		uint64_t value() const noexcept { return hash_; }
+
+	private:
+		uint64_t hash_ = 0xcbf29ce484222325;
+	};
+}
+
+uint64_t normalizedHash(std::string_view functionText)
+{
+	Fnv1a hash;
+	std::unordered_map<std::string, size_t> localLabels;
+	std::string entryLabel;
+
+	size_t begin = 0;
+	while (begin <= functionText.size())
+	{
+		size_t end = functionText.find('\n', begin);
+		if (end == std::string_view::npos)
+			end = functionText.size();
+		ParsedLine const line = parseLine(functionText.substr(begin, end - begin));
+		begin = end + 1;
+
+		if (entryLabel.empty() && !line.label.empty())
+			entryLabel = line.label;
+
+		bool statement = false;
+		for (Token const& token: line.tokens)
+		{
+			if (token.kind == TokenKind::Comment)
+				continue;
+
+			std::string text(token.text(line.text));
+			if (token.kind == TokenKind::Identifier)
+			{
+				bool const isMnemonic = token.offset == line.mnemonicOffset && !line.mnemonic.empty();
+				if (text == entryLabel)
+					text = "\x01";
+				else if (text.front() == '.' && !(isMnemonic && line.isDirective))
+					text = "\x02" + std::to_string(localLabels.try_emplace(text, localLabels.size()).first->second);
+				else if (isMnemonic || Register::parse(text) || isInstructionPrefix(text) || isOperandKeyword(text))
+					for (char& ch: text)
+						if (ch >= 'A' && ch <= 'Z')
+							ch = static_cast<char>(ch - 'A' + 'a');
+			}
+
+			hash.add(static_cast<char>(token.kind));
+			hash.add(text);
+			hash.add('\0');
+			statement = true;
+		}
+
+		if (statement)
+			hash.add('\n');
+	}
+
+	return hash.value();
+}
+
+std::shared_ptr<const void> ContentCache::find(const Key& key)
+{
+	std::lock_guard lock(mutex_);
+	auto const i = slots_.find(key);
+	if (i != slots_.end())
+	{
+		if (std::shared_ptr<const void> result = i->second.result.lock())
+		{
+			++hits_;
+			touch(i->second, key, result);
+			return result;
+		}
+		slots_.erase(i);
+	}
+	++misses_;
+	return nullptr;
+}
+
+std::shared_ptr<const void> ContentCache::insert(const Key& key, std::shared_ptr<const void> result)
+{
+	std::lock_guard lock(mutex_);
+	auto [i, inserted] = slots_.try_emplace(key, Slot{{}, nullptr, recent_.end()});
+	if (!inserted)
+	{
+		// computed concurrently, keep the first
+		if (std::shared_ptr<const void> existing = i->second.result.lock())
+			result = std::move(existing);
+	}
+
+	i->second.result = result;
+	touch(i->second, key, result);
+
+	// drop slots whose results nobody uses anymore once they pile up
+	if (slots_.size() > 2 * retained_ + 1024)
+		for (auto s = slots_.begin(); s != slots_.end();)
+			s = s->second.result.expired() ? slots_.erase(s) : std::next(s);
+
+	return result;
+}
+
+void ContentCache::touch(Slot& slot, const Key& key, std::shared_ptr<const void> result)
+{
+	if (retained_ == 0)
+		return;
+
+	if (slot.recent != recent_.end())
+		recent_.erase(slot.recent);
+	recent_.push_front(key);
+	slot.recent = recent_.begin();
+	slot.retained = std::move(result);
+
+	while (recent_.size() > retained_)
+	{
+		Key const oldest = recent_.back();
+		recent_.pop_back();
+		if (auto const s = slots_.find(oldest); s != slots_.end())
+		{
+			s->second.retained.reset();
+			s->second.recent = recent_.end();
+		}
+	}
+}
+
+size_t ContentCache::size() const
+{
+	std::lock_guard lock(mutex_);
+	size_t alive = 0;
+	for (auto const& [key, slot]: slots_)
+		alive += slot.result.expired() ? 0 : 1;
+	return alive;
+}
+
+size_t ContentCache::hits() const
+{
+	std::lock_guard lock(mutex_);
+	return hits_;
+}
+
+size_t ContentCache::misses() const
+{
+	std::lock_guard lock(mutex_);
+	return misses_;
+}
+
+void ContentCache::clear()
+{
+	std::lock_guard lock(mutex_);
+	slots_.clear();
+	recent_.clear();
+}
+
+}
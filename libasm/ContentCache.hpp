@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+
+namespace asmlsp
+{
+
+/**
+ * Hashes the source text of a function by its normalized token stream.
+ *
+ * Whitespace, comments, the case of mnemonics and registers, the name of
+ * the function's own label and the names of its local labels (renumbered in
+ * order of appearance) do not affect the hash. Two functions hashing equal
+ * thus lower to structurally identical IR, whichever document they are in.
+ */
+uint64_t normalizedHash(std::string_view functionText);
+
+/**
+ * Mixes @p value into @p hash, e.g. to key a result by configuration as well.
+ */
+constexpr uint64_t hashCombine(uint64_t hash, uint64_t value) noexcept
+{
+	return hash ^ (value + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2));
+}
+
+/**
+ * Workspace wide store of per-function analysis results, addressed by the
+ * normalizedHash() of the function and the result type.
+ *
+ * The same routine often appears in many files, as copies, vendored
+ * libraries or macro expansions. All of them share one immutable result,
+ * computed once. Results stay alive as long as any document uses them, and
+ * the most recently used ones are retained beyond that, so that reopening a
+ * file or switching branches does not recompute them.
+ *
+ * Results must not refer to document specific state, such as IR nodes or
+ * source offsets. Thread safe.
+ */
+class ContentCache
+{
+public:
+	explicit ContentCache(size_t retained = 4096): retained_{retained} {}
+
+	/**
+	 * Retrieves the result of type @p T for @p hash, computing it by @p compute
+	 * if not known yet. @p compute runs without the cache locked.
+	 */
+	template <typename T, typename F>
+	std::shared_ptr<const T> getOrCompute(uint64_t hash, F&& compute)
+	{
+		Key const key{hash, std::type_index(typeid(T))};
+		if (auto cached = find(key))
+			return std::static_pointer_cast<const T>(cached);
+
+		std::shared_ptr<const T> result = std::make_shared<const T>(compute());
+		return std::static_pointer_cast<const T>(insert(key, result));
+	}
+
+	/** Number of results alive, shared or retained. */
+	size_t size() const;
+
+	size_t hits() const;
+	size_t misses() const;
+
+	void clear();
+
+private:
+	struct Key
+	{
+		uint64_t hash;
+		std::type_index type;
+
+		bool operator==(const Key& other) const noexcept { return hash == other.hash && type == other.type; }
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const noexcept { return static_cast<size_t>(hashCombine(key.hash, key.type.hash_code())); }
+	};
+
+	struct Slot
+	{
+		std::weak_ptr<const void> result;
+		std::shared_ptr<const void> retained;  //!< keeps result alive while among the most recently used
+		std::list<Key>::iterator recent;       //!< position in recent_, or recent_.end()
+	};
+
+	std::shared_ptr<const void> find(const Key& key);
+	std::shared_ptr<const void> insert(const Key& key, std::shared_ptr<const void> result);
+	void touch(Slot& slot, const Key& key, std::shared_ptr<const void> result);
+
+	mutable std::mutex mutex_;
+	std::unordered_map<Key, Slot, KeyHash> slots_;
+	std::list<Key> recent_; //!< most recently used first
+	size_t retained_;
+	size_t hits_ = 0;
+	size_t misses_ = 0;
+};
+
+}
@@ -0,0 +1,369 @@
+#include <libasm/ConstantPool.hpp>
+#include <libasm/DataSection.hpp>
+#include <libasm/Module.hpp>
+#include <libasm/Parser.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+
+namespace asmlsp
+{
+
+namespace
+{
+	bool isQuote(char ch) noexcept { return ch == '\'' || ch == '"' || ch == '`'; }
+
+	std::string_view trim(std::string_view s) noexcept
+	{
+		while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front())))
+			s.remove_prefix(1);
+		while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))
+			s.remove_suffix(1);
+		return s;
+	}
+
+	/**
+	 * Invokes @p f for each comma separated operand, honoring quotes and stopping at comments.
+	 */
+	template <typename F>
+	void forEachOperand(std::string_view text, F f)
+	{
+		size_t start = 0;
+		char quote = 0;
+		for (size_t i = 0; i <= text.size(); ++i)
+		{
+			char const ch = i < text.size() ? text[i] : ',';
+			if (quote)
+			{
+				if (ch == quote)
+					quote = 0;
+				else if (i == text.size())
+					break;
+				continue;
+			}
+			if (isQuote(ch))
+				quote = ch;
+			else if (ch == ',' || ch == ';')
+			{
+				if (auto const operand = trim(text.substr(start, i - start)); !operand.empty())
+					f(operand);
+				start = i + 1;
+				if (ch == ';')
+					return;
+			}
+		}
+	}
+
+	bool isString(std::string_view operand) noexcept
+	{
+		return operand.size() >= 2 && isQuote(operand.front()) && operand.back() == operand.front();
+	}
+
+	bool isFloatLiteral(std::string_view operand) noexcept
+	{
+		if (operand.empty() || isString(operand))
+			return false;
+		if (operand.front() == '-' || operand.front() == '+')
+			operand.remove_prefix(1);
+		if (operand.empty() || !(std::isdigit(static_cast<unsigned char>(operand.front())) || operand.front() == '.'))
+			return false;
+		if (operand.find_first_of("xXhH") != std::string_view::npos)
+			return false;
+		return operand.find_first_of(".eE") != std::string_view::npos;
+	}
+
+	/** Number of bytes an operand occupies, strings being padded to a multiple of the unit. */
+	uint64_t sizeOf(std::string_view operand, uint64_t unit) noexcept
+	{
+		if (!isString(operand))
+			return unit;
+		uint64_t const length = operand.size() - 2;
+		return std::max<uint64_t>(1, (length + unit - 1) / unit) * unit;
+	}
+
+	/** Parses a signed NASM integer literal, such as 42, -1, 0x80, 80h or 1010b. */
+	std::optional<uint64_t> parseInteger(std::string_view operand)
+	{
+		bool negative = false;
+		if (!operand.empty() && (operand.front() == '-' || operand.front() == '+'))
+		{
+			negative = operand.front() == '-';
+			operand.remove_prefix(1);
+		}
+
+		auto const value = parseNumber(operand);
+		if (!value)
+			return std::nullopt;
+		return negative ? ~static_cast<uint64_t>(*value) + 1 : static_cast<uint64_t>(*value);
+	}
+
+	/**
+	 * Encodes a single operand into @p out, returning false if its value is not
+	 * known (e.g. an expression involving labels).
+	 */
+	bool encode(std::string_view operand, DataUnit unit, uint8_t* out)
+	{
+		auto const width = static_cast<size_t>(unit);
+
+		if (isString(operand))
+		{
+			std::memcpy(out, operand.data() + 1, operand.size() - 2);
+			return true; // the padding is pre-zeroed
+		}
+
+		if (isFloatLiteral(operand))
+		{
+			double value = 0;
+			auto const [end, ec] = std::from_chars(operand.data(), operand.data() + operand.size(), value);
+			if (ec != std::errc() || end != operand.data() + operand.size())
+				return false;
+			if (unit == DataUnit::Dword)
+			{
+				auto const f = static_cast<float>(value);
+				std::memcpy(out, &f, sizeof(f));
+				return true;
+			}
+			if (unit == DataUnit::Qword)
+			{
+				std::memcpy(out, &value, sizeof(value));
+				return true;
+			}
+			return false;
+		}
+
+		auto const value = parseInteger(operand);
+		if (!value)
+			return false;
+
+		bool const negative = static_cast<int64_t>(*value) < 0;
+		for (size_t i = 0; i < width; ++i)
+			out[i] = i < 8 ? static_cast<uint8_t>(*value >> (8 * i)) : (negative ? 0xFF : 0x00);
+		return true;
+	}
+}
+
+std::string_view nameOf(DataUnit unit) noexcept
+{
+	switch (unit)
+	{
+		case DataUnit::Byte: return "byte";
+		case DataUnit::Word: return "word";
+		case DataUnit::Dword: return "dword";
+		case DataUnit::Qword: return "qword";
+		case DataUnit::Oword: return "oword";
+		case DataUnit::Yword: return "yword";
+		case DataUnit::Zword: return "zword";
+	}
+	return "byte";
+}
+
+// {{{ DataSymbol
+DataSymbol::DataSymbol(std::string name, DataSection& section, uint64_t offset):
+	Value(LiteralType::Void, std::move(name)),
+	section_{section},
+	offset_{offset}
+{
+}
+
+uint64_t DataSymbol::size() const
+{
+	const DataSymbol* next = section_.nextSymbol(*this);
+	return (next ? next->offset() : section_.size()) - offset_;
+}
+
+DataUnit DataSymbol::unit() const
+{
+	return section_.unitAt(offset_);
+}
+
+std::string DataSymbol::describe() const
+{
+	uint64_t const n = count();
+	std::string text = n == 1 ? std::string(nameOf(unit())) : "table of " + std::to_string(n) + " x " + std::string(nameOf(unit()));
+
+	if (section_.isFloatAt(offset_))
+		text += unit() == DataUnit::Dword ? " (float)" : " (double)";
+
+	text += ", " + std::to_string(size()) + (size() == 1 ? " byte in " : " bytes in ") + section_.name();
+	return text;
+}
+
+Constant* DataSymbol::constantAt(int64_t offset, unsigned width, ConstantPool& constants) const
+{
+	if (offset < 0 || width == 0 || width % 8 || width > 512)
+		return nullptr;
+
+	uint64_t const at = offset_ + static_cast<uint64_t>(offset);
+	uint8_t bytes[64] = {};
+	if (!section_.read(at, bytes, width / 8))
+		return nullptr;
+
+	bool const isFloat = section_.isFloatAt(at);
+	auto const load = [&](auto value) {
+		std::memcpy(&value, bytes, sizeof(value));
+		return value;
+	};
+
+	switch (width)
+	{
+		case 8: return constants.getUInt(load(uint8_t{}));
+		case 16: return constants.getUInt(load(uint16_t{}));
+		case 32: return isFloat ? static_cast<Constant*>(constants.getFloat32(load(float{})))
+								: constants.getUInt(load(uint32_t{}));
+		case 64: return isFloat ? static_cast<Constant*>(constants.getFloat64(load(double{})))
+								: constants.getUInt(load(uint64_t{}));
+		case 128: return constants.getVector(load(VectorBits<128>{}));
+		case 256: return constants.getVector(load(VectorBits<256>{}));
+		case 512: return constants.getVector(load(VectorBits<512>{}));
+		default: return nullptr;
+	}
+}
+// }}}
+
+// {{{ DataSection
+DataSection::DataSection(Module& module, std::string name):
+	module_{module},
+	name_{std::move(name)},
+	readOnly_{name_.rfind(".rodata", 0) == 0 || name_.rfind(".rdata", 0) == 0 || name_ == ".text"},
+	zeroInitialized_{name_.rfind(".bss", 0) == 0}
+{
+}
+
+void DataSection::align(uint64_t alignment)
+{
+	alignment_ = std::max(alignment_, alignment);
+	uint64_t const padding = (alignment - size_ % alignment) % alignment;
+	if (!padding)
+		return;
+
+	items_.push_back(Item{size_, padding, padding, 0, 0, DataUnit::Byte, ItemKind::Padding, false, std::nullopt});
+	size_ += padding;
+}
+
+DataSymbol* DataSection::defineSymbol(std::string name)
+{
+	symbols_.emplace_back(std::make_unique<DataSymbol>(std::move(name), *this, size_));
+	module_.registerSymbol(symbols_.back().get());
+	return symbols_.back().get();
+}
+
+void DataSection::emit(DataUnit unit, uint32_t begin, uint32_t end, uint64_t repeat)
+{
+	auto const text = std::string_view(module_.source()).substr(begin, end - begin);
+
+	uint64_t patternSize = 0;
+	bool isFloat = false;
+	forEachOperand(text, [&](std::string_view operand) {
+		patternSize += sizeOf(operand, static_cast<uint64_t>(unit));
+		isFloat = isFloat || isFloatLiteral(operand);
+	});
+
+	if (!patternSize || !repeat)
+		return;
+
+	items_.push_back(Item{size_, patternSize * repeat, patternSize, begin, end, unit, ItemKind::Data, isFloat, std::nullopt});
+	size_ += patternSize * repeat;
+}
+
+void DataSection::reserve(DataUnit unit, uint64_t count)
+{
+	uint64_t const size = count * static_cast<uint64_t>(unit);
+	if (!size)
+		return;
+
+	items_.push_back(Item{size_, size, size, 0, 0, unit, ItemKind::Reserved, false, std::nullopt});
+	size_ += size;
+}
+
+const DataSymbol* DataSection::nextSymbol(const DataSymbol& symbol) const
+{
+	auto const i = std::upper_bound(symbols_.begin(), symbols_.end(), symbol.offset(),
+									[](uint64_t offset, auto const& s) { return offset < s->offset(); });
+	return i != symbols_.end() ? i->get() : nullptr;
+}
+
+const DataSection::Item* DataSection::itemAt(uint64_t offset) const
+{
+	auto const i = std::upper_bound(items_.begin(), items_.end(), offset,
+									[](uint64_t offset, const Item& item) { return offset < item.offset; });
+	if (i == items_.begin())
+		return nullptr;
+
+	const Item& item = *std::prev(i);
+	return offset < item.offset + item.size ? &item : nullptr;
+}
+
+bool DataSection::isFloatAt(uint64_t offset) const
+{
+	const Item* item = itemAt(offset);
+	return item && item->isFloat;
+}
+
+DataUnit DataSection::unitAt(uint64_t offset) const
+{
+	const Item* item = itemAt(offset);
+	return item ? item->unit : DataUnit::Byte;
+}
+
+void DataSection::decode(const Item& item) const
+{
+	std::vector<uint8_t> bytes(item.patternSize, 0);
+	std::vector<bool> unknown(item.patternSize, false);
+
+	auto const text = std::string_view(module_.source()).substr(item.begin, item.end - item.begin);
+	uint64_t offset = 0;
+	forEachOperand(text, [&](std::string_view operand) {
+		uint64_t const size = sizeOf(operand, static_cast<uint64_t>(item.unit));
+		if (offset + size > bytes.size())
+			return;
+		if (!encode(operand, item.unit, bytes.data() + offset))
+			std::fill_n(unknown.begin() + static_cast<ptrdiff_t>(offset), size, true);
+		offset += size;
+	});
+
+	item.decoded.emplace(std::move(bytes), std::move(unknown));
+}
+
+bool DataSection::read(uint64_t offset, uint8_t* out, size_t size) const
+{
+	while (size)
+	{
+		const Item* item = itemAt(offset);
+		if (!item)
+			return false;
+
+		uint64_t const available = std::min<uint64_t>(size, item->offset + item->size - offset);
+		switch (item->kind)
+		{
+			case ItemKind::Padding:
+				return false;
+			case ItemKind::Reserved:
+				std::memset(out, 0, available);
+				break;
+			case ItemKind::Data:
+			{
+				if (!item->decoded)
+					decode(*item);
+				auto const& [bytes, unknown] = *item->decoded;
+				for (uint64_t i = 0; i < available; ++i)
+				{
+					uint64_t const at = (offset + i - item->offset) % item->patternSize;
+					if (unknown[at])
+						return false;
+					out[i] = bytes[at];
+				}
+				break;
+			}
+		}
+
+		offset += available;
+		out += available;
+		size -= available;
+	}
+	return true;
+}
+// }}}
+
+}
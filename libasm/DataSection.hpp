@@ -0,0 +1,194 @@
+#pragma once
+
+#include <libasm/SSA.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace asmlsp
+{
+
+class ConstantPool;
+class DataSection;
+class Module;
+
+/**
+ * Element size of a data directive.
+ */
+enum class DataUnit : uint8_t
+{
+	Byte = 1,   //!< db, resb
+	Word = 2,   //!< dw, resw
+	Dword = 4,  //!< dd, resd
+	Qword = 8,  //!< dq, resq
+	Oword = 16, //!< do, reso
+	Yword = 32, //!< dy, resy
+	Zword = 64, //!< dz, resz
+};
+
+/**
+ * Assembler keyword of the given unit, such as "dword".
+ */
+std::string_view nameOf(DataUnit unit) noexcept;
+
+/**
+ * A label within a data section, such as a lookup table or a constant mask.
+ *
+ * Its size extends up to the next symbol of the same section or the section's end.
+ */
+class DataSymbol: public Value
+{
+public:
+	DataSymbol(std::string name, DataSection& section, uint64_t offset);
+
+	DataSection& section() const noexcept { return section_; }
+
+	/** Offset of this symbol relative to its section start. */
+	uint64_t offset() const noexcept { return offset_; }
+
+	/** Size in bytes. */
+	uint64_t size() const;
+
+	/** Element unit of the first directive following this symbol. */
+	DataUnit unit() const;
+
+	/** Number of elements of unit() this symbol spans. */
+	uint64_t count() const { return size() / static_cast<uint64_t>(unit()); }
+
+	/**
+	 * Describes the layout for hover, such as "table of 256 x dword".
+	 */
+	std::string describe() const;
+
+	/**
+	 * Retrieves the constant of @p width bits stored at @p offset relative to
+	 * this symbol, or nullptr if the bytes are not known (e.g. uninitialized
+	 * or a relocation).
+	 */
+	Constant* constantAt(int64_t offset, unsigned width, ConstantPool& constants) const;
+
+private:
+	DataSection& section_;
+	uint64_t offset_;
+};
+
+/**
+ * A section of data directives (db/dw/dd/dq, times, resb, align) and their symbols.
+ *
+ * Directive operands are not decoded up front. Each directive only records
+ * the source range of its operand list, which is decoded into bytes when a
+ * constant is first read from it. Repetitions (times) store their pattern
+ * once. Multi megabyte lookup tables therefore cost a few words per
+ * directive until they are actually inspected.
+ */
+class DataSection
+{
+public:
+	DataSection(Module& module, std::string name);
+
+	DataSection(const DataSection&) = delete;
+	DataSection& operator=(const DataSection&) = delete;
+
+	Module& module() const noexcept { return module_; }
+	const std::string& name() const noexcept { return name_; }
+
+	/** Tests whether this section holds read-only data, e.g. .rodata. */
+	bool isReadOnly() const noexcept { return readOnly_; }
+
+	/** Tests whether this section is zero initialized, e.g. .bss. */
+	bool isZeroInitialized() const noexcept { return zeroInitialized_; }
+
+	/** Current size in bytes, i.e. the location counter. */
+	uint64_t size() const noexcept { return size_; }
+
+	/** Largest alignment requested within this section. */
+	uint64_t alignment() const noexcept { return alignment_; }
+
+	/**
+	 * Pads the location counter up to the next multiple of @p alignment (a power of two).
+	 */
+	void align(uint64_t alignment);
+
+	/**
+	 * Defines a symbol at the current location counter.
+	 */
+	DataSymbol* defineSymbol(std::string name);
+
+	/**
+	 * Appends a data directive.
+	 *
+	 * @param unit    element size (db, dw, ...)
+	 * @param begin   start offset of the operand list within the module's source
+	 * @param end     end offset of the operand list within the module's source
+	 * @param repeat  repetition count of a preceding times prefix
+	 */
+	void emit(DataUnit unit, uint32_t begin, uint32_t end, uint64_t repeat = 1);
+
+	/**
+	 * Appends @p count uninitialized elements of the given unit (resb, resw, ...).
+	 */
+	void reserve(DataUnit unit, uint64_t count);
+
+	/**
+	 * Reads @p size bytes at @p offset into @p out.
+	 *
+	 * @retval true all bytes are known
+	 * @retval false at least one byte is unknown, or the range exceeds this section
+	 */
+	bool read(uint64_t offset, uint8_t* out, size_t size) const;
+
+	/**
+	 * Tests whether the directive covering @p offset was written with floating point literals.
+	 */
+	bool isFloatAt(uint64_t offset) const;
+
+	/** Element unit of the directive covering @p offset, Byte if none. */
+	DataUnit unitAt(uint64_t offset) const;
+
+	const std::vector<std::unique_ptr<DataSymbol>>& symbols() const noexcept { return symbols_; }
+
+	/** Retrieves the symbol following the given one, or nullptr if it is the last. */
+	const DataSymbol* nextSymbol(const DataSymbol& symbol) const;
+
+private:
+	enum class ItemKind : uint8_t
+	{
+		Data,     //!< initialized from an operand list in the source
+		Reserved, //!< uninitialized (resb and friends)
+		Padding,  //!< alignment fill
+	};
+
+	struct Item
+	{
+		uint64_t offset;
+		uint64_t size;         //!< total size, including repetitions
+		uint64_t patternSize;  //!< size of a single repetition
+		uint32_t begin;        //!< operand list in source
+		uint32_t end;
+		DataUnit unit;
+		ItemKind kind;
+		bool isFloat;
+
+		//! decoded bytes of a single repetition and which of them are unknown, populated on first read
+		mutable std::optional<std::pair<std::vector<uint8_t>, std::vector<bool>>> decoded;
+	};
+
+	const Item* itemAt(uint64_t offset) const;
+	void decode(const Item& item) const;
+
+	Module& module_;
+	std::string name_;
+	bool readOnly_;
+	bool zeroInitialized_;
+	uint64_t size_ = 0;
+	uint64_t alignment_ = 1;
+	std::vector<Item> items_;
+	std::vector<std::unique_ptr<DataSymbol>> symbols_;
+};
+
+}
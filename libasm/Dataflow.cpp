@@ -0,0 +1,42 @@
+#include <libasm/Dataflow.hpp>
+
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+
+namespace asmlsp
+{
+
+std::vector<BasicBlock*> reversePostOrder(BasicBlock* entry)
+{
+	std::vector<BasicBlock*> postOrder;
+	if (!entry)
+		return postOrder;
+
+	// Iterative DFS, as deeply nested CFGs would otherwise overflow the stack.
+	std::unordered_set<BasicBlock*> visited;
+	std::vector<std::pair<BasicBlock*, size_t>> stack;
+	stack.emplace_back(entry, 0);
+	visited.insert(entry);
+
+	while (!stack.empty())
+	{
+		auto& [bb, next] = stack.back();
+		if (next < bb->successors().size())
+		{
+			BasicBlock* succ = bb->successors()[next++];
+			if (visited.insert(succ).second)
+				stack.emplace_back(succ, 0);
+		}
+		else
+		{
+			postOrder.push_back(bb);
+			stack.pop_back();
+		}
+	}
+
+	std::reverse(postOrder.begin(), postOrder.end());
+	return postOrder;
+}
+
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <libasm/SSA.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Computes the reverse post order of all basic blocks reachable from \p entry.
+ *
+ * The entry block is always the first element of the result.
+ */
+std::vector<BasicBlock*> reversePostOrder(BasicBlock* entry);
+
+/**
+ * Operator used to combine the states flowing into a basic block from its predecessors.
+ */
+enum class MeetOperator
+{
+	Union,        //!< may-analysis: a fact holds if it holds on any path
+	Intersection, //!< must-analysis: a fact holds only if it holds on all paths
+};
+
+/**
+ * Per basic block in- and out-states of a solved dataflow problem.
+ */
+template <typename State>
+class DataflowResult
+{
+public:
+	/**
+	 * Basic blocks in reverse post order, i.e. the order they were solved in.
+	 */
+	const std::vector<BasicBlock*>& order() const noexcept { return order_; }
+
+	bool contains(const BasicBlock* bb) const { return index_.count(bb) != 0; }
+
+	const State& in(const BasicBlock* bb) const { return in_[index_.at(bb)]; }
+	const State& out(const BasicBlock* bb) const { return out_[index_.at(bb)]; }
+
+	/** Number of block visits it took to reach the fixpoint. */
+	size_t iterations() const noexcept { return iterations_; }
+
+private:
+	std::vector<BasicBlock*> order_;
+	std::unordered_map<const BasicBlock*, size_t> index_;
+	std::vector<State> in_;
+	std::vector<State> out_;
+	size_t iterations_ = 0;
+
+	template <typename S, typename T>
+	friend DataflowResult<S> solveForward(BasicBlock*, S, S, MeetOperator, T);
+};
+
+/**
+ * Solves a forward dataflow problem over a bitset lattice.
+ *
+ * Blocks are visited from a worklist ordered by their reverse post order
+ * index, so that acyclic regions converge in a single sweep and loops only
+ * re-visit the blocks whose inputs actually changed.
+ *
+ * @param entry       the function's entry block
+ * @param entryState  state flowing into the entry block from the caller
+ * @param top         initial out-state of every block, the identity of @p meet
+ *                    (all bits clear for Union, all bits set for Intersection)
+ * @param meet        how predecessor states are combined
+ * @param transfer    callable of signature <tt>State(BasicBlock&, const State& in)</tt>
+ *
+ * @p State must support <tt>|=</tt>, <tt>&=</tt> and <tt>!=</tt>, such as
+ * std::bitset or an unsigned integer.
+ */
+template <typename State, typename Transfer>
+DataflowResult<State> solveForward(BasicBlock* entry, State entryState, State top, MeetOperator meet, Transfer transfer)
+{
+	DataflowResult<State> result;
+	result.order_ = reversePostOrder(entry);
+
+	size_t const count = result.order_.size();
+	for (size_t i = 0; i < count; ++i)
+		result.index_[result.order_[i]] = i;
+
+	result.in_.assign(count, top);
+	result.out_.assign(count, top);
+
+	std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> worklist;
+	std::vector<bool> queued(count, true);
+	for (size_t i = 0; i < count; ++i)
+		worklist.push(i);
+
+	while (!worklist.empty())
+	{
+		size_t const i = worklist.top();
+		worklist.pop();
+		queued[i] = false;
+		++result.iterations_;
+
+		BasicBlock* bb = result.order_[i];
+		State in = i == 0 ? entryState : top;
+		for (BasicBlock* pred: bb->predecessors())
+		{
+			auto const p = result.index_.find(pred);
+			if (p == result.index_.end())
+				continue; // unreachable predecessor
+			if (meet == MeetOperator::Union)
+				in |= result.out_[p->second];
+			else
+				in &= result.out_[p->second];
+		}
+		result.in_[i] = in;
+
+		State out = transfer(*bb, in);
+		if (out != result.out_[i])
+		{
+			result.out_[i] = std::move(out);
+			for (BasicBlock* succ: bb->successors())
+			{
+				auto const s = result.index_.find(succ);
+				if (s != result.index_.end() && !queued[s->second])
+				{
+					queued[s->second] = true;
+					worklist.push(s->second);
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+}
@@ -0,0 +1,138 @@
+#include <libasm/DefinitionResolver.hpp>
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace asmlsp
+{
+
+const std::vector<Value*>& DefinitionResolver::reachingDefinitions(PhiNode* phi)
+{
+	FunctionMemo& memo = memo_[&phi->getBasicBlock()->parent()];
+	if (auto const i = memo.index.find(phi); i != memo.index.end())
+		return memo.results[i->second];
+
+	// Iterative Tarjan, as phi chains of large unrolled loops easily exceed the native stack.
+	struct Frame
+	{
+		PhiNode* phi;
+		size_t nextOperand;
+	};
+
+	std::unordered_map<const PhiNode*, size_t> number;
+	std::unordered_map<const PhiNode*, size_t> lowlink;
+	std::unordered_set<const PhiNode*> onStack;
+	std::vector<PhiNode*> stack;
+	std::vector<Frame> frames;
+	size_t counter = 0;
+
+	auto const visit = [&](PhiNode* p) {
+		number[p] = lowlink[p] = counter++;
+		stack.push_back(p);
+		onStack.insert(p);
+		frames.push_back(Frame{p, 0});
+	};
+
+	visit(phi);
+	while (!frames.empty())
+	{
+		Frame& frame = frames.back();
+		if (frame.nextOperand < frame.phi->operands().size())
+		{
+			auto* child = dynamic_cast<PhiNode*>(frame.phi->operand(frame.nextOperand++));
+			if (!child || memo.index.count(child))
+				continue;
+			if (!number.count(child))
+				visit(child);
+			else if (onStack.count(child))
+				lowlink[frame.phi] = std::min(lowlink[frame.phi], number[child]);
+			continue;
+		}
+
+		PhiNode* const p = frame.phi;
+		frames.pop_back();
+		if (!frames.empty())
+			lowlink[frames.back().phi] = std::min(lowlink[frames.back().phi], lowlink[p]);
+
+		if (lowlink[p] != number[p])
+			continue;
+
+		// p is the root of an SCC, whose successor SCCs are all solved already
+		std::vector<PhiNode*> component;
+		PhiNode* q;
+		do
+		{
+			q = stack.back();
+			stack.pop_back();
+			onStack.erase(q);
+			component.push_back(q);
+		} while (q != p);
+
+		std::vector<Value*> definitions;
+		for (PhiNode* member: component)
+		{
+			for (Value* operand: member->operands())
+			{
+				if (auto* other = dynamic_cast<PhiNode*>(operand))
+				{
+					if (auto const i = memo.index.find(other); i != memo.index.end())
+						definitions.insert(definitions.end(), memo.results[i->second].begin(), memo.results[i->second].end());
+				}
+				else if (operand)
+					definitions.push_back(operand);
+			}
+		}
+
+		std::sort(definitions.begin(), definitions.end());
+		definitions.erase(std::unique(definitions.begin(), definitions.end()), definitions.end());
+		std::stable_sort(definitions.begin(), definitions.end(), [](const Value* a, const Value* b) {
+			return a->sourceRange().begin < b->sourceRange().begin;
+		});
+
+		size_t const result = memo.results.size();
+		memo.results.emplace_back(std::move(definitions));
+		for (PhiNode* member: component)
+			memo.index[member] = result;
+	}
+
+	return memo.results[memo.index.at(phi)];
+}
+
+std::vector<LocationLink> DefinitionResolver::definitions(const PositionIndex::Match& match, const PositionIndex& index)
+{
+	auto const* instr = dynamic_cast<const CpuInstr*>(match.node);
+	if (!instr || match.operand < 0)
+		return {};
+
+	size_t const n = static_cast<size_t>(match.operand);
+	if (n >= instr->operandRegisters().size() || !instr->operandRegisters()[n])
+		return {};
+
+	Value* operand = instr->operand(n);
+	std::vector<Value*> targets;
+	if (auto* phi = dynamic_cast<PhiNode*>(operand))
+		targets = reachingDefinitions(phi);
+	else if (operand)
+		targets.push_back(operand);
+
+	SourceRange const origin = index.currentRange(instr->operandRanges()[n]);
+	auto* function = dynamic_cast<FunctionDefinition*>(&instr->getBasicBlock()->parent());
+
+	std::vector<LocationLink> links;
+	for (Value* target: targets)
+	{
+		// values live on entry are defined by the function's label
+		Value const* definition = dynamic_cast<RegisterArgument*>(target) ? function : target;
+		if (!definition || definition->sourceRange().empty())
+			continue;
+
+		SourceRange const range = index.currentRange(definition->sourceRange());
+		SourceRange const selection = definition == function
+			? SourceRange{range.begin, std::min(range.end, range.begin + function->name().size())}
+			: range;
+		links.push_back(LocationLink{origin, range, selection, target});
+	}
+	return links;
+}
+
+}
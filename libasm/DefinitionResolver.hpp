@@ -0,0 +1,73 @@
+#pragma once
+
+#include <libasm/PositionIndex.hpp>
+#include <libasm/SSA.hpp>
+#include <libasm/SourceLocation.hpp>
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * A goto-definition target, modelled after LSP's LocationLink.
+ *
+ * All ranges refer to the current text of the queried document.
+ */
+struct LocationLink
+{
+	SourceRange originSelectionRange; //!< the register operand the request was issued on
+	SourceRange targetRange;          //!< the full defining instruction or function
+	SourceRange targetSelectionRange; //!< the part of targetRange to select
+	const Value* target = nullptr;
+};
+
+/**
+ * Resolves goto-definition requests on register operands.
+ *
+ * A register read after a control flow merge is a PhiNode, which is not
+ * anything to jump to. Instead, all definitions reaching the phi are
+ * returned by walking its operands transitively.
+ *
+ * Phis referring to each other in loops form strongly connected components
+ * that all share the same reaching definitions, so the walk is a Tarjan SCC
+ * traversal whose results are memoized per phi. Repeated queries, also on
+ * other phis of the same loop nest, are a single lookup.
+ */
+class DefinitionResolver
+{
+public:
+	/**
+	 * Retrieves the non-phi values reaching @p phi, ordered by source position.
+	 *
+	 * These are instructions, or RegisterArguments for values live on function entry.
+	 */
+	const std::vector<Value*>& reachingDefinitions(PhiNode* phi);
+
+	/**
+	 * Retrieves the definitions of the operand under the cursor of @p match.
+	 *
+	 * @returns an empty list if the match is not on a register operand.
+	 */
+	std::vector<LocationLink> definitions(const PositionIndex::Match& match, const PositionIndex& index);
+
+	/**
+	 * Discards the memoized results for the phis of @p function, e.g. before it is re-lowered.
+	 */
+	void invalidate(const FunctionDefinition& function) { memo_.erase(&function); }
+
+	void clear() { memo_.clear(); }
+
+private:
+	struct FunctionMemo
+	{
+		std::unordered_map<const PhiNode*, size_t> index; //!< phi to its SCC's entry in results
+		std::deque<std::vector<Value*>> results;
+	};
+
+	std::unordered_map<const Value*, FunctionMemo> memo_;
+};
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+namespace asmlsp
+{
+
+class Value;
+
+/**
+ * Severity of a diagnostic, numbered like LSP's DiagnosticSeverity.
+ */
+enum class Severity
+{
+	Error = 1,
+	Warning = 2,
+	Information = 3,
+	Hint = 4,
+};
+
+/**
+ * A single finding of an analysis pass.
+ *
+ * The subject is the IR node the finding refers to, which the language server
+ * maps back to a source range.
+ */
+struct Diagnostic
+{
+	Severity severity;
+	std::string code;       //!< short stable identifier, such as "avx-sse-transition"
+	std::string message;    //!< human readable description
+	const Value* subject;   //!< IR node the diagnostic is attached to
+};
+
+}
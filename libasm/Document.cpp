@@ -0,0 +1,47 @@
+#include <libasm/Document.hpp>
+
+namespace asmlsp
+{
+
+Document::Document(std::string uri, std::string text):
+	uri_{std::move(uri)},
+	buffer_{text}
+{
+	parses_.reset(text);
+	changedLines_ = {0, parses_.lineCount() - 1};
+}
+
+TextChange Document::edit(Position start, Position end, std::string_view text)
+{
+	TextChange const change = buffer_.replace(start, end, text);
+	changed(change);
+	return change;
+}
+
+TextChange Document::replaceAll(std::string_view text)
+{
+	TextChange const change = buffer_.replace(0, buffer_.size(), text);
+	changed(change);
+	return change;
+}
+
+void Document::changed(const TextChange& change)
+{
+	changedLines_ = parses_.apply(change, buffer_);
+	index_.apply(change);
+	snapshot_.reset();
+	++revision_;
+}
+
+std::shared_ptr<const Document::Snapshot> Document::snapshot() const
+{
+	if (!snapshot_)
+	{
+		auto text = std::make_shared<const std::string>(buffer_.text());
+		LineTable lines(*text);
+		snapshot_ = std::make_shared<const Snapshot>(Snapshot{std::move(text), std::move(lines), revision_});
+	}
+	return snapshot_;
+}
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <libasm/Parser.hpp>
+#include <libasm/PositionIndex.hpp>
+#include <libasm/SourceLocation.hpp>
+#include <libasm/TextBuffer.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace asmlsp
+{
+
+/**
+ * An open document: its editable text and everything that refers into it by offset.
+ *
+ * Incremental edits go to the TextBuffer in O(log n), which also maps
+ * between offsets and positions. The resulting TextChange is forwarded to
+ * the ParseCache, which re-parses only the changed lines, and to the
+ * PositionIndex, which records it rather than shifting its entries. Nothing
+ * is rebuilt or shifted per keystroke.
+ *
+ * Analyses and lowering work on a contiguous Snapshot of the text, which is
+ * materialized on first request after an edit and shared until the next one.
+ */
+class Document
+{
+public:
+	/**
+	 * Contiguous text of the document at one revision, with its line table.
+	 */
+	struct Snapshot
+	{
+		std::shared_ptr<const std::string> text; //!< shareable with Module
+		LineTable lines;
+		uint64_t revision;
+	};
+
+	Document(std::string uri, std::string text);
+
+	const std::string& uri() const noexcept { return uri_; }
+
+	/** Incremented by every edit. */
+	uint64_t revision() const noexcept { return revision_; }
+
+	const TextBuffer& buffer() const noexcept { return buffer_; }
+
+	/** Parsed lines of the current text, kept up to date by every edit. */
+	const ParseCache& parses() const noexcept { return parses_; }
+
+	/** First and last line, after the last edit, whose content it changed. */
+	std::pair<size_t, size_t> changedLines() const noexcept { return changedLines_; }
+
+	PositionIndex& index() noexcept { return index_; }
+	const PositionIndex& index() const noexcept { return index_; }
+
+	/**
+	 * Applies an incremental LSP content change, replacing the text between
+	 * @p start and @p end.
+	 */
+	TextChange edit(Position start, Position end, std::string_view text);
+
+	/**
+	 * Applies a full LSP content change, replacing the whole text.
+	 */
+	TextChange replaceAll(std::string_view text);
+
+	/**
+	 * Retrieves the contiguous text of the current revision.
+	 */
+	std::shared_ptr<const Snapshot> snapshot() const;
+
+private:
+	void changed(const TextChange& change);
+
+	std::string uri_;
+	TextBuffer buffer_;
+	ParseCache parses_;
+	std::pair<size_t, size_t> changedLines_;
+	PositionIndex index_;
+	uint64_t revision_ = 0;
+	mutable std::shared_ptr<const Snapshot> snapshot_;
+};
+
+}
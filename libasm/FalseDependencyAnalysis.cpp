@@ -0,0 +1,170 @@
+#include <libasm/FalseDependencyAnalysis.hpp>
+#include <libasm/InstructionDefinition.hpp>
+
+#include <array>
+
+namespace asmlsp
+{
+
+namespace
+{
+	/**
+	 * Finds the register the given producer wrote to the same physical register as @p read.
+	 */
+	Register writtenAlias(const CpuInstr& producer, Register read)
+	{
+		for (Register const written: producer.outputRegisters())
+			if (written && written.family() == read.family())
+				return written;
+		return Register{};
+	}
+
+	/**
+	 * Suggests the idiom that zeroes @p reg, breaking any dependency on its previous value.
+	 */
+	std::string zeroIdiomFor(Register reg)
+	{
+		if (reg.isGeneralPurpose())
+		{
+			std::string const name = Register(RegisterKind::GP32, reg.index()).name();
+			return "xor " + name + ", " + name;
+		}
+		return "xorps " + reg.name() + ", " + reg.name();
+	}
+
+	/**
+	 * Tests whether @p instr reads @p reg's physical register as a source of
+	 * its own, rather than as the previous value a partial write merges into.
+	 */
+	bool readsAsSource(const CpuInstr& instr, Register reg)
+	{
+		auto const& registers = instr.operandRegisters();
+		for (size_t n = 0; n < registers.size(); ++n)
+			if (registers[n] && registers[n].family() == reg.family() && !instr.isMergeOperand(n))
+				return true;
+		return false;
+	}
+}
+
+FalseDependencyAnalysis::FalseDependencyAnalysis(Microarchitecture uarch): traits_{&traitsOf(uarch)}
+{
+}
+
+std::vector<Diagnostic> FalseDependencyAnalysis::analyze(const FunctionDefinition& function) const
+{
+	std::vector<Diagnostic> diagnostics;
+	for (auto const& bb: function.basicBlocks())
+		analyze(*bb, diagnostics);
+	return diagnostics;
+}
+
+bool FalseDependencyAnalysis::hasOutputDependency(const CpuInstr& instr) const
+{
+	InstructionDefinition const& def = *instr.definition();
+	if (def.hasFlag(InstructionFlags::MergesDestination))
+		return def.encoding() == Encoding::Legacy;
+	if (def.hasFlag(InstructionFlags::OutputDependency))
+		return def.extension() == Extension::POPCNT ? traits_->popcntFalseDependency
+													 : traits_->lzcntTzcntFalseDependency;
+	return false;
+}
+
+void FalseDependencyAnalysis::analyze(BasicBlock& bb, std::vector<Diagnostic>& diagnostics) const
+{
+	// Most recent definition of each physical register within this block.
+	std::array<const CpuInstr*, Register::FamilyCount> lastDef{};
+
+	auto const report = [&](Severity severity, const char* code, std::string message, const Instr& subject) {
+		diagnostics.emplace_back(Diagnostic{severity, code, std::move(message), &subject});
+	};
+
+	auto const zeroed = [&](Register reg) {
+		const CpuInstr* def = lastDef[reg.family()];
+		return def && def->isDependencyBreaking();
+	};
+
+	for (auto const& instr: bb.instructions())
+	{
+		auto const* cpu = dynamic_cast<const CpuInstr*>(instr.get());
+		if (!cpu)
+			continue;
+
+		// Reading a register wider than what its reaching definition wrote.
+		auto const& operandRegisters = cpu->operandRegisters();
+		for (size_t i = 0; i < operandRegisters.size() && i < cpu->operands().size(); ++i)
+		{
+			Register const read = operandRegisters[i];
+			auto const* producer = dynamic_cast<const CpuInstr*>(cpu->operand(i));
+			if (!read || !read.isGeneralPurpose() || !producer || cpu->isMergeOperand(i))
+				continue;
+
+			Register const written = writtenAlias(*producer, read);
+			if (!written || !written.isPartial() || !read.covers(written) || read.width() == written.width())
+				continue;
+
+			switch (traits_->partialRegisters)
+			{
+				case PartialRegisterPolicy::Stall:
+					report(Severity::Warning, "partial-register-stall",
+						   "reading " + read.name() + " after writing " + written.name() + " stalls on "
+							   + std::string(traits_->name) + " until the partial register is merged",
+						   *cpu);
+					break;
+				case PartialRegisterPolicy::MergeHigh8:
+					if (written.kind() != RegisterKind::GP8High)
+						break;
+					[[fallthrough]];
+				case PartialRegisterPolicy::MergeAll:
+					report(Severity::Warning, "partial-register-stall",
+						   "reading " + read.name() + " after writing " + written.name()
+							   + " requires a merge uop; write the full register instead (e.g. movzx)",
+						   *cpu);
+					break;
+				case PartialRegisterPolicy::NoRename:
+					break;
+			}
+		}
+
+		if (!cpu->outputRegisters().empty() && cpu->definition())
+		{
+			Register const dest = cpu->outputRegisters().front();
+			std::string const& mnemonic = cpu->definition()->mnemonic();
+
+			// Merging forms read their destination by definition, so only the
+			// database flags tell whether that read is a false dependency. For
+			// popcnt rax, rax the destination is a true source though.
+			bool const mergesDestination = cpu->definition()->hasFlag(InstructionFlags::MergesDestination);
+			if (hasOutputDependency(*cpu) && !zeroed(dest) && (mergesDestination || !readsAsSource(*cpu, dest)))
+			{
+				if (mergesDestination)
+					report(Severity::Warning, "false-dependency",
+						   mnemonic + " merges into " + dest.name()
+							   + ", depending on its previous value; zero it first (e.g. " + zeroIdiomFor(dest) + ")",
+						   *cpu);
+				else
+					report(Severity::Warning, "false-dependency",
+						   mnemonic + " has a false dependency on its destination " + dest.name() + " on "
+							   + std::string(traits_->name) + "; break it with " + zeroIdiomFor(dest),
+						   *cpu);
+			}
+			else if (dest.isPartial() && !readsAsSource(*cpu, dest) && !zeroed(dest))
+			{
+				auto const policy = traits_->partialRegisters;
+				bool const dependent = policy == PartialRegisterPolicy::NoRename
+									   || (policy == PartialRegisterPolicy::MergeHigh8
+										   && dest.kind() != RegisterKind::GP8High);
+				if (dependent)
+					report(Severity::Hint, "partial-register-dependency",
+						   "writing " + dest.name() + " depends on the previous value of the full register on "
+							   + std::string(traits_->name) + "; consider writing the 32 bit register (e.g. movzx)",
+						   *cpu);
+			}
+		}
+
+		for (Register const written: cpu->outputRegisters())
+			if (written)
+				lastDef[written.family()] = cpu;
+	}
+}
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <libasm/Diagnostic.hpp>
+#include <libasm/Microarchitecture.hpp>
+#include <libasm/SSA.hpp>
+
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Detects partial register stalls and false dependencies.
+ *
+ * Reported are:
+ * <ul>
+ *   <li>reads of a register whose reaching definition only wrote a part of it
+ *       (e.g. writing ah, then reading rax), which requires a merge</li>
+ *   <li>partial register writes that depend on the previous value of the
+ *       full register on uarchs that do not rename partial registers</li>
+ *   <li>popcnt, lzcnt and tzcnt false output dependencies</li>
+ *   <li>legacy SSE scalar instructions merging into a destination that was
+ *       not zeroed before (e.g. cvtsi2sd, sqrtss)</li>
+ * </ul>
+ *
+ * Reaching definitions of read registers are taken from the SSA def-use
+ * chains, and the previous definition of a destination is tracked while
+ * walking each basic block once, front to back.
+ */
+class FalseDependencyAnalysis
+{
+public:
+	explicit FalseDependencyAnalysis(Microarchitecture uarch = Microarchitecture::Generic);
+
+	Microarchitecture microarchitecture() const noexcept { return traits_->id; }
+	void setMicroarchitecture(Microarchitecture uarch) noexcept { traits_ = &traitsOf(uarch); }
+
+	/**
+	 * Analyzes a single basic block, appending its findings to @p diagnostics.
+	 */
+	void analyze(BasicBlock& bb, std::vector<Diagnostic>& diagnostics) const;
+
+	/**
+	 * Analyzes all basic blocks of the given function.
+	 */
+	std::vector<Diagnostic> analyze(const FunctionDefinition& function) const;
+
+private:
+	bool hasOutputDependency(const CpuInstr& instr) const;
+
+	const MicroarchitectureTraits* traits_;
+};
+
+}
@@ -0,0 +1,210 @@
+#include <libasm/FileWatcher.hpp>
+
+#include <chrono>
+#include <filesystem>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace asmlsp
+{
+
+namespace
+{
+	/** Events are delivered once no new one arrived for this long. */
+	constexpr int QuietPeriodMs = 100;
+
+	/** Upper bound on how long a stream of events may be held back. */
+	constexpr auto MaxBatchDelay = std::chrono::seconds(1);
+}
+
+#if defined(__linux__)
+FileWatcher::FileWatcher(std::string root, Callback callback):
+	root_{std::move(root)},
+	callback_{std::move(callback)},
+	fd_{inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}
+{
+	if (fd_ < 0)
+		return;
+
+	addWatches(root_);
+	thread_ = std::thread([this]() { run(); });
+}
+
+FileWatcher::~FileWatcher()
+{
+	stop_ = true;
+	if (thread_.joinable())
+		thread_.join();
+	if (fd_ >= 0)
+		close(fd_);
+}
+
+void FileWatcher::addWatches(const std::string& directory, std::vector<FileEvent>* created)
+{
+	constexpr uint32_t Mask = IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+	int const wd = inotify_add_watch(fd_, directory.c_str(), Mask);
+	if (wd < 0)
+		return;
+	Directory& watched = directories_[wd];
+	watched.path = directory;
+
+	std::error_code ec;
+	for (auto i = std::filesystem::directory_iterator(directory, std::filesystem::directory_options::skip_permission_denied, ec);
+		 !ec && i != std::filesystem::directory_iterator(); i.increment(ec))
+	{
+		std::string name = i->path().filename().string();
+		if (i->is_directory(ec) && !i->is_symlink(ec))
+		{
+			if (name.front() != '.') // .git and friends
+				addWatches(i->path().string(), created);
+		}
+		else if (watched.files.insert(name).second && created)
+			created->push_back(FileEvent{directory + "/" + name, FileChangeType::Created});
+	}
+}
+
+void FileWatcher::removeWatches(const std::string& directory, std::vector<FileEvent>& deleted)
+{
+	std::string const prefix = directory + "/";
+	for (auto i = directories_.begin(); i != directories_.end();)
+	{
+		std::string const& path = i->second.path;
+		if (path != directory && path.compare(0, prefix.size(), prefix) != 0)
+		{
+			++i;
+			continue;
+		}
+
+		for (std::string const& name: i->second.files)
+			deleted.push_back(FileEvent{path + "/" + name, FileChangeType::Deleted});
+		inotify_rm_watch(fd_, i->first); // fails harmlessly if already gone with the directory
+		i = directories_.erase(i);
+	}
+}
+
+void FileWatcher::rescan(std::vector<FileEvent>& batch)
+{
+	std::set<std::string> known;
+	for (auto const& [wd, directory]: directories_)
+	{
+		for (std::string const& name: directory.files)
+			known.insert(directory.path + "/" + name);
+		inotify_rm_watch(fd_, wd);
+	}
+	directories_.clear();
+
+	// whatever existed before may have changed unnoticed
+	std::vector<FileEvent> found;
+	addWatches(root_, &found);
+	for (FileEvent& event: found)
+	{
+		if (known.erase(event.path))
+			event.type = FileChangeType::Changed;
+		batch.push_back(std::move(event));
+	}
+	for (std::string const& path: known)
+		batch.push_back(FileEvent{path, FileChangeType::Deleted});
+}
+
+void FileWatcher::run()
+{
+	std::vector<FileEvent> batch;
+	auto batchStart = std::chrono::steady_clock::now();
+	alignas(inotify_event) char buffer[64 * 1024];
+
+	while (!stop_)
+	{
+		pollfd pfd{fd_, POLLIN, 0};
+		int const ready = poll(&pfd, 1, QuietPeriodMs);
+
+		if (ready > 0)
+		{
+			if (batch.empty())
+				batchStart = std::chrono::steady_clock::now();
+
+			ssize_t length;
+			while ((length = read(fd_, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* p = buffer; p < buffer + length;)
+				{
+					auto const* event = reinterpret_cast<const inotify_event*>(p);
+					p += sizeof(inotify_event) + event->len;
+
+					if (event->mask & IN_Q_OVERFLOW)
+					{
+						rescan(batch);
+						continue;
+					}
+
+					auto const directory = directories_.find(event->wd);
+					if (directory == directories_.end())
+						continue;
+					if (event->mask & IN_IGNORED)
+					{
+						// the watched directory is gone, e.g. removed along with the tree
+						std::string const gone = directory->second.path;
+						removeWatches(gone, batch);
+						continue;
+					}
+					if (event->len == 0)
+						continue;
+
+					std::string name = event->name;
+					std::string path = directory->second.path + "/" + name;
+
+					if (event->mask & IN_ISDIR)
+					{
+						if (name.front() == '.')
+							continue;
+						if (event->mask & (IN_CREATE | IN_MOVED_TO))
+							addWatches(path, &batch);
+						else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+							removeWatches(path, batch);
+						continue;
+					}
+
+					FileChangeType type = FileChangeType::Changed;
+					if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+					{
+						type = FileChangeType::Deleted;
+						directory->second.files.erase(name);
+					}
+					else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+					{
+						type = FileChangeType::Created;
+						directory->second.files.insert(std::move(name));
+					}
+					batch.push_back(FileEvent{std::move(path), type});
+				}
+			}
+		}
+
+		bool const quiet = ready == 0;
+		if (!batch.empty() && (quiet || std::chrono::steady_clock::now() - batchStart >= MaxBatchDelay))
+		{
+			callback_(std::move(batch));
+			batch.clear();
+		}
+	}
+}
+#else
+FileWatcher::FileWatcher(std::string root, Callback callback):
+	root_{std::move(root)},
+	callback_{std::move(callback)}
+{
+}
+
+FileWatcher::~FileWatcher() = default;
+
+void FileWatcher::addWatches(const std::string&, std::vector<FileEvent>*) {}
+void FileWatcher::removeWatches(const std::string&, std::vector<FileEvent>&) {}
+void FileWatcher::rescan(std::vector<FileEvent>&) {}
+void FileWatcher::run() {}
+#endif
+
+}
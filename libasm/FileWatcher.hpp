@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Kind of a file system change, numbered like LSP's FileChangeType.
+ */
+enum class FileChangeType : uint8_t
+{
+	Created = 1,
+	Changed = 2,
+	Deleted = 3,
+};
+
+/**
+ * A change of a single file, as reported by workspace/didChangeWatchedFiles
+ * or by a FileWatcher.
+ */
+struct FileEvent
+{
+	std::string path;
+	FileChangeType type;
+};
+
+/**
+ * Watches a directory tree for changes, for when the server runs standalone
+ * rather than relying on the client's workspace/didChangeWatchedFiles.
+ *
+ * Uses inotify on Linux and is inactive elsewhere. Events are collected
+ * until none arrived for a short while, so that a branch switch touching
+ * thousands of files is reported as a few batches rather than one call per
+ * file. The callback is invoked on the watcher's own thread.
+ *
+ * Directories created or moved into the tree report the files they already
+ * contain as created, and directories deleted or moved out of it report their
+ * files as deleted. Should the kernel's event queue overflow, the whole tree
+ * is rescanned and every file reported.
+ */
+class FileWatcher
+{
+public:
+	using Callback = std::function<void(std::vector<FileEvent> events)>;
+
+	FileWatcher(std::string root, Callback callback);
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	/** Tests whether changes are actually watched on this platform. */
+	bool active() const noexcept { return fd_ >= 0; }
+
+private:
+	struct Directory
+	{
+		std::string path;
+		std::set<std::string> files; //!< names of the files within, excluding subdirectories
+	};
+
+	/** Watches @p directory and its subdirectories, reporting their files through @p created if given. */
+	void addWatches(const std::string& directory, std::vector<FileEvent>* created = nullptr);
+
+	/** Stops watching @p directory and its subdirectories, reporting their files as deleted. */
+	void removeWatches(const std::string& directory, std::vector<FileEvent>& deleted);
+
+	/** Watches the tree anew after events were lost, reporting what may have changed. */
+	void rescan(std::vector<FileEvent>& batch);
+
+	void run();
+
+	std::string root_;
+	Callback callback_;
+	int fd_ = -1;
+	std::unordered_map<int, Directory> directories_; //!< by watch descriptor
+	std::atomic<bool> stop_ = false;
+	std::thread thread_;
+};
+
+}
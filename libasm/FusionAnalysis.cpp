@@ -0,0 +1,358 @@
+#include <libasm/FusionAnalysis.hpp>
+#include <libasm/InstructionDefinition.hpp>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace asmlsp
+{
+
+namespace
+{
+	/**
+	 * Condition codes in their encoding order.
+	 */
+	enum Condition : uint8_t
+	{
+		O, NO, B, AE, E, NE, BE, A, S, NS, P, NP, L, GE, LE, G
+	};
+
+	constexpr uint16_t bit(Condition cc) noexcept { return static_cast<uint16_t>(1u << cc); }
+
+	constexpr uint16_t AllConditions = 0xFFFF;
+	constexpr uint16_t ArithmeticConditions =
+		bit(B) | bit(AE) | bit(E) | bit(NE) | bit(BE) | bit(A) | bit(L) | bit(GE) | bit(LE) | bit(G);
+	constexpr uint16_t IncDecConditions = bit(E) | bit(NE) | bit(L) | bit(GE) | bit(LE) | bit(G);
+
+	enum class UnlaminationPolicy : uint8_t
+	{
+		Never,                       //!< memory operands never split at rename
+		Indexed,                     //!< indexed addressing always un-laminates
+		IndexedUnlessReadModifyWrite //!< indexed addressing un-laminates, except for 2-operand RMW destinations
+	};
+
+	struct MacroFusionRule
+	{
+		std::string_view mnemonic;
+		uint16_t conditions; //!< jcc conditions this instruction fuses with
+	};
+
+	struct FusionRules
+	{
+		std::vector<MacroFusionRule> macroFusion;
+		UnlaminationPolicy unlamination;
+	};
+
+	const FusionRules& rulesOf(Microarchitecture uarch)
+	{
+		static FusionRules const nehalem{
+			{{"cmp", ArithmeticConditions}, {"test", AllConditions}},
+			UnlaminationPolicy::Never};
+		static FusionRules const sandyBridge{
+			{{"cmp", ArithmeticConditions}, {"add", ArithmeticConditions}, {"sub", ArithmeticConditions},
+			 {"test", AllConditions}, {"and", AllConditions}, {"inc", IncDecConditions}, {"dec", IncDecConditions}},
+			UnlaminationPolicy::Indexed};
+		static FusionRules const haswell{sandyBridge.macroFusion, UnlaminationPolicy::IndexedUnlessReadModifyWrite};
+		static FusionRules const zen2{{{"cmp", AllConditions}, {"test", AllConditions}}, UnlaminationPolicy::Never};
+		static FusionRules const zen4{
+			{{"cmp", AllConditions}, {"test", AllConditions}, {"add", AllConditions}, {"sub", AllConditions},
+			 {"and", AllConditions}, {"or", AllConditions}, {"xor", AllConditions}, {"inc", AllConditions},
+			 {"dec", AllConditions}},
+			UnlaminationPolicy::Never};
+
+		switch (uarch)
+		{
+			case Microarchitecture::Nehalem: return nehalem;
+			case Microarchitecture::Generic:
+			case Microarchitecture::SandyBridge: return sandyBridge;
+			case Microarchitecture::Haswell:
+			case Microarchitecture::Skylake:
+			case Microarchitecture::IceLake: return haswell;
+			case Microarchitecture::Zen2: return zen2;
+			case Microarchitecture::Zen4: return zen4;
+		}
+		return sandyBridge;
+	}
+
+	std::optional<Condition> conditionOf(std::string_view mnemonic)
+	{
+		static constexpr std::array<std::pair<std::string_view, Condition>, 30> conditions = {{
+			{"jo", O},    {"jno", NO},  {"jb", B},    {"jc", B},     {"jnae", B},  {"jae", AE},
+			{"jnb", AE},  {"jnc", AE},  {"je", E},    {"jz", E},     {"jne", NE},  {"jnz", NE},
+			{"jbe", BE},  {"jna", BE},  {"ja", A},    {"jnbe", A},   {"js", S},    {"jns", NS},
+			{"jp", P},    {"jpe", P},   {"jnp", NP},  {"jpo", NP},   {"jl", L},    {"jnge", L},
+			{"jge", GE},  {"jnl", GE},  {"jle", LE},  {"jng", LE},   {"jg", G},    {"jnle", G},
+		}};
+		for (auto const& [name, cc]: conditions)
+			if (name == mnemonic)
+				return cc;
+		return std::nullopt;
+	}
+
+	const MacroFusionRule* macroFusionRuleOf(const FusionRules& rules, const CpuInstr& instr)
+	{
+		for (auto const& rule: rules.macroFusion)
+			if (rule.mnemonic == instr.definition()->mnemonic())
+				return &rule;
+		return nullptr;
+	}
+
+	bool hasImmediate(const CpuInstr& instr)
+	{
+		for (Value const* operand: instr.operands())
+			if (dynamic_cast<const Constant*>(operand))
+				return true;
+		return false;
+	}
+
+	bool isConditionalBranch(const CpuInstr& instr)
+	{
+		return instr.definition() && instr.definition()->hasFlag(InstructionFlags::ConditionalBranch);
+	}
+
+	/**
+	 * Tests whether the given instruction is a pure load, store or address computation,
+	 * all of which are a single uop regardless of fusion.
+	 */
+	bool isPlainMove(const CpuInstr& instr)
+	{
+		std::string_view const mnemonic = instr.definition()->mnemonic();
+		return mnemonic == "lea" || mnemonic.substr(0, 3) == "mov" || mnemonic.substr(0, 4) == "vmov";
+	}
+
+	/** Tests whether @p instr reads the arithmetic flags, such as jcc, setcc, cmovcc or adc. */
+	bool readsFlags(const CpuInstr& instr)
+	{
+		std::string_view const mnemonic = instr.definition()->mnemonic();
+		return isConditionalBranch(instr) || mnemonic.substr(0, 3) == "set" || mnemonic.substr(0, 4) == "cmov"
+			|| mnemonic.substr(0, 5) == "pushf" || mnemonic == "adc" || mnemonic == "sbb" || mnemonic == "adcx"
+			|| mnemonic == "adox" || mnemonic == "rcl" || mnemonic == "rcr" || mnemonic == "lahf" || mnemonic == "cmc";
+	}
+
+	/**
+	 * Tests whether @p writer can be moved past all of @p between, i.e. none
+	 * of them reads flags, touches a register @p writer writes or writes one
+	 * it reads, or may store to the memory it reads.
+	 */
+	bool canMoveAfter(const CpuInstr& writer, const std::vector<const CpuInstr*>& between)
+	{
+		auto const uses = [](const std::vector<Register>& registers, Register reg) {
+			return std::any_of(registers.begin(), registers.end(), [&](Register r) { return r && r.family() == reg.family(); });
+		};
+
+		for (const CpuInstr* instr: between)
+		{
+			if (readsFlags(*instr))
+				return false;
+
+			for (Register const written: writer.outputRegisters())
+				if (uses(instr->outputRegisters(), written) || uses(instr->operandRegisters(), written))
+					return false;
+			for (Register const written: instr->outputRegisters())
+				if (uses(writer.operandRegisters(), written))
+					return false;
+
+			bool const load = isPlainMove(*instr) && !instr->outputRegisters().empty();
+			if (writer.memoryOperand() && instr->memoryOperand() && !load)
+				return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Why the given instruction can not macro-fuse with a following jcc of condition @p cc,
+	 * or nullptr if it can.
+	 */
+	const char* macroFusionObstacle(const FusionRules& rules, const CpuInstr& first, Condition cc)
+	{
+		const MacroFusionRule* rule = macroFusionRuleOf(rules, first);
+		if (!rule)
+			return "is not a fusible instruction";
+
+		if (!(rule->conditions & bit(cc)))
+			return "does not fuse with this branch condition";
+
+		if (first.memoryOperand())
+		{
+			std::string_view const mnemonic = first.definition()->mnemonic();
+			if (mnemonic != "cmp" && mnemonic != "test")
+				return "writes memory";
+			if (hasImmediate(first))
+				return "has both a memory and an immediate operand";
+		}
+
+		return nullptr;
+	}
+}
+
+FusionAnalysis::FusionAnalysis(Microarchitecture uarch): uarch_{uarch}
+{
+}
+
+void FusionAnalysis::setMicroarchitecture(Microarchitecture uarch)
+{
+	uarch_ = uarch;
+	info_.clear();
+}
+
+const FusionInfo* FusionAnalysis::infoOf(const Instr* instr) const
+{
+	auto const i = info_.find(instr);
+	return i != info_.end() ? &i->second : nullptr;
+}
+
+bool FusionAnalysis::isMacroFused(const Instr* instr) const
+{
+	const FusionInfo* info = infoOf(instr);
+	return info && info->macroFusion != MacroFusion::None;
+}
+
+std::vector<Diagnostic> FusionAnalysis::analyze(const FunctionDefinition& function)
+{
+	std::vector<Diagnostic> hints;
+	for (auto const& bb: function.basicBlocks())
+		analyze(*bb, hints);
+	return hints;
+}
+
+void FusionAnalysis::analyze(BasicBlock& bb, std::vector<Diagnostic>& hints)
+{
+	FusionRules const& rules = rulesOf(uarch_);
+	std::string const uarchName(traitsOf(uarch_).name);
+
+	auto const hint = [&](std::string message, const Instr& subject) {
+		hints.emplace_back(Diagnostic{Severity::Hint, "fusion", std::move(message), &subject});
+	};
+
+	const CpuInstr* previous = nullptr;
+	const CpuInstr* lastFlagWriter = nullptr;
+	std::vector<const CpuInstr*> sinceFlagWriter; // between lastFlagWriter and the current instruction
+
+	for (auto const& instr: bb.instructions())
+	{
+		auto const* cpu = dynamic_cast<const CpuInstr*>(instr.get());
+		if (!cpu || !cpu->definition())
+		{
+			previous = nullptr;
+			lastFlagWriter = nullptr;
+			sinceFlagWriter.clear();
+			continue;
+		}
+
+		FusionInfo& info = info_[cpu];
+		info = FusionInfo{};
+
+		// micro-fusion
+		if (cpu->memoryOperand() && !isPlainMove(*cpu))
+		{
+			AddressingMode const& address = *cpu->memoryOperand();
+			bool unlaminated = false;
+			switch (rules.unlamination)
+			{
+				case UnlaminationPolicy::Never: break;
+				case UnlaminationPolicy::Indexed:
+					unlaminated = address.isIndexed() || (address.ripRelative && hasImmediate(*cpu));
+					break;
+				case UnlaminationPolicy::IndexedUnlessReadModifyWrite:
+				{
+					// Legacy encoded forms are the destructive 2-operand ones (VEX forms are non-destructive).
+					// A partial write's merge operand is no read of the destination operand.
+					bool readModifyWrite = false;
+					if (cpu->definition()->encoding() == Encoding::Legacy && !cpu->outputRegisters().empty())
+					{
+						auto const& registers = cpu->operandRegisters();
+						for (size_t n = 0; n < registers.size(); ++n)
+							if (!cpu->isMergeOperand(n) && registers[n] && registers[n].family() == cpu->outputRegisters().front().family())
+								readModifyWrite = true;
+					}
+					unlaminated = (address.isIndexed() && !readModifyWrite)
+								  || (address.ripRelative && hasImmediate(*cpu));
+					break;
+				}
+			}
+			info.microFusion = unlaminated ? MicroFusion::Unlaminated : MicroFusion::Fused;
+			if (unlaminated)
+				hint(cpu->definition()->mnemonic() + " un-laminates on " + uarchName
+						 + (address.isIndexed() ? "; use a non-indexed address, e.g. by incrementing a pointer"
+												: "; RIP-relative addressing with an immediate can not stay fused"),
+					 *cpu);
+		}
+
+		// macro-fusion
+		if (isConditionalBranch(*cpu))
+		{
+			auto const cc = conditionOf(cpu->definition()->mnemonic());
+			if (cc && previous && previous == lastFlagWriter)
+			{
+				const char* obstacle = macroFusionObstacle(rules, *previous, *cc);
+				if (!obstacle)
+				{
+					info.macroFusion = MacroFusion::Second;
+					info.partner = previous;
+					FusionInfo& first = info_[previous];
+					first.macroFusion = MacroFusion::First;
+					first.partner = cpu;
+				}
+				else if (macroFusionRuleOf(rules, *previous))
+				{
+					hint(previous->definition()->mnemonic() + " can not macro-fuse with " + cpu->definition()->mnemonic()
+							 + " on " + uarchName + ", as it " + obstacle,
+						 *previous);
+				}
+			}
+			else if (cc && lastFlagWriter && !macroFusionObstacle(rules, *lastFlagWriter, *cc)
+					 && canMoveAfter(*lastFlagWriter, sinceFlagWriter))
+			{
+				hint("move " + lastFlagWriter->definition()->mnemonic() + " directly before "
+						 + cpu->definition()->mnemonic() + " to allow macro-fusion",
+					 *lastFlagWriter);
+			}
+		}
+
+		if (cpu->definition()->hasFlag(InstructionFlags::WritesFlags))
+		{
+			lastFlagWriter = cpu;
+			sinceFlagWriter.clear();
+		}
+		else if (lastFlagWriter)
+			sinceFlagWriter.push_back(cpu);
+
+		previous = cpu;
+	}
+}
+
+std::string FusionAnalysis::describe(const FusionInfo& info)
+{
+	std::string text;
+
+	switch (info.macroFusion)
+	{
+		case MacroFusion::First:
+			text = "macro-fused with the following " + info.partner->definition()->mnemonic();
+			break;
+		case MacroFusion::Second:
+			text = "macro-fused with the preceding " + info.partner->definition()->mnemonic();
+			break;
+		case MacroFusion::None: break;
+	}
+
+	auto const append = [&](const char* s) {
+		if (!text.empty())
+			text += "; ";
+		text += s;
+	};
+
+	switch (info.microFusion)
+	{
+		case MicroFusion::Fused: append("load-op micro-fused"); break;
+		case MicroFusion::Unlaminated: append("un-laminated (2 fused-domain uops)"); break;
+		case MicroFusion::NotApplicable: break;
+	}
+
+	return text;
+}
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <libasm/Diagnostic.hpp>
+#include <libasm/Microarchitecture.hpp>
+#include <libasm/SSA.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Role of an instruction in a macro-fused compare-and-branch pair.
+ */
+enum class MacroFusion : uint8_t
+{
+	None,
+	First,  //!< flag producing instruction (cmp, test, ...) fused with the following jcc
+	Second, //!< conditional branch fused with the preceding instruction
+};
+
+/**
+ * Micro-fusion state of an instruction with a memory operand.
+ */
+enum class MicroFusion : uint8_t
+{
+	NotApplicable, //!< no load-op or store form
+	Fused,         //!< load and operation stay a single fused-domain uop
+	Unlaminated,   //!< micro-fused in the decoders, but split again at rename
+};
+
+/**
+ * Fusion facts about a single instruction.
+ */
+struct FusionInfo
+{
+	MacroFusion macroFusion = MacroFusion::None;
+	const CpuInstr* partner = nullptr; //!< the other instruction of a macro-fused pair
+	MicroFusion microFusion = MicroFusion::NotApplicable;
+};
+
+/**
+ * Determines which adjacent instructions macro-fuse and which load-op forms
+ * micro-fuse or un-laminate on a given microarchitecture.
+ *
+ * The results are kept per instruction for the throughput model, alignment
+ * diagnostics and hover. Missed fusion opportunities are reported as hints.
+ */
+class FusionAnalysis
+{
+public:
+	explicit FusionAnalysis(Microarchitecture uarch = Microarchitecture::Generic);
+
+	Microarchitecture microarchitecture() const noexcept { return uarch_; }
+
+	/**
+	 * Changes the target microarchitecture, discarding all previous results.
+	 */
+	void setMicroarchitecture(Microarchitecture uarch);
+
+	/**
+	 * (Re-)analyzes a single basic block, appending hints to @p hints.
+	 */
+	void analyze(BasicBlock& bb, std::vector<Diagnostic>& hints);
+
+	/**
+	 * Analyzes all basic blocks of the given function.
+	 */
+	std::vector<Diagnostic> analyze(const FunctionDefinition& function);
+
+	/**
+	 * Retrieves the fusion facts of the given instruction, or nullptr if it was not analyzed.
+	 */
+	const FusionInfo* infoOf(const Instr* instr) const;
+
+	bool isMacroFused(const Instr* instr) const;
+
+	/**
+	 * Discards all results, e.g. after the instructions they refer to have been destroyed.
+	 */
+	void clear() { info_.clear(); }
+
+	/**
+	 * Describes the given fusion facts as a single line suitable for hover.
+	 */
+	static std::string describe(const FusionInfo& info);
+
+private:
+	Microarchitecture uarch_;
+	std::unordered_map<const Instr*, FusionInfo> info_;
+};
+
+}
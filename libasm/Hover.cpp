@@ -0,0 +1,213 @@
+#include <libasm/Hover.hpp>
+#include <libasm/InstructionDefinition.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace asmlsp
+{
+
+namespace
+{
+	/** Line of @p instr, or of its basic block's label for synthetic instructions such as phis. */
+	unsigned lineOf(const HoverContext& context, const Value& value)
+	{
+		Value const* located = &value;
+		if (auto const* instr = dynamic_cast<const Instr*>(&value); instr && value.sourceRange().empty() && instr->getBasicBlock())
+			located = instr->getBasicBlock();
+		return context.lines.positionOf(context.index.currentRange(located->sourceRange()).begin).line + 1;
+	}
+
+	/** First line of the source text of @p value, trimmed. */
+	std::string_view textOf(const HoverContext& context, const Value& value)
+	{
+		SourceRange const range = context.index.currentRange(value.sourceRange());
+		if (range.end > context.source.size())
+			return {};
+
+		std::string_view text = context.source.substr(range.begin, range.length());
+		text = text.substr(0, text.find('\n'));
+		while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+			text.remove_prefix(1);
+		while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+			text.remove_suffix(1);
+		return text;
+	}
+
+	std::string formatRange(const KnownRange& range)
+	{
+		char buf[64];
+		if (range.isConstant())
+			std::snprintf(buf, sizeof(buf), "%" PRId64 " (0x%" PRIx64 ")", range.min, static_cast<uint64_t>(range.min));
+		else
+			std::snprintf(buf, sizeof(buf), "%" PRId64 " .. %" PRId64, range.min, range.max);
+		return buf;
+	}
+
+	std::string formOf(Register reg)
+	{
+		switch (reg.kind())
+		{
+			case RegisterKind::GP8Low:
+			case RegisterKind::GP8High: return "r8";
+			case RegisterKind::GP16: return "r16";
+			case RegisterKind::GP32: return "r32";
+			case RegisterKind::GP64: return "r64";
+			case RegisterKind::XMM: return "xmm";
+			case RegisterKind::YMM: return "ymm";
+			case RegisterKind::ZMM: return "zmm";
+			case RegisterKind::Mask: return "k";
+			case RegisterKind::None: break;
+		}
+		return "?";
+	}
+}
+
+std::optional<std::string> registerHover(const HoverContext& context, const PositionIndex::Match& match)
+{
+	auto const* instr = dynamic_cast<const CpuInstr*>(match.node);
+	if (!instr || match.operand < 0)
+		return std::nullopt;
+
+	size_t const n = static_cast<size_t>(match.operand);
+	if (n >= instr->operandRegisters().size() || !instr->operandRegisters()[n])
+		return std::nullopt;
+
+	Register const reg = instr->operandRegisters()[n];
+	Value const* value = instr->operand(n);
+
+	std::string md = "**" + reg.name() + "** (" + std::to_string(reg.width()) + " bit)\n\n";
+
+	if (auto const* phi = dynamic_cast<const PhiNode*>(value))
+		md += "Merged from " + std::to_string(phi->operands().size()) + " definitions in `"
+			+ phi->getBasicBlock()->name() + "`";
+	else if (dynamic_cast<const RegisterArgument*>(value))
+		md += "Live on entry";
+	else if (value && !value->sourceRange().empty())
+		md += "Defined by `" + std::string(textOf(context, *value)) + "` on line " + std::to_string(lineOf(context, *value));
+	md += "\n";
+
+	if (UninitializedRead const* read = context.uninitialized ? context.uninitialized->readAt(*instr, n) : nullptr)
+	{
+		md += std::string("\n") + (read->definite ? "Uninitialized" : "Possibly uninitialized") + " along `" + describePath(*read) + "`";
+		if (read->clobber)
+			md += ", not preserved by the call on line " + std::to_string(lineOf(context, *read->clobber));
+		md += "\n";
+	}
+
+	ValueInfo const* info = value ? context.facts.infoOf(value) : nullptr;
+	if (!info)
+		return md;
+
+	md += "\n";
+	if (info->range)
+		md += "- value: " + formatRange(*info->range) + "\n";
+
+	md += "- " + std::to_string(info->useCount) + (info->useCount == 1 ? " use" : " uses");
+	if (info->lastInstr)
+	{
+		md += ", live ";
+		md += info->firstInstr
+			? "from line " + std::to_string(lineOf(context, *info->firstInstr))
+			: std::string("from entry");
+		md += " to line " + std::to_string(lineOf(context, *info->lastInstr));
+	}
+	md += "\n";
+
+	if (info->carriedLoop)
+		md += "- carried around the loop at `" + info->carriedLoop->name() + "`\n";
+
+	return md;
+}
+
+std::string operandForm(const CpuInstr& instr)
+{
+	InstructionDefinition const* def = instr.definition();
+	auto const& outputs = instr.outputRegisters();
+	auto const& registers = instr.operandRegisters();
+	auto const& ranges = instr.operandRanges();
+
+	std::vector<std::string> forms;
+	if (!outputs.empty())
+		forms.push_back(formOf(outputs.front()));
+
+	std::string memory;
+	if (instr.memoryOperand())
+	{
+		unsigned const width = def && def->memoryWidth() ? def->memoryWidth() : !outputs.empty() ? outputs.front().width() : 0;
+		memory = width ? "m" + std::to_string(width) : "m";
+		if (outputs.empty())
+			forms.push_back(memory); // store
+	}
+
+	// legacy encodings read their destination as first source
+	bool skipDestination = def && def->encoding() == Encoding::Legacy && !outputs.empty();
+
+	// registers read to form the address are not operands of their own
+	std::vector<Register> addressRegisters;
+	if (instr.memoryOperand())
+		for (Register const reg: {instr.memoryOperand()->base, instr.memoryOperand()->index})
+			if (reg)
+				addressRegisters.push_back(reg);
+
+	std::vector<std::string> immediates;
+	for (size_t n = 0; n + instr.mergeOperandCount() < instr.operands().size(); ++n)
+	{
+		if (n < registers.size() && registers[n])
+		{
+			auto const address = std::find(addressRegisters.begin(), addressRegisters.end(), registers[n]);
+			if (skipDestination && registers[n] == outputs.front())
+				skipDestination = false;
+			else if (address != addressRegisters.end())
+				addressRegisters.erase(address);
+			else
+				forms.push_back(formOf(registers[n]));
+		}
+		else if (n >= ranges.size() || !ranges[n].empty())
+			immediates.push_back("imm"); // operands not written explicitly are resolved load constants
+	}
+
+	if (!memory.empty() && !outputs.empty())
+		forms.push_back(memory);
+	forms.insert(forms.end(), immediates.begin(), immediates.end());
+
+	std::string result;
+	for (std::string const& form: forms)
+		result += (result.empty() ? "" : ", ") + form;
+	return result;
+}
+
+std::string instructionHover(const HoverContext& context, const CpuInstr& instr, const InstructionDocs& docs, Microarchitecture uarch)
+{
+	InstructionDefinition const* def = instr.definition();
+	if (!def)
+		return {};
+
+	std::string md = "**" + def->mnemonic() + "** `" + operandForm(instr) + "`\n\n";
+	md += "Encoding: " + std::string(nameOf(def->encoding())) + ", extension: " + std::string(nameOf(def->extension())) + "\n";
+
+	if (FusionInfo const* fusion = context.fusion ? context.fusion->infoOf(&instr) : nullptr)
+		if (std::string const text = FusionAnalysis::describe(*fusion); !text.empty())
+			md += "Fusion: " + text + "\n";
+
+	if (auto const text = docs.text(def->id()))
+		md += "\n" + *text + "\n";
+
+	std::vector<InstructionTiming> const timings = docs.timings(def->id());
+	if (!timings.empty())
+	{
+		md += "\n| uarch | latency | throughput |\n|---|---|---|\n";
+		for (InstructionTiming const& t: timings)
+		{
+			char throughput[16];
+			std::snprintf(throughput, sizeof(throughput), "%.2f", t.reciprocalThroughput());
+			std::string const name(traitsOf(t.uarch).name);
+			md += "| " + (t.uarch == uarch ? "**" + name + "**" : name) + " | " + std::to_string(t.latency) + " | " + throughput + " |\n";
+		}
+	}
+
+	return md;
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <libasm/FusionAnalysis.hpp>
+#include <libasm/InstructionDocs.hpp>
+#include <libasm/Microarchitecture.hpp>
+#include <libasm/PositionIndex.hpp>
+#include <libasm/SourceLocation.hpp>
+#include <libasm/UninitializedRegisterAnalysis.hpp>
+#include <libasm/ValueFacts.hpp>
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace asmlsp
+{
+
+/**
+ * Everything a hover is built from: the current text and cached analyses.
+ */
+struct HoverContext
+{
+	std::string_view source;
+	const LineTable& lines;
+	const PositionIndex& index;
+	const ValueFacts& facts;
+	const UninitializedRegisterAnalysis* uninitialized = nullptr; //!< to show offending paths of uninitialized reads
+	const FusionAnalysis* fusion = nullptr;                       //!< to show macro- and micro-fusion of instructions
+};
+
+/**
+ * Builds the markdown hover for the register operand under the cursor.
+ *
+ * Shows the defining instruction, and if the function's ValueFacts are
+ * available, the known value range, number of uses, live range and the loop
+ * the value is carried around, and the offending path of a read that may be
+ * uninitialized. Nothing is computed on demand: for functions not analyzed
+ * yet, the hover is limited to what the IR provides directly.
+ *
+ * @returns nothing if @p match is not on a register operand.
+ */
+std::optional<std::string> registerHover(const HoverContext& context, const PositionIndex::Match& match);
+
+/**
+ * Renders the operand form of this specific use of an instruction, such as
+ * "ymm, ymm, m256" for vaddps ymm0, ymm1, [rdi].
+ */
+std::string operandForm(const CpuInstr& instr);
+
+/**
+ * Builds the markdown hover for an instruction: its operand form, encoding,
+ * required extension, fusion if analyzed, documentation and timings,
+ * @p uarch highlighted.
+ */
+std::string instructionHover(const HoverContext& context, const CpuInstr& instr, const InstructionDocs& docs, Microarchitecture uarch);
+
+}
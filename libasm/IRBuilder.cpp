@@ -0,0 +1,268 @@
+#include <libasm/IRBuilder.hpp>
+#include <libasm/InstructionDefinition.hpp>
+
+#include <algorithm>
+
+namespace asmlsp
+{
+
+namespace
+{
+	/**
+	 * Tests whether the given instruction form with the given registers is a
+	 * zero or ones idiom, i.e. independent of its operands' previous values.
+	 */
+	bool isIdiom(const InstructionDefinition* def,
+				 const std::vector<Register>& outputs,
+				 const std::vector<Register>& inputs,
+				 const std::vector<Value*>& immediates,
+				 const std::optional<AddressingMode>& memory)
+	{
+		if (!def || !(def->hasFlag(InstructionFlags::ZeroIdiom) || def->hasFlag(InstructionFlags::OnesIdiom)))
+			return false;
+
+		if (outputs.empty() || inputs.empty() || !immediates.empty() || memory)
+			return false;
+
+		// xor al, al still merges into rax, so it depends on rax's previous value.
+		if (outputs.front().isPartial())
+			return false;
+
+		// Legacy forms read their destination, so every operand must name it
+		// exactly (xor al, ah or xor eax, ax are no idioms). VEX and EVEX forms
+		// only need equal sources, as in vpxor xmm0, xmm1, xmm1.
+		bool const destructive = def->encoding() == Encoding::Legacy;
+		if (!destructive && inputs.size() < 2)
+			return false;
+
+		Register const source = destructive ? outputs.front() : inputs.front();
+		return std::all_of(inputs.begin(), inputs.end(), [&](Register input) { return input == source; });
+	}
+}
+
+IRBuilder::IRBuilder(FunctionDefinition* function, ConstantPool& constants):
+	function_{function},
+	constants_{constants}
+{
+}
+
+IRBuilder::~IRBuilder() = default;
+
+BasicBlock* IRBuilder::createBlock(std::string name)
+{
+	BasicBlock* bb = function_->push_back(std::make_unique<BasicBlock>(std::move(name), *function_));
+	if (!insertPoint_)
+		insertPoint_ = bb;
+	return bb;
+}
+
+void IRBuilder::sealBlock(BasicBlock* bb)
+{
+	if (!sealed_.insert(bb).second)
+		return;
+
+	auto i = incompletePhis_.find(bb);
+	if (i == incompletePhis_.end())
+		return;
+
+	auto const phis = std::move(i->second);
+	incompletePhis_.erase(i);
+
+	for (auto const& [phi, reg]: phis)
+		addPhiOperands(phi, reg);
+}
+
+CpuInstr* IRBuilder::createCpuInstr(InstructionDefinition* def,
+									std::vector<Register> outputs,
+									std::vector<Register> inputs,
+									std::vector<Value*> immediates,
+									std::optional<AddressingMode> memory,
+									std::string name)
+{
+	bool const idiom = isIdiom(def, outputs, inputs, immediates, memory);
+
+	std::vector<Value*> operands;
+	std::vector<Register> operandRegisters;
+
+	if (!idiom)
+	{
+		for (Register const input: inputs)
+		{
+			operands.push_back(readRegister(insertPoint_, input));
+			operandRegisters.push_back(input);
+		}
+	}
+
+	for (Value* immediate: immediates)
+	{
+		operands.push_back(immediate);
+		operandRegisters.emplace_back();
+	}
+
+	// A register load from read-only data yields a known constant.
+	if (memory && constantResolver_ && !outputs.empty())
+	{
+		unsigned const width = def && def->memoryWidth() ? def->memoryWidth() : outputs.front().width();
+		if (Constant* constant = constantResolver_(*memory, width))
+		{
+			operands.push_back(constant);
+			operandRegisters.emplace_back();
+		}
+	}
+
+	// A partial write keeps the remaining bits of its physical register, so
+	// the result also depends on the register's previous value, unless that
+	// is read anyway (as in add al, 1).
+	size_t merges = 0;
+	for (Register const output: outputs)
+	{
+		auto const read = [&](Register input) { return input.family() == output.family(); };
+		if (!output.isPartial() || std::any_of(inputs.begin(), inputs.end(), read)
+			|| std::any_of(operandRegisters.end() - merges, operandRegisters.end(), read))
+			continue;
+		operands.push_back(readRegister(insertPoint_, output));
+		operandRegisters.push_back(output);
+		++merges;
+	}
+
+	auto instr = std::make_unique<CpuInstr>(def, std::move(operands), std::move(name));
+	CpuInstr* cpu = instr.get();
+	cpu->setRegisters(outputs, std::move(operandRegisters));
+	cpu->setMergeOperandCount(merges);
+	cpu->setMemoryOperand(std::move(memory));
+	cpu->setDependencyBreaking(idiom);
+	insertPoint_->push_back(std::move(instr));
+
+	for (Register const output: outputs)
+		writeRegister(insertPoint_, output, cpu);
+
+	return cpu;
+}
+
+CallInstr* IRBuilder::createCall(std::string label, FunctionDefinition* callee)
+{
+	auto call = std::make_unique<CallInstr>(std::move(label), callee, std::vector<Value*>{}, "");
+	CallInstr* result = call.get();
+	insertPoint_->push_back(std::move(call));
+	return result;
+}
+
+void IRBuilder::writeRegister(BasicBlock* bb, Register reg, Value* value)
+{
+	currentDef_[bb][reg.family()] = value;
+}
+
+Value* IRBuilder::readRegister(BasicBlock* bb, Register reg)
+{
+	auto i = currentDef_.find(bb);
+	if (i != currentDef_.end())
+	{
+		if (Value*& value = i->second[reg.family()]; value)
+			return value = resolve(value);
+	}
+
+	return readRegisterRecursive(bb, reg);
+}
+
+Value* IRBuilder::readRegisterRecursive(BasicBlock* bb, Register reg)
+{
+	bool const isEntry = bb == function_->entryBlock();
+	Value* value = nullptr;
+
+	if (!sealed_.count(bb))
+	{
+		// Not all predecessors are known yet.
+		PhiNode* phi = createPhi(bb, reg);
+		incompletePhis_[bb].emplace_back(phi, reg);
+		value = phi;
+	}
+	else if (bb->predecessors().empty() && isEntry)
+	{
+		value = function_->argument(reg);
+	}
+	else if (bb->predecessors().size() == 1 && !isEntry)
+	{
+		value = readRegister(bb->predecessors().front(), reg);
+	}
+	else
+	{
+		// Break potential cycles with an operandless phi first.
+		PhiNode* phi = createPhi(bb, reg);
+		writeRegister(bb, reg, phi);
+		value = addPhiOperands(phi, reg);
+	}
+
+	writeRegister(bb, reg, value);
+	return value;
+}
+
+Value* IRBuilder::addPhiOperands(PhiNode* phi, Register reg)
+{
+	BasicBlock* bb = phi->getBasicBlock();
+
+	if (bb == function_->entryBlock())
+		phi->addOperand(function_->argument(reg));
+
+	for (BasicBlock* pred: bb->predecessors())
+		phi->addOperand(readRegister(pred, reg));
+
+	return tryRemoveTrivialPhi(phi);
+}
+
+Value* IRBuilder::tryRemoveTrivialPhi(PhiNode* phi)
+{
+	Value* same = nullptr;
+	for (Value* op: phi->operands())
+	{
+		if (op == same || op == phi)
+			continue; // unique value or self-reference
+		if (same)
+			return phi; // merges at least two values: not trivial
+		same = op;
+	}
+
+	auto const reg = phiRegisters_.find(phi);
+	if (!same)
+		same = function_->argument(reg->second); // unreachable or only self-referencing
+	phiRegisters_.erase(reg);
+
+	std::vector<Instr*> users;
+	for (Instr* user: phi->uses())
+		if (user != phi)
+			users.push_back(user);
+
+	phi->clearOperands();
+	phi->replaceAllUsesWith(same);
+	replaced_[phi] = same;
+	graveyard_.emplace_back(phi->getBasicBlock()->remove(phi));
+
+	// Removing this phi may have made phis using it trivial, too.
+	for (Instr* user: users)
+		if (auto* userPhi = dynamic_cast<PhiNode*>(user); userPhi && phiRegisters_.count(userPhi))
+			tryRemoveTrivialPhi(userPhi);
+
+	return resolve(same);
+}
+
+PhiNode* IRBuilder::createPhi(BasicBlock* bb, Register reg)
+{
+	auto phi = std::make_unique<PhiNode>(std::vector<Value*>{}, reg.name());
+	PhiNode* result = phi.get();
+	bb->push_back(std::move(phi));
+
+	// PhiNodes lead their basic block.
+	auto& code = bb->instructions();
+	std::rotate(code.begin(), std::prev(code.end()), code.end());
+
+	phiRegisters_[result] = reg;
+	return result;
+}
+
+Value* IRBuilder::resolve(Value* value) const
+{
+	for (auto i = replaced_.find(value); i != replaced_.end(); i = replaced_.find(value))
+		value = i->second;
+	return value;
+}
+
+}
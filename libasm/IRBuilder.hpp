@@ -0,0 +1,142 @@
+#pragma once
+
+#include <libasm/ConstantPool.hpp>
+#include <libasm/SSA.hpp>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Constructs the SSA form of a function while its instructions are parsed.
+ *
+ * Register reads are resolved to their reaching definitions on the fly,
+ * inserting PhiNodes at control flow merges as needed, following
+ * "Simple and Efficient Construction of Static Single Assignment Form"
+ * (Braun et al.). A basic block must be sealed via sealBlock() once all of
+ * its predecessors are linked.
+ *
+ * Values are tracked per physical register (see Register::family()), reads of
+ * registers that are not defined on some path resolve to the function's
+ * RegisterArgument. Partial writes (see Register::isPartial()) merge into the
+ * previous value of their physical register, which the writing instruction
+ * takes as an additional operand (see CpuInstr::mergeOperandCount()), so that
+ * a read of rax after mov al, 1 still depends on rax's previous value.
+ * Legacy SSE writes, which keep the upper lanes of ymm and zmm, are not
+ * modelled as merges.
+ */
+class IRBuilder
+{
+public:
+	/**
+	 * Resolves a load of @p width bits from the given address to the constant
+	 * stored there, or returns nullptr if the address does not refer to read-only data.
+	 */
+	using ConstantResolver = std::function<Constant*(const AddressingMode& address, unsigned width)>;
+
+	/**
+	 * @param function   function to construct
+	 * @param constants  module wide pool immediates are uniqued in
+	 */
+	IRBuilder(FunctionDefinition* function, ConstantPool& constants);
+	~IRBuilder();
+
+	FunctionDefinition* function() const noexcept { return function_; }
+
+	ConstantInt* getInt(int64_t value) { return constants_.getInt(value); }
+	ConstantUInt* getUInt(uint64_t value) { return constants_.getUInt(value); }
+
+	/**
+	 * Installs the resolver that maps loads from read-only data to constants.
+	 *
+	 * Resolved constants are appended to the loading instruction's operands,
+	 * just like immediates.
+	 */
+	void setConstantResolver(ConstantResolver resolver) { constantResolver_ = std::move(resolver); }
+
+	/**
+	 * Creates a new basic block, appended to the current function.
+	 */
+	BasicBlock* createBlock(std::string name);
+
+	void setInsertPoint(BasicBlock* bb) noexcept { insertPoint_ = bb; }
+	BasicBlock* getInsertPoint() const noexcept { return insertPoint_; }
+
+	/**
+	 * Declares that all predecessors of @p bb are linked, completing its pending PhiNodes.
+	 */
+	void sealBlock(BasicBlock* bb);
+
+	/**
+	 * Creates a CPU instruction at the current insert point.
+	 *
+	 * @param def        instruction form
+	 * @param outputs    registers written, the primary destination first
+	 * @param inputs     registers read, including those of the memory address
+	 * @param immediates constant operands (see getInt()), appended after the register operands
+	 * @param memory     the memory operand's address, if any
+	 *
+	 * Zero and ones idioms (such as xor eax, eax, pcmpeqd xmm0, xmm0 or
+	 * vpxor xmm0, xmm1, xmm1) are emitted as pure definitions without
+	 * operands, as their result does not depend on the previous register
+	 * contents. Partial writes such as xor al, al are no idioms, as they
+	 * merge into the rest of their register.
+	 */
+	CpuInstr* createCpuInstr(InstructionDefinition* def,
+							 std::vector<Register> outputs,
+							 std::vector<Register> inputs,
+							 std::vector<Value*> immediates = {},
+							 std::optional<AddressingMode> memory = std::nullopt,
+							 std::string name = "");
+
+	/**
+	 * Creates a call to the given label at the current insert point.
+	 *
+	 * @param callee resolved function, or nullptr if the label is external
+	 */
+	CallInstr* createCall(std::string label, FunctionDefinition* callee);
+
+	/**
+	 * Retrieves the SSA value the physical register of @p reg holds at the end of @p bb.
+	 */
+	Value* readRegister(BasicBlock* bb, Register reg);
+
+	/**
+	 * Records @p value as the current definition of @p reg's physical register in @p bb.
+	 */
+	void writeRegister(BasicBlock* bb, Register reg, Value* value);
+
+private:
+	using Definitions = std::array<Value*, Register::FamilyCount>;
+
+	Value* readRegisterRecursive(BasicBlock* bb, Register reg);
+	Value* addPhiOperands(PhiNode* phi, Register reg);
+	Value* tryRemoveTrivialPhi(PhiNode* phi);
+	PhiNode* createPhi(BasicBlock* bb, Register reg);
+	Value* resolve(Value* value) const;
+
+	FunctionDefinition* function_;
+	ConstantPool& constants_;
+	ConstantResolver constantResolver_;
+	BasicBlock* insertPoint_ = nullptr;
+	std::unordered_map<const BasicBlock*, Definitions> currentDef_;
+	std::unordered_map<const BasicBlock*, std::vector<std::pair<PhiNode*, Register>>> incompletePhis_;
+	std::unordered_set<const BasicBlock*> sealed_;
+	std::unordered_map<const PhiNode*, Register> phiRegisters_;
+
+	//! trivial PhiNodes that were replaced, and by what
+	std::unordered_map<const Value*, Value*> replaced_;
+
+	//! removed PhiNodes, kept alive so that their addresses are not reused while building
+	std::vector<std::unique_ptr<Instr>> graveyard_;
+};
+
+}
@@ -0,0 +1,139 @@
+#include <libasm/InlayHints.hpp>
+#include <libasm/InstructionDefinition.hpp>
+#include <libasm/StackAnalysis.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <functional>
+#include <optional>
+
+namespace asmlsp
+{
+
+namespace
+{
+	/** Keeps the cache bounded, cleared entirely once exceeded. */
+	constexpr size_t MaxCachedFunctions = 4096;
+
+	std::string formatPorts(uint16_t ports)
+	{
+		std::string text = "p";
+		for (unsigned port = 0; port < 16; ++port)
+			if (ports & (1u << port))
+				text += port < 10 ? static_cast<char>('0' + port) : static_cast<char>('A' + port - 10);
+		return text;
+	}
+
+	std::string formatValue(int64_t value)
+	{
+		char buf[32];
+		if (value >= -4096 && value <= 4096)
+			std::snprintf(buf, sizeof(buf), "%" PRId64, value);
+		else
+			std::snprintf(buf, sizeof(buf), "0x%" PRIx64, static_cast<uint64_t>(value));
+		return buf;
+	}
+
+	std::string formatOffset(int64_t offset)
+	{
+		return offset == 0 ? std::string("rsp+0") : offset > 0 ? "rsp+" + std::to_string(offset) : "rsp" + std::to_string(offset);
+	}
+
+	/** Source text of @p function, the range covering all its blocks if it has none itself. */
+	SourceRange functionRange(const PositionIndex& index, const FunctionDefinition& function)
+	{
+		if (!function.sourceRange().empty())
+			return index.currentRange(function.sourceRange());
+
+		SourceRange range{SIZE_MAX, 0};
+		for (auto const& bb: function.basicBlocks())
+		{
+			if (bb->sourceRange().empty())
+				continue;
+			SourceRange const r = index.currentRange(bb->sourceRange());
+			range.begin = std::min(range.begin, r.begin);
+			range.end = std::max(range.end, r.end);
+		}
+		return range.begin <= range.end ? range : SourceRange{};
+	}
+}
+
+std::vector<InlayHintCache::Hint> InlayHintCache::compute(const InlayHintContext& context, const FunctionDefinition& function, size_t base)
+{
+	std::unordered_map<const CpuInstr*, int64_t> const offsets = stackOffsets(function);
+	std::vector<Hint> hints;
+
+	for (auto const& bb: function.basicBlocks())
+	{
+		for (auto const& instr: bb->instructions())
+		{
+			auto const* cpu = dynamic_cast<const CpuInstr*>(instr.get());
+			if (!cpu || cpu->sourceRange().empty())
+				continue;
+
+			SourceRange const range = context.index.currentRange(cpu->sourceRange());
+			if (range.end < base)
+				continue;
+			size_t const offset = range.end - base;
+
+			if (cpu->definition())
+			{
+				if (auto const timing = context.docs.timing(cpu->definition()->id(), context.uarch))
+				{
+					std::string label = std::to_string(timing->latency) + "c";
+					if (timing->ports)
+						label += " " + formatPorts(timing->ports);
+					hints.push_back(Hint{offset, std::move(label), InlayHint::Type});
+				}
+			}
+
+			if (ValueInfo const* info = context.facts.infoOf(cpu); info && info->range && info->range->isConstant()
+				&& !cpu->outputRegisters().empty())
+				hints.push_back(Hint{offset, cpu->outputRegisters().front().name() + " = " + formatValue(info->range->min),
+									 InlayHint::Parameter});
+
+			if (auto const i = offsets.find(cpu); i != offsets.end())
+				hints.push_back(Hint{offset, formatOffset(i->second), InlayHint::Type});
+		}
+	}
+
+	std::stable_sort(hints.begin(), hints.end(), [](const Hint& a, const Hint& b) { return a.offset < b.offset; });
+	return hints;
+}
+
+std::vector<InlayHint> InlayHintCache::hints(const InlayHintContext& context, const FunctionDefinition& function, SourceRange range)
+{
+	std::vector<InlayHint> result;
+
+	SourceRange const extent = functionRange(context.index, function);
+	if (extent.empty() || extent.end > context.source.size() || extent.end <= range.begin || range.end < extent.begin)
+		return result;
+
+	// facts may arrive after the function was first shown
+	uint64_t const version = context.analysisVersion * 2 + (context.facts.contains(function) ? 1 : 0);
+	uint64_t const hash = std::hash<std::string_view>()(context.source.substr(extent.begin, extent.length()));
+
+	auto i = functions_.find(hash);
+	if (i == functions_.end() || i->second.version != version)
+	{
+		if (i == functions_.end() && functions_.size() >= MaxCachedFunctions)
+			functions_.clear();
+		Entry& entry = functions_[hash];
+		entry.version = version;
+		entry.hints = compute(context, function, extent.begin);
+		i = functions_.find(hash);
+	}
+
+	std::vector<Hint> const& hints = i->second.hints;
+	size_t const first = range.begin > extent.begin ? range.begin - extent.begin : 0;
+	size_t const last = range.end - extent.begin;
+	auto const begin = std::lower_bound(hints.begin(), hints.end(), first, [](const Hint& h, size_t o) { return h.offset < o; });
+
+	for (auto h = begin; h != hints.end() && h->offset <= last; ++h)
+		result.push_back(InlayHint{context.lines.positionOf(extent.begin + h->offset), h->label, h->kind});
+
+	return result;
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <libasm/InstructionDocs.hpp>
+#include <libasm/Microarchitecture.hpp>
+#include <libasm/PositionIndex.hpp>
+#include <libasm/SourceLocation.hpp>
+#include <libasm/ValueFacts.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * An annotation rendered inline after an instruction, modelled after LSP's InlayHint.
+ */
+struct InlayHint
+{
+	enum Kind
+	{
+		Type = 1,      //!< timing and stack offset
+		Parameter = 2, //!< known register value
+	};
+
+	Position position;
+	std::string label;
+	Kind kind;
+};
+
+/**
+ * Everything inlay hints are built from: the current text and cached analyses.
+ */
+struct InlayHintContext
+{
+	std::string_view source;
+	const LineTable& lines;
+	const PositionIndex& index;
+	const ValueFacts& facts;
+	const InstructionDocs& docs;
+	Microarchitecture uarch;
+	uint64_t analysisVersion; //!< changes whenever configuration or analyses change hint contents
+};
+
+/**
+ * Per instruction inlay hints: latency and execution ports on the configured
+ * microarchitecture, known constant values of destination registers, and
+ * the offset of rsp relative to its value on function entry.
+ *
+ * Hints of a function are computed once and cached, keyed by a hash of the
+ * function's source text and the analysis version. Positions are stored
+ * relative to the function, so editing text above it or scrolling reuses
+ * them; a request only selects and positions the hints of the requested range.
+ */
+class InlayHintCache
+{
+public:
+	/**
+	 * Retrieves the hints of @p function that lie within @p range.
+	 */
+	std::vector<InlayHint> hints(const InlayHintContext& context, const FunctionDefinition& function, SourceRange range);
+
+	void clear() { functions_.clear(); }
+
+	size_t size() const noexcept { return functions_.size(); }
+
+private:
+	struct Hint
+	{
+		size_t offset; //!< relative to the begin of the function
+		std::string label;
+		InlayHint::Kind kind;
+	};
+
+	struct Entry
+	{
+		uint64_t version;
+		std::vector<Hint> hints; //!< sorted by offset
+	};
+
+	static std::vector<Hint> compute(const InlayHintContext& context, const FunctionDefinition& function, size_t base);
+
+	std::unordered_map<uint64_t, Entry> functions_; //!< by content hash
+};
+
+}
@@ -0,0 +1,48 @@
+#include <libasm/InstructionDefinition.hpp>
+
+namespace asmlsp
+{
+
+std::string_view nameOf(Extension extension) noexcept
+{
+	switch (extension)
+	{
+		case Extension::Base: return "x86-64";
+		case Extension::X87: return "x87";
+		case Extension::MMX: return "MMX";
+		case Extension::SSE: return "SSE";
+		case Extension::SSE2: return "SSE2";
+		case Extension::SSE3: return "SSE3";
+		case Extension::SSSE3: return "SSSE3";
+		case Extension::SSE4_1: return "SSE4.1";
+		case Extension::SSE4_2: return "SSE4.2";
+		case Extension::AVX: return "AVX";
+		case Extension::AVX2: return "AVX2";
+		case Extension::FMA: return "FMA";
+		case Extension::F16C: return "F16C";
+		case Extension::AVX512F: return "AVX512F";
+		case Extension::AVX512BW: return "AVX512BW";
+		case Extension::AVX512DQ: return "AVX512DQ";
+		case Extension::AVX512VL: return "AVX512VL";
+		case Extension::AVX512CD: return "AVX512CD";
+		case Extension::AVX512VNNI: return "AVX512VNNI";
+		case Extension::BMI1: return "BMI1";
+		case Extension::BMI2: return "BMI2";
+		case Extension::LZCNT: return "LZCNT";
+		case Extension::POPCNT: return "POPCNT";
+	}
+	return "?";
+}
+
+std::string_view nameOf(Encoding encoding) noexcept
+{
+	switch (encoding)
+	{
+		case Encoding::Legacy: return "legacy";
+		case Encoding::VEX: return "VEX";
+		case Encoding::EVEX: return "EVEX";
+	}
+	return "?";
+}
+
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace asmlsp
+{
+
+/**
+ * Instruction set extension an instruction definition belongs to.
+ */
+enum class Extension : uint8_t
+{
+	Base,
+	X87,
+	MMX,
+	SSE,
+	SSE2,
+	SSE3,
+	SSSE3,
+	SSE4_1,
+	SSE4_2,
+	AVX,
+	AVX2,
+	FMA,
+	F16C,
+	AVX512F,
+	AVX512BW,
+	AVX512DQ,
+	AVX512VL,
+	AVX512CD,
+	AVX512VNNI,
+	BMI1,
+	BMI2,
+	LZCNT,
+	POPCNT,
+};
+
+/**
+ * Retrieves the common spelling of @p extension, such as "AVX512F" or "SSE4.1".
+ */
+std::string_view nameOf(Extension extension) noexcept;
+
+/**
+ * Encoding scheme of an instruction form.
+ */
+enum class Encoding : uint8_t
+{
+	Legacy, //!< legacy (REX) encoding, including legacy SSE
+	VEX,    //!< VEX prefixed (AVX, AVX2, FMA, BMI)
+	EVEX,   //!< EVEX prefixed (AVX-512)
+};
+
+std::string_view nameOf(Encoding encoding) noexcept;
+
+/**
+ * Semantic properties of an instruction form that analyses care about.
+ */
+enum class InstructionFlags : uint32_t
+{
+	None = 0,
+	Call = 1 << 0,              //!< transfers control to a callee and returns
+	Return = 1 << 1,            //!< returns from the current function
+	Branch = 1 << 2,            //!< unconditional jump
+	ConditionalBranch = 1 << 3, //!< conditional jump (jcc)
+	ClearsUpperVector = 1 << 4, //!< zeroes the upper halves of all vector registers (vzeroupper, vzeroall)
+	MergesDestination = 1 << 5, //!< preserves untouched destination bits, e.g. cvtsi2sd, sqrtss
+	OutputDependency = 1 << 6,  //!< waits for the destination's previous value on some uarchs, e.g. popcnt
+	WritesFlags = 1 << 7,       //!< modifies any of the arithmetic flags
+	ZeroIdiom = 1 << 8,         //!< yields zero when all register operands are the same, e.g. xor eax, eax
+	OnesIdiom = 1 << 9,         //!< yields all ones when all register operands are the same, e.g. pcmpeqd
+};
+
+constexpr InstructionFlags operator|(InstructionFlags a, InstructionFlags b) noexcept
+{
+	using U = std::underlying_type_t<InstructionFlags>;
+	return static_cast<InstructionFlags>(static_cast<U>(a) | static_cast<U>(b));
+}
+
+constexpr InstructionFlags operator&(InstructionFlags a, InstructionFlags b) noexcept
+{
+	using U = std::underlying_type_t<InstructionFlags>;
+	return static_cast<InstructionFlags>(static_cast<U>(a) & static_cast<U>(b));
+}
+
+/**
+ * Describes a single instruction form (mnemonic plus operand form) of the instruction set.
+ *
+ * Every CpuInstr in the SSA references the definition it is an instance of.
+ */
+class InstructionDefinition
+{
+public:
+	InstructionDefinition(uint32_t id,
+						  std::string mnemonic,
+						  Encoding encoding,
+						  Extension extension,
+						  unsigned vectorWidth,
+						  InstructionFlags flags = InstructionFlags::None,
+						  unsigned memoryWidth = 0):
+		id_{id},
+		mnemonic_{std::move(mnemonic)},
+		encoding_{encoding},
+		extension_{extension},
+		vectorWidth_{vectorWidth},
+		memoryWidth_{memoryWidth},
+		flags_{flags}
+	{
+	}
+
+	/**
+	 * Unique index of this definition within the instruction database.
+	 */
+	uint32_t id() const noexcept { return id_; }
+
+	const std::string& mnemonic() const noexcept { return mnemonic_; }
+	Encoding encoding() const noexcept { return encoding_; }
+	Extension extension() const noexcept { return extension_; }
+
+	/**
+	 * Width in bits of the widest vector register operand, or 0 if it has none.
+	 */
+	unsigned vectorWidth() const noexcept { return vectorWidth_; }
+
+	/**
+	 * Number of bits accessed by the memory operand, or 0 if it is the width of
+	 * the register operands (or there is no memory operand).
+	 */
+	unsigned memoryWidth() const noexcept { return memoryWidth_; }
+
+	InstructionFlags flags() const noexcept { return flags_; }
+	bool hasFlag(InstructionFlags flag) const noexcept { return (flags_ & flag) != InstructionFlags::None; }
+
+	/**
+	 * Tests whether this is a legacy encoded SSE instruction, i.e. one that
+	 * preserves the upper halves of the vector registers it writes.
+	 */
+	bool isLegacySSE() const noexcept
+	{
+		return encoding_ == Encoding::Legacy && extension_ >= Extension::SSE && extension_ <= Extension::SSE4_2;
+	}
+
+	/**
+	 * Tests whether this is a VEX or EVEX encoded instruction operating on 256 bit or wider vectors.
+	 */
+	bool isWideVector() const noexcept { return encoding_ != Encoding::Legacy && vectorWidth_ >= 256; }
+
+private:
+	uint32_t id_;
+	std::string mnemonic_;
+	Encoding encoding_;
+	Extension extension_;
+	unsigned vectorWidth_;
+	unsigned memoryWidth_;
+	InstructionFlags flags_;
+};
+
+}
@@ -0,0 +1,315 @@
+#include <libasm/InstructionDocs.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace asmlsp
+{
+
+namespace
+{
+	constexpr char Magic[4] = {'A', 'S', 'M', 'D'};
+
+	// word references 0..127 escape the non-ASCII bytes 0x80..0xff
+	constexpr uint32_t EscapedBytes = 128;
+	constexpr uint32_t MaxWords = 0x8000 - EscapedBytes;
+	constexpr size_t MinWordLength = 3;
+
+	bool isWordChar(char ch) noexcept
+	{
+		return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_';
+	}
+
+	/** Splits @p text into maximal words and calls @p word on each. */
+	template <typename F>
+	void forEachWord(std::string_view text, F word)
+	{
+		size_t i = 0;
+		while (i < text.size())
+		{
+			if (!isWordChar(text[i]))
+			{
+				++i;
+				continue;
+			}
+			size_t const begin = i;
+			while (i < text.size() && isWordChar(text[i]))
+				++i;
+			word(text.substr(begin, i - begin));
+		}
+	}
+
+	void put32(std::string& out, uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i)
+			out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+
+	void putReference(std::string& out, uint32_t index)
+	{
+		out.push_back(static_cast<char>(0x80 | (index >> 8)));
+		out.push_back(static_cast<char>(index & 0xff));
+	}
+}
+
+// {{{ InstructionDocs
+InstructionDocs::InstructionDocs(std::string_view blob):
+	blob_{blob}
+{
+	// Reads the next table, validating it fits into the blob.
+	size_t offset = 8;
+	auto const table = [&](size_t& count, size_t elementSize, size_t& start) {
+		if (offset + 4 > blob_.size())
+			return false;
+		count = read(offset);
+		start = offset + 4;
+		if ((blob_.size() - start) / elementSize < count)
+			return false;
+		offset = start + count * elementSize;
+		return true;
+	};
+
+	// Skips the data referenced by an offset table of count + 1 entries.
+	auto const data = [&](size_t count, size_t offsets, size_t& start) {
+		if (offsets + 4 * (count + 1) > blob_.size())
+			return false;
+		offset = offsets + 4 * (count + 1);
+		start = offset;
+		size_t const size = read(offsets + 4 * count);
+		if (size > blob_.size() - start)
+			return false;
+		offset += size;
+		return true;
+	};
+
+	bool const valid = blob_.size() >= 8
+		&& std::memcmp(blob_.data(), Magic, 4) == 0
+		&& read(4) == Version
+		&& table(wordCount_, 4, wordOffsets_) && data(wordCount_, wordOffsets_, words_)
+		&& table(textCount_, 4, textOffsets_) && data(textCount_, textOffsets_, texts_)
+		&& table(timingCount_, 8, timings_)
+		&& table(entryCount_, 16, entries_);
+
+	if (!valid)
+		*this = InstructionDocs{};
+}
+
+uint32_t InstructionDocs::read(size_t offset) const noexcept
+{
+	auto const* p = reinterpret_cast<const uint8_t*>(blob_.data() + offset);
+	return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+std::optional<InstructionDocs::Entry> InstructionDocs::find(uint32_t id) const
+{
+	size_t low = 0;
+	size_t high = entryCount_;
+	while (low < high)
+	{
+		size_t const mid = (low + high) / 2;
+		uint32_t const midId = read(entries_ + 16 * mid);
+		if (midId < id)
+			low = mid + 1;
+		else if (midId > id)
+			high = mid;
+		else
+		{
+			size_t const entry = entries_ + 16 * mid;
+			return Entry{read(entry + 4), read(entry + 8), read(entry + 12)};
+		}
+	}
+	return std::nullopt;
+}
+
+std::string_view InstructionDocs::word(uint32_t index) const
+{
+	if (index >= wordCount_)
+		return {};
+	uint32_t const begin = read(wordOffsets_ + 4 * index);
+	uint32_t const end = read(wordOffsets_ + 4 * (index + 1));
+	if (begin > end || words_ + end > blob_.size())
+		return {};
+	return blob_.substr(words_ + begin, end - begin);
+}
+
+std::optional<InstructionTiming> InstructionDocs::timingAt(uint32_t index) const
+{
+	uint32_t const raw = read(timings_ + 8 * index);
+	if ((raw & 0xff) >= MicroarchitectureCount)
+		return std::nullopt; // corrupt, or measured on a microarchitecture newer than this build
+	return InstructionTiming{static_cast<Microarchitecture>(raw & 0xff),
+							 static_cast<uint8_t>((raw >> 8) & 0xff),
+							 static_cast<uint16_t>(raw >> 16),
+							 static_cast<uint16_t>(read(timings_ + 8 * index + 4))};
+}
+
+std::optional<std::string> InstructionDocs::text(uint32_t id) const
+{
+	auto const entry = find(id);
+	if (!entry || entry->text >= textCount_)
+		return std::nullopt;
+
+	uint32_t const begin = read(textOffsets_ + 4 * entry->text);
+	uint32_t const end = read(textOffsets_ + 4 * (entry->text + 1));
+	if (begin > end || texts_ + end > blob_.size())
+		return std::nullopt;
+	std::string_view const compressed = blob_.substr(texts_ + begin, end - begin);
+
+	std::string text;
+	text.reserve(compressed.size() * 2);
+	for (size_t i = 0; i < compressed.size(); ++i)
+	{
+		auto const byte = static_cast<uint8_t>(compressed[i]);
+		if (byte < 0x80)
+			text.push_back(static_cast<char>(byte));
+		else if (i + 1 < compressed.size())
+		{
+			uint32_t const index = (uint32_t(byte & 0x7f) << 8) | static_cast<uint8_t>(compressed[++i]);
+			if (index < EscapedBytes)
+				text.push_back(static_cast<char>(0x80 + index));
+			else
+				text += word(index - EscapedBytes);
+		}
+	}
+	return text;
+}
+
+std::optional<InstructionTiming> InstructionDocs::timing(uint32_t id, Microarchitecture uarch) const
+{
+	auto const entry = find(id);
+	if (!entry)
+		return std::nullopt;
+
+	for (uint32_t i = 0; i < entry->timingCount && entry->firstTiming + i < timingCount_; ++i)
+		if (auto const t = timingAt(entry->firstTiming + i); t && t->uarch == uarch)
+			return t;
+
+	return std::nullopt;
+}
+
+std::vector<InstructionTiming> InstructionDocs::timings(uint32_t id) const
+{
+	std::vector<InstructionTiming> result;
+	if (auto const entry = find(id))
+		for (uint32_t i = 0; i < entry->timingCount && entry->firstTiming + i < timingCount_; ++i)
+			if (auto const t = timingAt(entry->firstTiming + i))
+				result.push_back(*t);
+	return result;
+}
+// }}}
+
+// {{{ InstructionDocsBuilder
+void InstructionDocsBuilder::add(uint32_t id, std::string text, std::vector<InstructionTiming> timings)
+{
+	forms_[id] = Form{std::move(text), std::move(timings)};
+}
+
+std::string InstructionDocsBuilder::build() const
+{
+	// deduplicate texts
+	std::vector<std::string_view> texts;
+	std::unordered_map<std::string_view, uint32_t> textIndex;
+	for (auto const& [id, form]: forms_)
+		if (textIndex.try_emplace(form.text, static_cast<uint32_t>(texts.size())).second)
+			texts.push_back(form.text);
+
+	// pick the dictionary words saving the most bytes
+	std::unordered_map<std::string_view, size_t> frequency;
+	for (std::string_view const text: texts)
+		forEachWord(text, [&](std::string_view w) {
+			if (w.size() >= MinWordLength)
+				++frequency[w];
+		});
+
+	std::vector<std::pair<std::string_view, size_t>> candidates(frequency.begin(), frequency.end());
+	auto const saving = [](const std::pair<std::string_view, size_t>& c) { return (c.first.size() - 2) * c.second; };
+	std::sort(candidates.begin(), candidates.end(), [&](auto const& a, auto const& b) {
+		return saving(a) != saving(b) ? saving(a) > saving(b) : a.first < b.first;
+	});
+	candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [](auto const& c) { return c.second < 2; }), candidates.end());
+	if (candidates.size() > MaxWords)
+		candidates.resize(MaxWords);
+
+	std::unordered_map<std::string_view, uint32_t> dictionary;
+	for (auto const& [w, count]: candidates)
+		dictionary.emplace(w, static_cast<uint32_t>(dictionary.size()));
+
+	auto const compress = [&](std::string_view text) {
+		std::string out;
+		size_t i = 0;
+		while (i < text.size())
+		{
+			if (isWordChar(text[i]))
+			{
+				size_t end = i;
+				while (end < text.size() && isWordChar(text[end]))
+					++end;
+				std::string_view const w = text.substr(i, end - i);
+				if (auto const d = dictionary.find(w); d != dictionary.end())
+					putReference(out, EscapedBytes + d->second);
+				else
+					out += w;
+				i = end;
+			}
+			else if (static_cast<uint8_t>(text[i]) >= 0x80)
+				putReference(out, static_cast<uint8_t>(text[i++]) - 0x80u);
+			else
+				out.push_back(text[i++]);
+		}
+		return out;
+	};
+
+	std::string blob(Magic, 4);
+	put32(blob, InstructionDocs::Version);
+
+	auto const putStrings = [&](const std::vector<std::string>& strings) {
+		put32(blob, static_cast<uint32_t>(strings.size()));
+		uint32_t offset = 0;
+		for (std::string const& s: strings)
+		{
+			put32(blob, offset);
+			offset += static_cast<uint32_t>(s.size());
+		}
+		put32(blob, offset);
+		for (std::string const& s: strings)
+			blob += s;
+	};
+
+	std::vector<std::string> words(dictionary.size());
+	for (auto const& [w, index]: dictionary)
+		words[index] = std::string(w);
+	putStrings(words);
+
+	std::vector<std::string> compressed;
+	for (std::string_view const text: texts)
+		compressed.push_back(compress(text));
+	putStrings(compressed);
+
+	size_t timingCount = 0;
+	for (auto const& [id, form]: forms_)
+		timingCount += form.timings.size();
+	put32(blob, static_cast<uint32_t>(timingCount));
+	for (auto const& [id, form]: forms_)
+		for (InstructionTiming const& t: form.timings)
+		{
+			put32(blob, uint32_t(t.uarch) | uint32_t(t.latency) << 8 | uint32_t(t.throughput) << 16);
+			put32(blob, t.ports);
+		}
+
+	put32(blob, static_cast<uint32_t>(forms_.size()));
+	uint32_t firstTiming = 0;
+	for (auto const& [id, form]: forms_)
+	{
+		put32(blob, id);
+		put32(blob, textIndex.at(form.text));
+		put32(blob, firstTiming);
+		put32(blob, static_cast<uint32_t>(form.timings.size()));
+		firstTiming += static_cast<uint32_t>(form.timings.size());
+	}
+
+	return blob;
+}
+// }}}
+
+}
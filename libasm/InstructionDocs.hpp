@@ -0,0 +1,135 @@
+#pragma once
+
+#include <libasm/Microarchitecture.hpp>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Measured timing of an instruction form on one microarchitecture.
+ */
+struct InstructionTiming
+{
+	Microarchitecture uarch;
+	uint8_t latency;            //!< cycles from input to output operands
+	uint16_t throughput;        //!< reciprocal throughput in 1/100 cycles
+	uint16_t ports = 0;         //!< bit n set if a uop may be issued to execution port n
+
+	double reciprocalThroughput() const noexcept { return throughput / 100.0; }
+};
+
+/**
+ * Read-only store of instruction form documentation and timings, indexed by
+ * InstructionDefinition::id().
+ *
+ * The store reads a single blob in place, as serialized by
+ * InstructionDocsBuilder, and allocates nothing besides decompressed texts.
+ * Identical texts are stored once, and texts are compressed against a shared
+ * dictionary of frequent words. A text is decompressed only when a hover asks
+ * for it, which takes a few microseconds.
+ *
+ * Blob layout, all integers little endian u32 unless stated otherwise:
+ * @code
+ *   "ASMD" version
+ *   wordCount  wordOffsets[wordCount + 1]  words...
+ *   textCount  textOffsets[textCount + 1]  compressed texts...
+ *   timingCount timings[timingCount] as {u8 uarch, u8 latency, u16 throughput, u32 ports}
+ *   entryCount entries[entryCount] as {id, text, firstTiming, timingCount}, sorted by id
+ * @endcode
+ *
+ * A compressed text is a byte stream: bytes below 0x80 are literal ASCII, a
+ * byte b >= 0x80 followed by byte c refers to dictionary word ((b & 0x7f) << 8) | c.
+ */
+class InstructionDocs
+{
+public:
+	static constexpr uint32_t Version = 2;
+
+	InstructionDocs() = default;
+
+	/**
+	 * Opens the given blob, which must outlive this object.
+	 *
+	 * A malformed blob yields an empty store.
+	 */
+	explicit InstructionDocs(std::string_view blob);
+
+	bool empty() const noexcept { return entryCount_ == 0; }
+	size_t size() const noexcept { return entryCount_; }
+
+	/**
+	 * Decompresses the documentation of the instruction form @p id.
+	 */
+	std::optional<std::string> text(uint32_t id) const;
+
+	/**
+	 * Retrieves the timing of instruction form @p id on @p uarch.
+	 */
+	std::optional<InstructionTiming> timing(uint32_t id, Microarchitecture uarch) const;
+
+	/**
+	 * Retrieves the timings of instruction form @p id on all microarchitectures it was measured on.
+	 */
+	std::vector<InstructionTiming> timings(uint32_t id) const;
+
+private:
+	struct Entry
+	{
+		uint32_t text;
+		uint32_t firstTiming;
+		uint32_t timingCount;
+	};
+
+	uint32_t read(size_t offset) const noexcept;
+	std::optional<Entry> find(uint32_t id) const;
+	std::string_view word(uint32_t index) const;
+	/** Decodes timing record @p index, nothing if it names an unknown microarchitecture. */
+	std::optional<InstructionTiming> timingAt(uint32_t index) const;
+
+	std::string_view blob_;
+	size_t wordCount_ = 0;
+	size_t wordOffsets_ = 0;
+	size_t words_ = 0;
+	size_t textCount_ = 0;
+	size_t textOffsets_ = 0;
+	size_t texts_ = 0;
+	size_t timingCount_ = 0;
+	size_t timings_ = 0;
+	size_t entryCount_ = 0;
+	size_t entries_ = 0;
+};
+
+/**
+ * Assembles an InstructionDocs blob from instruction forms added one by one.
+ */
+class InstructionDocsBuilder
+{
+public:
+	/**
+	 * Adds the documentation and timings of the instruction form @p id.
+	 */
+	void add(uint32_t id, std::string text, std::vector<InstructionTiming> timings = {});
+
+	/**
+	 * Deduplicates and compresses all texts, and serializes the store.
+	 */
+	std::string build() const;
+
+private:
+	struct Form
+	{
+		std::string text;
+		std::vector<InstructionTiming> timings;
+	};
+
+	std::map<uint32_t, Form> forms_;
+};
+
+}
@@ -0,0 +1,347 @@
+#include <libasm/LabelIndex.hpp>
+#include <libasm/Lexer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_set>
+
+namespace asmlsp
+{
+
+namespace
+{
+	bool isSpace(char ch) noexcept
+	{
+		return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\f' || ch == '\v';
+	}
+
+	bool isWordChar(char ch) noexcept
+	{
+		return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9')
+			|| ch == '_' || ch == '.' || ch == '$' || ch == '@' || ch == '?' || ch == '%' || ch == '#';
+	}
+
+	bool isCodeSection(std::string_view name) noexcept
+	{
+		return name.substr(0, 5) == ".text" || name == "text" || name == ".init" || name == ".fini";
+	}
+
+	/**
+	 * Cursor over the words of a single line.
+	 */
+	struct Words
+	{
+		std::string_view line;
+		size_t pos = 0;
+
+		void skipSpace()
+		{
+			while (pos < line.size() && isSpace(line[pos]))
+				++pos;
+		}
+
+		/** Reads the next word, or an empty view at end of line or punctuation. */
+		std::string_view next()
+		{
+			skipSpace();
+			size_t const begin = pos;
+			while (pos < line.size() && isWordChar(line[pos]))
+				++pos;
+			return line.substr(begin, pos - begin);
+		}
+
+		bool consume(char ch)
+		{
+			skipSpace();
+			if (pos < line.size() && line[pos] == ch)
+			{
+				++pos;
+				return true;
+			}
+			return false;
+		}
+	};
+
+	/** Strips the trailing comment, honoring quoted strings. */
+	std::string_view stripComment(std::string_view line)
+	{
+		char quote = 0;
+		for (size_t i = 0; i < line.size(); ++i)
+		{
+			char const ch = line[i];
+			if (quote)
+			{
+				if (ch == quote)
+					quote = 0;
+			}
+			else if (ch == '"' || ch == '\'' || ch == '`')
+				quote = ch;
+			else if (ch == ';')
+				return line.substr(0, i);
+		}
+		return line;
+	}
+
+	/** Rank of an entity kind in the outline hierarchy, lower ones enclose higher ones. */
+	int rankOf(SymbolKind kind) noexcept
+	{
+		switch (kind)
+		{
+			case SymbolKind::Section: return 0;
+			case SymbolKind::Function:
+			case SymbolKind::Macro: return 1;
+			case SymbolKind::Label:
+			case SymbolKind::Data: return 2;
+		}
+		return 2;
+	}
+}
+
+LabelIndex::LabelIndex(std::string_view source):
+	source_{source}
+{
+	struct CodeLine
+	{
+		unsigned line;
+		size_t end;
+	};
+
+	std::unordered_set<std::string_view> callTargets;
+	std::unordered_set<std::string_view> globals;
+	std::vector<bool> inCode;        // per entry
+	std::vector<size_t> lineBegins;  // per entry
+	std::vector<CodeLine> codeLines; // non-blank lines, for tight entity ranges
+	std::vector<std::pair<unsigned, size_t>> openMacros; // line and entry index
+	bool code = true;
+	int commentStart = -1;
+	unsigned commentEnd = 0;
+
+	auto const addEntry = [&](std::string_view name, SymbolKind kind, unsigned line, size_t lineBegin) {
+		size_t const nameBegin = static_cast<size_t>(name.data() - source_.data());
+		entries_.push_back(Entry{name, kind, line, line, {}, SourceRange{nameBegin, nameBegin + name.size()}});
+		inCode.push_back(code);
+		lineBegins.push_back(lineBegin);
+	};
+
+	auto const closeComment = [&]() {
+		if (commentStart >= 0 && commentEnd > static_cast<unsigned>(commentStart))
+			blocks_.push_back(Block{static_cast<unsigned>(commentStart), commentEnd, FoldingRange::Comment});
+		commentStart = -1;
+	};
+
+	unsigned lineNumber = 0;
+	for (size_t lineBegin = 0; lineBegin <= source_.size(); ++lineNumber)
+	{
+		size_t lineEnd = source_.find('\n', lineBegin);
+		if (lineEnd == std::string_view::npos)
+			lineEnd = source_.size();
+
+		std::string_view const raw = source_.substr(lineBegin, lineEnd - lineBegin);
+		size_t const nextLine = lineEnd + 1;
+
+		std::string_view const text = stripComment(raw);
+		Words words{text};
+		words.skipSpace();
+		bool const isBlank = words.pos == text.size();
+		bool const isComment = isBlank && text.size() != raw.size();
+
+		if (isComment)
+		{
+			if (commentStart < 0)
+				commentStart = static_cast<int>(lineNumber);
+			commentEnd = lineNumber;
+		}
+		else
+			closeComment();
+
+		if (isBlank)
+		{
+			lineBegin = nextLine;
+			continue;
+		}
+
+		size_t rawEnd = raw.size();
+		while (rawEnd > 0 && isSpace(raw[rawEnd - 1]))
+			--rawEnd;
+		codeLines.push_back(CodeLine{lineNumber, lineBegin + rawEnd});
+
+		std::string_view const first = words.next();
+		DirectiveKind const directive = directiveKind(first);
+
+		if (directive == DirectiveKind::EndMacro)
+		{
+			if (!openMacros.empty())
+			{
+				auto const [startLine, entry] = openMacros.back();
+				openMacros.pop_back();
+				blocks_.push_back(Block{startLine, lineNumber, FoldingRange::Region});
+				if (entry != SIZE_MAX)
+				{
+					entries_[entry].lastLine = lineNumber;
+					entries_[entry].range = SourceRange{lineBegins[entry], lineBegin + rawEnd};
+				}
+			}
+		}
+		else if (directive == DirectiveKind::Macro)
+		{
+			if (std::string_view const name = words.next(); !name.empty())
+			{
+				bool const nested = !openMacros.empty();
+				if (!nested)
+					addEntry(name, SymbolKind::Macro, lineNumber, lineBegin);
+				openMacros.emplace_back(lineNumber, nested ? SIZE_MAX : entries_.size() - 1);
+			}
+		}
+		else if (!openMacros.empty())
+		{
+			// macro bodies are templates, their labels are not symbols of their own
+		}
+		else if (directive == DirectiveKind::Section)
+		{
+			// section .text names it, .text is one by itself
+			std::string_view const name = words.next();
+			std::string_view const section = name.empty() ? first : name;
+			code = isCodeSection(section);
+			addEntry(section, SymbolKind::Section, lineNumber, lineBegin);
+		}
+		else if (directive == DirectiveKind::Global)
+		{
+			for (std::string_view name = words.next(); !name.empty(); name = words.next())
+			{
+				globals.insert(name);
+				if (words.consume(':'))
+					words.next(); // NASM type suffix, e.g. global foo:function
+				words.consume(',');
+			}
+		}
+		else if (equalsIgnoreCase(first, "call"))
+		{
+			if (std::string_view const target = words.next(); !target.empty())
+				callTargets.insert(target);
+		}
+		else if (!first.empty() && words.consume(':'))
+		{
+			bool const isData = directiveKind(words.next()) == DirectiveKind::Data || !code;
+			addEntry(first, isData ? SymbolKind::Data : SymbolKind::Label, lineNumber, lineBegin);
+		}
+		else if (!first.empty() && directive == DirectiveKind::None && directiveKind(words.next()) == DirectiveKind::Data)
+		{
+			// NASM data definition without colon, e.g. "table dd 1, 2, 3"
+			addEntry(first, SymbolKind::Data, lineNumber, lineBegin);
+		}
+
+		lineBegin = nextLine;
+	}
+	closeComment();
+
+	for (size_t i = 0; i < entries_.size(); ++i)
+	{
+		Entry& entry = entries_[i];
+		if (entry.kind == SymbolKind::Label && inCode[i] && entry.name.front() != '.'
+			&& (callTargets.count(entry.name) || globals.count(entry.name)))
+			entry.kind = SymbolKind::Function;
+		if (entry.kind != SymbolKind::Section)
+			kinds_.emplace(entry.name, entry.kind);
+	}
+
+	// Each entity extends up to the next one of the same or an enclosing kind.
+	std::array<size_t, 3> nextOfRank;
+	nextOfRank.fill(entries_.size());
+	for (size_t i = entries_.size(); i-- > 0;)
+	{
+		Entry& entry = entries_[i];
+		int const rank = rankOf(entry.kind);
+
+		if (entry.kind != SymbolKind::Macro)
+		{
+			size_t next = entries_.size();
+			for (int r = 0; r <= rank; ++r)
+				next = std::min(next, nextOfRank[r]);
+
+			size_t const limit = next < entries_.size() ? lineBegins[next] : source_.size() + 1;
+			auto const last = std::lower_bound(codeLines.begin(), codeLines.end(), limit,
+											   [&](const CodeLine& l, size_t offset) { return l.end < offset; });
+			CodeLine const& lastLine = last != codeLines.begin() ? *std::prev(last) : codeLines.front();
+			entry.lastLine = std::max(entry.line, lastLine.line);
+			entry.range = SourceRange{lineBegins[i], std::max(entry.selection.end, lastLine.end)};
+		}
+
+		else if (entry.range.empty())
+			entry.range = SourceRange{lineBegins[i], entry.selection.end}; // unterminated macro
+
+		nextOfRank[static_cast<size_t>(rank)] = i;
+	}
+}
+
+std::vector<Symbol> LabelIndex::symbols() const
+{
+	std::vector<Symbol> result;
+	result.reserve(entries_.size());
+	for (Entry const& entry: entries_)
+		result.push_back(Symbol{std::string(entry.name), entry.kind, entry.selection});
+	return result;
+}
+
+std::vector<DocumentSymbol> LabelIndex::outline() const
+{
+	std::vector<DocumentSymbol> top;
+	DocumentSymbol* section = nullptr;
+	DocumentSymbol* function = nullptr;
+
+	for (Entry const& entry: entries_)
+	{
+		DocumentSymbol symbol{std::string(entry.name), entry.kind, entry.range, entry.selection, {}};
+		std::vector<DocumentSymbol>& sectionLevel = section ? section->children : top;
+
+		switch (entry.kind)
+		{
+			case SymbolKind::Section:
+				top.emplace_back(std::move(symbol));
+				section = &top.back();
+				function = nullptr;
+				break;
+			case SymbolKind::Function:
+				sectionLevel.emplace_back(std::move(symbol));
+				function = &sectionLevel.back();
+				break;
+			case SymbolKind::Macro:
+			case SymbolKind::Data:
+				sectionLevel.emplace_back(std::move(symbol));
+				function = nullptr;
+				break;
+			case SymbolKind::Label:
+				if (function)
+					function->children.emplace_back(std::move(symbol));
+				else
+					sectionLevel.emplace_back(std::move(symbol));
+				break;
+		}
+	}
+
+	return top;
+}
+
+std::vector<FoldingRange> LabelIndex::foldingRanges() const
+{
+	std::vector<FoldingRange> result;
+	for (Entry const& entry: entries_)
+		if (entry.kind != SymbolKind::Macro && entry.lastLine > entry.line)
+			result.push_back(FoldingRange{entry.line, entry.lastLine, FoldingRange::Region});
+
+	for (Block const& block: blocks_)
+		result.push_back(FoldingRange{block.startLine, block.endLine, block.kind});
+
+	std::sort(result.begin(), result.end(), [](const FoldingRange& a, const FoldingRange& b) {
+		return a.startLine != b.startLine ? a.startLine < b.startLine : a.endLine > b.endLine;
+	});
+	return result;
+}
+
+std::optional<SymbolKind> LabelIndex::kindOf(std::string_view name) const
+{
+	auto const i = kinds_.find(name);
+	return i != kinds_.end() ? std::optional{i->second} : std::nullopt;
+}
+
+}
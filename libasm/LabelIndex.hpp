@@ -0,0 +1,102 @@
+#pragma once
+
+#include <libasm/SourceLocation.hpp>
+#include <libasm/SymbolIndex.hpp>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * A node of the document outline, modelled after LSP's DocumentSymbol.
+ */
+struct DocumentSymbol
+{
+	std::string name;
+	SymbolKind kind;
+	SourceRange range;          //!< the whole entity, e.g. a function up to the next one
+	SourceRange selectionRange; //!< the name in its definition
+	std::vector<DocumentSymbol> children;
+};
+
+/**
+ * A foldable line range, modelled after LSP's FoldingRange.
+ */
+struct FoldingRange
+{
+	enum Kind
+	{
+		Region,
+		Comment,
+	};
+
+	unsigned startLine;
+	unsigned endLine;
+	Kind kind;
+};
+
+/**
+ * Labels, sections, data symbols and macros of a document, found by a single
+ * line scan of its text.
+ *
+ * This is what outline, folding and workspace symbols are served from. It
+ * neither parses instructions nor lowers anything to SSA, so it is available
+ * right after opening a file, even for generated files with a million lines
+ * whose full analysis is deferred.
+ *
+ * A label is considered a function if it is a call target or declared
+ * global in a code section. Local labels (starting with a dot) and other
+ * labels up to the next function are its children.
+ */
+class LabelIndex
+{
+public:
+	explicit LabelIndex(std::string_view source);
+
+	/**
+	 * All symbols in source order, e.g. for SymbolIndex::update().
+	 */
+	std::vector<Symbol> symbols() const;
+
+	/**
+	 * Sections, containing functions, containing their labels.
+	 */
+	std::vector<DocumentSymbol> outline() const;
+
+	std::vector<FoldingRange> foldingRanges() const;
+
+	/**
+	 * Retrieves the kind of the symbol named @p name, if this document defines one.
+	 */
+	std::optional<SymbolKind> kindOf(std::string_view name) const;
+
+private:
+	struct Entry
+	{
+		std::string_view name;
+		SymbolKind kind;
+		unsigned line;
+		unsigned lastLine;     //!< last non-blank line of the entity
+		SourceRange range;     //!< from the start of its line to the end of its last line
+		SourceRange selection;
+	};
+
+	struct Block
+	{
+		unsigned startLine;
+		unsigned endLine;
+		FoldingRange::Kind kind;
+	};
+
+	std::string_view source_;
+	std::vector<Entry> entries_;
+	std::vector<Block> blocks_;   //!< macros and comment runs
+	std::unordered_map<std::string_view, SymbolKind> kinds_;
+};
+
+}
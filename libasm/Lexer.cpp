@@ -0,0 +1,182 @@
+#include <libasm/Lexer.hpp>
+
+#include <array>
+
+namespace asmlsp
+{
+
+namespace
+{
+	bool isDigit(char ch) noexcept { return ch >= '0' && ch <= '9'; }
+
+	bool isAlpha(char ch) noexcept { return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z'); }
+
+	bool isIdentifierStart(char ch) noexcept
+	{
+		return isAlpha(ch) || ch == '_' || ch == '.' || ch == '$' || ch == '@' || ch == '?' || ch == '%';
+	}
+
+	bool isIdentifierChar(char ch) noexcept
+	{
+		return isIdentifierStart(ch) || isDigit(ch) || ch == '#' || ch == '~';
+	}
+
+	template <size_t N>
+	bool isOneOf(std::string_view word, const std::array<std::string_view, N>& words) noexcept
+	{
+		for (std::string_view const w: words)
+			if (equalsIgnoreCase(word, w))
+				return true;
+		return false;
+	}
+
+	constexpr std::array<std::string_view, 4> SectionDirectives = {"section", "segment", ".section", ".pushsection"};
+	constexpr std::array<std::string_view, 4> ShortSectionDirectives = {".text", ".data", ".bss", ".rodata"};
+	constexpr std::array<std::string_view, 3> GlobalDirectives = {"global", ".globl", ".global"};
+	constexpr std::array<std::string_view, 2> MacroDirectives = {"%macro", ".macro"};
+	constexpr std::array<std::string_view, 3> EndMacroDirectives = {"%endmacro", ".endm", ".endmacro"};
+	constexpr std::array<std::string_view, 39> DataDirectives = {
+		"db", "dw", "dd", "dq", "dt", "do", "dy", "dz",
+		"resb", "resw", "resd", "resq", "rest", "reso", "resy", "resz",
+		"incbin", "equ", "times",
+		".byte", ".word", ".short", ".hword", ".long", ".int", ".quad", ".octa",
+		".ascii", ".asciz", ".string", ".zero", ".skip", ".space", ".fill",
+		".float", ".single", ".double", ".align", ".balign",
+	};
+	constexpr std::array<std::string_view, 5> OtherDirectives = {"extern", "default", "bits", "org", "align"};
+
+	constexpr std::array<std::string_view, 15> OperandKeywords = {
+		"byte", "word", "dword", "qword", "tword", "oword", "xmmword", "ymmword", "zmmword",
+		"ptr", "rel", "abs", "near", "far", "short",
+	};
+
+	constexpr std::array<std::string_view, 7> Prefixes = {"lock", "rep", "repe", "repz", "repne", "repnz", "notrack"};
+}
+
+std::vector<Token> tokenizeLine(std::string_view line)
+{
+	std::vector<Token> tokens;
+	size_t i = 0;
+
+	auto const emit = [&](TokenKind kind, size_t begin) {
+		tokens.push_back(Token{kind, static_cast<uint32_t>(begin), static_cast<uint32_t>(i - begin)});
+	};
+
+	while (i < line.size())
+	{
+		char const ch = line[i];
+		size_t const begin = i;
+
+		if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\f' || ch == '\v')
+		{
+			++i;
+			continue;
+		}
+
+		if (ch == ';')
+		{
+			i = line.size();
+			emit(TokenKind::Comment, begin);
+		}
+		else if (ch == '"' || ch == '\'' || ch == '`')
+		{
+			++i;
+			while (i < line.size() && line[i] != ch)
+				i += line[i] == '\\' && ch == '`' && i + 1 < line.size() ? 2 : 1;
+			bool const terminated = i < line.size();
+			if (terminated)
+				++i;
+			emit(terminated ? TokenKind::String : TokenKind::Invalid, begin);
+		}
+		else if (isDigit(ch))
+		{
+			// 42, 0x2a, 2ah, 101b, 1.5e3, 1_000
+			while (i < line.size() && (isIdentifierChar(line[i])
+				|| ((line[i] == '+' || line[i] == '-') && (line[i - 1] == 'e' || line[i - 1] == 'E') && line.substr(begin, 2) != "0x")))
+				++i;
+			emit(TokenKind::Number, begin);
+		}
+		else if (ch == '{')
+		{
+			++i;
+			while (i < line.size() && (isAlpha(line[i]) || isDigit(line[i]) || line[i] == '-'))
+				++i;
+			bool const terminated = i < line.size() && line[i] == '}';
+			if (terminated)
+				++i;
+			emit(terminated ? TokenKind::Decorator : TokenKind::Invalid, begin);
+		}
+		else if (isIdentifierStart(ch))
+		{
+			while (i < line.size() && isIdentifierChar(line[i]))
+				++i;
+			emit(TokenKind::Identifier, begin);
+		}
+		else
+		{
+			++i;
+			switch (ch)
+			{
+				case ',': emit(TokenKind::Comma, begin); break;
+				case ':': emit(TokenKind::Colon, begin); break;
+				case '[': emit(TokenKind::LeftBracket, begin); break;
+				case ']': emit(TokenKind::RightBracket, begin); break;
+				case '+': case '-': case '*': case '/': case '(': case ')':
+				case '<': case '>': case '&': case '|': case '^': case '~': case '!': case '=':
+					emit(TokenKind::Operator, begin);
+					break;
+				default:
+					emit(TokenKind::Invalid, begin);
+					break;
+			}
+		}
+	}
+
+	return tokens;
+}
+
+DirectiveKind directiveKind(std::string_view word) noexcept
+{
+	if (word.empty())
+		return DirectiveKind::None;
+	if (isOneOf(word, SectionDirectives) || isOneOf(word, ShortSectionDirectives))
+		return DirectiveKind::Section;
+	if (isOneOf(word, GlobalDirectives))
+		return DirectiveKind::Global;
+	if (isOneOf(word, MacroDirectives))
+		return DirectiveKind::Macro;
+	if (isOneOf(word, EndMacroDirectives))
+		return DirectiveKind::EndMacro;
+	if (isOneOf(word, DataDirectives))
+		return DirectiveKind::Data;
+	if (word.front() == '.' || word.front() == '%' || isOneOf(word, OtherDirectives))
+		return DirectiveKind::Other;
+	return DirectiveKind::None;
+}
+
+bool isDirectiveName(std::string_view word) noexcept
+{
+	return directiveKind(word) != DirectiveKind::None;
+}
+
+bool isInstructionPrefix(std::string_view word) noexcept
+{
+	return isOneOf(word, Prefixes);
+}
+
+bool isOperandKeyword(std::string_view word) noexcept
+{
+	return isOneOf(word, OperandKeywords);
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) noexcept
+{
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < a.size(); ++i)
+		if ((a[i] | 0x20) != (b[i] | 0x20))
+			return false;
+	return true;
+}
+
+}
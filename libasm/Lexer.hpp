@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace asmlsp
+{
+
+enum class TokenKind : uint8_t
+{
+	Identifier,   //!< mnemonics, registers, labels, directives and keywords alike
+	Number,
+	String,       //!< quoted string or character constant, including its quotes
+	Comment,      //!< from ';' up to the end of the line
+	Comma,
+	Colon,
+	LeftBracket,
+	RightBracket,
+	Decorator,    //!< AVX-512 operand decorator including its braces, such as {k1}, {z}, {1to16} or {rn-sae}
+	Operator,     //!< + - * / and the like
+	Invalid,      //!< unterminated string or a character not valid in assembly
+};
+
+/**
+ * A token of a single source line.
+ */
+struct Token
+{
+	TokenKind kind;
+	uint32_t offset; //!< byte offset relative to the start of the line
+	uint32_t length;
+
+	std::string_view text(std::string_view line) const { return line.substr(offset, length); }
+};
+
+/**
+ * Splits a single line of Intel syntax assembly (NASM or GAS) into tokens.
+ *
+ * Lexing never fails: an unterminated string extends to the end of the line
+ * and is marked Invalid, as are characters that cannot start a token. The
+ * rest of the line is still tokenized normally.
+ */
+std::vector<Token> tokenizeLine(std::string_view line);
+
+/**
+ * Role of an assembler directive in the structure of a file.
+ */
+enum class DirectiveKind : uint8_t
+{
+	None,     //!< no directive, e.g. an instruction
+	Section,  //!< switches sections, either naming it (section, .section) or by itself (.text, .bss)
+	Global,   //!< exports symbols (global, .globl)
+	Macro,    //!< starts a macro definition (%macro, .macro)
+	EndMacro, //!< ends a macro definition (%endmacro, .endm)
+	Data,     //!< defines or reserves data, such as db, resq, .quad or times
+	Other,
+};
+
+/**
+ * Classifies @p word as a NASM or GAS directive. Words starting with '.'
+ * or '%' are directives of some kind.
+ */
+DirectiveKind directiveKind(std::string_view word) noexcept;
+
+/**
+ * Tests whether @p word names an assembler directive rather than an
+ * instruction, such as section, db or anything starting with '.' or '%'.
+ */
+bool isDirectiveName(std::string_view word) noexcept;
+
+/** Tests whether @p word is an instruction prefix such as lock or rep. */
+bool isInstructionPrefix(std::string_view word) noexcept;
+
+/** Tests whether @p word is a size specifier or other operand keyword, such as qword, ptr or rel. */
+bool isOperandKeyword(std::string_view word) noexcept;
+
+/** Compares ASCII identifiers case-insensitively. */
+bool equalsIgnoreCase(std::string_view a, std::string_view b) noexcept;
+
+}
@@ -0,0 +1,54 @@
+#include <libasm/Lint.hpp>
+#include <libasm/Parser.hpp>
+
+#include <unordered_map>
+
+namespace asmlsp
+{
+
+Dialect dialectOf(std::string_view path) noexcept
+{
+	return path.size() >= 2 && path[path.size() - 2] == '.' && (path.back() == 's' || path.back() == 'S') ? Dialect::Gas : Dialect::Nasm;
+}
+
+std::vector<SourceDiagnostic> lintSource(std::string_view source, Dialect dialect)
+{
+	std::vector<SourceDiagnostic> diagnostics;
+	std::unordered_map<std::string, unsigned> labels; //!< first definition's line, by scoped name
+	std::string scope;
+
+	unsigned lineNumber = 0;
+	for (size_t begin = 0; begin <= source.size(); ++lineNumber)
+	{
+		size_t end = source.find('\n', begin);
+		if (end == std::string_view::npos)
+			end = source.size();
+
+		ParsedLine const line = parseLine(source.substr(begin, end - begin));
+		begin = end + 1;
+
+		for (SyntaxError const& error: line.errors)
+			diagnostics.push_back(SourceDiagnostic{Position{lineNumber, error.offset}, Position{lineNumber, error.offset + error.length},
+												   Severity::Error, "syntax-error", error.message});
+
+		if (line.label.empty() || (line.label.front() >= '0' && line.label.front() <= '9'))
+			continue;
+
+		bool const local = dialect == Dialect::Nasm && line.label.front() == '.';
+		if (!local)
+			scope = line.label;
+		std::string const name = local ? scope + line.label : line.label;
+
+		auto const [previous, inserted] = labels.try_emplace(name, lineNumber);
+		if (!inserted)
+			diagnostics.push_back(SourceDiagnostic{
+				Position{lineNumber, line.labelOffset},
+				Position{lineNumber, line.labelOffset + static_cast<unsigned>(line.label.size())},
+				Severity::Error, "duplicate-label",
+				"label '" + line.label + "' is already defined on line " + std::to_string(previous->second + 1)});
+	}
+
+	return diagnostics;
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <libasm/Diagnostic.hpp>
+#include <libasm/SourceLocation.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * A diagnostic located in source text rather than attached to an IR node.
+ */
+struct SourceDiagnostic
+{
+	Position start;
+	Position end;
+	Severity severity;
+	std::string code;
+	std::string message;
+};
+
+/**
+ * Assembler whose label rules a source follows.
+ */
+enum class Dialect : uint8_t
+{
+	Nasm, //!< labels starting with a dot are local to the preceding non-local label
+	Gas,  //!< all named labels share the file's scope, numeric labels such as 1: may be redefined
+};
+
+/**
+ * Guesses the dialect of a file from its extension: .s and .S are GAS, anything else NASM.
+ */
+Dialect dialectOf(std::string_view path) noexcept;
+
+/**
+ * Runs the checks that need nothing but the source text of a file:
+ * syntax errors and duplicate label definitions.
+ *
+ * Labels are scoped following @p dialect. Numeric local labels are never
+ * duplicates, since GAS allows redefining them.
+ */
+std::vector<SourceDiagnostic> lintSource(std::string_view source, Dialect dialect = Dialect::Nasm);
+
+}
@@ -0,0 +1,48 @@
+#include <libasm/Microarchitecture.hpp>
+
+#include <array>
+#include <cctype>
+
+namespace asmlsp
+{
+
+namespace
+{
+	// clang-format off
+	constexpr std::array<MicroarchitectureTraits, MicroarchitectureCount> traitsTable = {{
+		// id                             name           partial registers                     popcnt lzcnt/tzcnt
+		{Microarchitecture::Generic,     "generic",     PartialRegisterPolicy::MergeAll,   true,  true},
+		{Microarchitecture::Nehalem,     "nehalem",     PartialRegisterPolicy::Stall,      false, false},
+		{Microarchitecture::SandyBridge, "sandybridge", PartialRegisterPolicy::MergeAll,   true,  false},
+		{Microarchitecture::Haswell,     "haswell",     PartialRegisterPolicy::MergeHigh8, true,  true},
+		{Microarchitecture::Skylake,     "skylake",     PartialRegisterPolicy::MergeHigh8, true,  false},
+		{Microarchitecture::IceLake,     "icelake",     PartialRegisterPolicy::MergeHigh8, false, false},
+		{Microarchitecture::Zen2,        "zen2",        PartialRegisterPolicy::NoRename,   false, false},
+		{Microarchitecture::Zen4,        "zen4",        PartialRegisterPolicy::NoRename,   false, false},
+	}};
+	// clang-format on
+}
+
+const MicroarchitectureTraits& traitsOf(Microarchitecture uarch) noexcept
+{
+	return traitsTable[static_cast<size_t>(uarch)];
+}
+
+std::optional<Microarchitecture> parseMicroarchitecture(std::string_view name)
+{
+	for (auto const& traits: traitsTable)
+	{
+		if (traits.name.size() != name.size())
+			continue;
+
+		bool equal = true;
+		for (size_t i = 0; i < name.size() && equal; ++i)
+			equal = traits.name[i] == std::tolower(static_cast<unsigned char>(name[i]));
+
+		if (equal)
+			return traits.id;
+	}
+	return std::nullopt;
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace asmlsp
+{
+
+/**
+ * Target microarchitecture that performance diagnostics are tuned for.
+ */
+enum class Microarchitecture : uint8_t
+{
+	Generic,
+	Nehalem,
+	SandyBridge,
+	Haswell,
+	Skylake,
+	IceLake,
+	Zen2,
+	Zen4,
+};
+
+/** Number of Microarchitecture values. */
+constexpr size_t MicroarchitectureCount = static_cast<size_t>(Microarchitecture::Zen4) + 1;
+
+/**
+ * How a microarchitecture handles writes to partial general purpose registers.
+ */
+enum class PartialRegisterPolicy : uint8_t
+{
+	Stall,      //!< partial registers are renamed separately, reading the full register stalls until merged
+	MergeAll,   //!< partial registers are renamed separately, merged by an extra uop
+	MergeHigh8, //!< only ah..bh are renamed separately, other partial writes depend on the full register
+	NoRename,   //!< partial writes always depend on the full register, no merging needed
+};
+
+/**
+ * Performance relevant traits of a microarchitecture.
+ */
+struct MicroarchitectureTraits
+{
+	Microarchitecture id;
+	std::string_view name;
+	PartialRegisterPolicy partialRegisters;
+	bool popcntFalseDependency;      //!< popcnt waits for its destination's previous value
+	bool lzcntTzcntFalseDependency;  //!< lzcnt and tzcnt wait for their destination's previous value
+};
+
+/**
+ * Retrieves the traits of the given microarchitecture.
+ */
+const MicroarchitectureTraits& traitsOf(Microarchitecture uarch) noexcept;
+
+/**
+ * Parses a microarchitecture name case-insensitively, such as "skylake" or "zen4",
+ * as used by natspec comments and the server configuration.
+ */
+std::optional<Microarchitecture> parseMicroarchitecture(std::string_view name);
+
+}
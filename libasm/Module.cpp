@@ -0,0 +1,62 @@
+#include <libasm/Module.hpp>
+
+namespace asmlsp
+{
+
+Module::Module(std::string name, std::shared_ptr<const std::string> source):
+	name_{std::move(name)},
+	source_{source ? std::move(source) : std::make_shared<const std::string>()}
+{
+}
+
+FunctionDefinition* Module::createFunction(std::string name)
+{
+	functions_.emplace_back(std::make_unique<FunctionDefinition>(std::move(name)));
+	FunctionDefinition* function = functions_.back().get();
+	functionsByName_[function->name()] = function;
+	return function;
+}
+
+FunctionDefinition* Module::findFunction(std::string_view name) const
+{
+	auto const i = functionsByName_.find(name);
+	return i != functionsByName_.end() ? i->second : nullptr;
+}
+
+DataSection* Module::section(std::string_view name)
+{
+	for (auto const& section: sections_)
+		if (section->name() == name)
+			return section.get();
+
+	sections_.emplace_back(std::make_unique<DataSection>(*this, std::string(name)));
+	return sections_.back().get();
+}
+
+DataSymbol* Module::findDataSymbol(std::string_view name) const
+{
+	auto const i = dataSymbolsByName_.find(name);
+	return i != dataSymbolsByName_.end() ? i->second : nullptr;
+}
+
+void Module::registerSymbol(DataSymbol* symbol)
+{
+	dataSymbolsByName_[symbol->name()] = symbol;
+}
+
+IRBuilder::ConstantResolver Module::constantResolver()
+{
+	return [this](const AddressingMode& address, unsigned width) -> Constant* {
+		// only plain [symbol + disp] or [rel symbol + disp] denote a single location
+		if (address.symbol.empty() || address.isIndexed() || (address.base && !address.ripRelative))
+			return nullptr;
+
+		DataSymbol const* symbol = findDataSymbol(address.symbol);
+		if (!symbol || !symbol->section().isReadOnly())
+			return nullptr;
+
+		return symbol->constantAt(address.displacement, width, constants_);
+	};
+}
+
+}
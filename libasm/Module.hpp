@@ -0,0 +1,73 @@
+#pragma once
+
+#include <libasm/ConstantPool.hpp>
+#include <libasm/DataSection.hpp>
+#include <libasm/IRBuilder.hpp>
+#include <libasm/SSA.hpp>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * The IR of a single assembly source file.
+ *
+ * A module owns all functions, data sections and constants built from its
+ * source, and keeps the source text alive for lazily decoded data directives.
+ */
+class Module
+{
+public:
+	Module(std::string name, std::shared_ptr<const std::string> source);
+
+	Module(const Module&) = delete;
+	Module& operator=(const Module&) = delete;
+
+	const std::string& name() const noexcept { return name_; }
+	const std::string& source() const noexcept { return *source_; }
+
+	ConstantPool& constants() noexcept { return constants_; }
+
+	/**
+	 * Creates a new, empty function.
+	 */
+	FunctionDefinition* createFunction(std::string name);
+
+	FunctionDefinition* findFunction(std::string_view name) const;
+
+	const std::vector<std::unique_ptr<FunctionDefinition>>& functions() const noexcept { return functions_; }
+
+	/**
+	 * Retrieves the section of the given name, creating it on first use.
+	 */
+	DataSection* section(std::string_view name);
+
+	const std::vector<std::unique_ptr<DataSection>>& sections() const noexcept { return sections_; }
+
+	DataSymbol* findDataSymbol(std::string_view name) const;
+
+	/**
+	 * Creates a resolver for IRBuilder::setConstantResolver() that maps loads
+	 * from read-only data symbols of this module to constants.
+	 */
+	IRBuilder::ConstantResolver constantResolver();
+
+private:
+	friend class DataSection;
+	void registerSymbol(DataSymbol* symbol);
+
+	std::string name_;
+	std::shared_ptr<const std::string> source_;
+	ConstantPool constants_;
+	std::vector<std::unique_ptr<FunctionDefinition>> functions_;
+	std::vector<std::unique_ptr<DataSection>> sections_;
+	std::unordered_map<std::string_view, FunctionDefinition*> functionsByName_;
+	std::unordered_map<std::string_view, DataSymbol*> dataSymbolsByName_;
+};
+
+}
@@ -0,0 +1,632 @@
+#include <libasm/Parser.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
+
+namespace asmlsp
+{
+
+namespace
+{
+	std::string lowercase(std::string_view text)
+	{
+		std::string result(text);
+		for (char& ch: result)
+			if (ch >= 'A' && ch <= 'Z')
+				ch = static_cast<char>(ch - 'A' + 'a');
+		return result;
+	}
+
+	/** Width in bits named by a size specifier, 0 for other words. */
+	unsigned sizeOf(std::string_view word)
+	{
+		static constexpr std::pair<std::string_view, unsigned> Sizes[] = {
+			{"byte", 8}, {"word", 16}, {"dword", 32}, {"qword", 64}, {"tword", 80},
+			{"oword", 128}, {"xmmword", 128}, {"ymmword", 256}, {"zmmword", 512},
+		};
+		for (auto const& [name, width]: Sizes)
+			if (equalsIgnoreCase(word, name))
+				return width;
+		return 0;
+	}
+
+	class LineParser
+	{
+	public:
+		explicit LineParser(ParsedLine& line): line_{line}, text_{line.text}, tokens_{line.tokens} {}
+
+		void parse()
+		{
+			size_t end = tokens_.size();
+			if (end != 0 && tokens_.back().kind == TokenKind::Comment)
+				--end;
+
+			for (size_t k = 0; k < end; ++k)
+				if (tokens_[k].kind == TokenKind::Invalid)
+					error(tokens_[k], tokens_[k].text(text_).front() == '"' || tokens_[k].text(text_).front() == '\''
+										  || tokens_[k].text(text_).front() == '`'
+									  ? "unterminated string"
+									  : "unexpected character");
+
+			size_t i = 0;
+			if (i + 1 < end && is(i + 1, TokenKind::Colon)
+				&& ((is(i, TokenKind::Identifier) && !Register::parse(textOf(i))) || isNumericLabel(i)))
+			{
+				line_.label = std::string(textOf(i));
+				line_.labelOffset = tokens_[i].offset;
+				i += 2;
+			}
+
+			while (i < end && is(i, TokenKind::Identifier) && isInstructionPrefix(textOf(i)))
+				line_.prefixes.push_back(lowercase(textOf(i++)));
+
+			if (i == end)
+			{
+				if (!line_.prefixes.empty())
+					error(tokens_[i - 1], "expected instruction after prefix");
+				return;
+			}
+
+			if (!is(i, TokenKind::Identifier))
+			{
+				error(tokens_[i], "expected instruction or directive");
+				return;
+			}
+
+			// NASM data definitions name their symbol without a colon: msg db "hi"
+			if (line_.label.empty() && line_.prefixes.empty() && i + 1 < end && is(i + 1, TokenKind::Identifier)
+				&& !isDirectiveName(textOf(i)) && isDirectiveName(textOf(i + 1)) && textOf(i + 1).front() != '.')
+			{
+				line_.label = std::string(textOf(i));
+				line_.labelOffset = tokens_[i].offset;
+				++i;
+			}
+
+			line_.mnemonic = lowercase(textOf(i));
+			line_.mnemonicOffset = tokens_[i].offset;
+			line_.isDirective = isDirectiveName(line_.mnemonic);
+			++i;
+
+			if (line_.isDirective)
+				return;
+
+			// split operands at top level commas
+			size_t begin = i;
+			int depth = 0;
+			for (size_t k = i; k <= end; ++k)
+			{
+				if (k < end && is(k, TokenKind::LeftBracket))
+					++depth;
+				else if (k < end && is(k, TokenKind::RightBracket))
+					depth = std::max(0, depth - 1);
+				else if (k == end || (depth == 0 && is(k, TokenKind::Comma)))
+				{
+					if (k == end && begin == k && begin == i)
+						break; // no operands at all
+					operand(begin, k);
+					begin = k + 1;
+				}
+			}
+		}
+
+	private:
+		bool is(size_t k, TokenKind kind) const { return tokens_[k].kind == kind; }
+		bool isOperator(size_t k, char op) const { return is(k, TokenKind::Operator) && textOf(k).front() == op; }
+		std::string_view textOf(size_t k) const { return tokens_[k].text(text_); }
+
+		/** GAS numeric local label, as in 1: */
+		bool isNumericLabel(size_t k) const
+		{
+			std::string_view const text = textOf(k);
+			return is(k, TokenKind::Number) && std::all_of(text.begin(), text.end(), [](char ch) { return ch >= '0' && ch <= '9'; });
+		}
+
+		/** Reference to a GAS numeric local label by a branch, as in jnz 1b. */
+		bool isNumericLabelReference(size_t k) const
+		{
+			std::string_view const text = textOf(k);
+			bool const branch = line_.mnemonic.front() == 'j' || line_.mnemonic == "call" || line_.mnemonic.compare(0, 4, "loop") == 0;
+			return branch && is(k, TokenKind::Number) && text.size() > 1 && (text.back() == 'b' || text.back() == 'f')
+				&& std::all_of(text.begin(), text.end() - 1, [](char ch) { return ch >= '0' && ch <= '9'; });
+		}
+
+		void error(const Token& token, std::string message)
+		{
+			line_.errors.push_back(SyntaxError{token.offset, token.length, std::move(message)});
+		}
+
+		void error(uint32_t offset, uint32_t length, std::string message)
+		{
+			line_.errors.push_back(SyntaxError{offset, length, std::move(message)});
+		}
+
+		/** Parses the operand made of the tokens [begin, end). */
+		void operand(size_t begin, size_t end)
+		{
+			ParsedOperand op{OperandKind::Invalid, 0, 0, Register{}, 0, 0, std::nullopt, {}, Register{}, false, 0, {}};
+
+			if (begin == end)
+			{
+				// position the error at the comma before, or after the mnemonic
+				uint32_t const at = begin > 0 && is(begin - 1, TokenKind::Comma) ? tokens_[begin - 1].offset
+					: static_cast<uint32_t>(line_.mnemonicOffset + line_.mnemonic.size());
+				op.offset = at;
+				error(at, 1, "expected operand");
+				line_.operands.push_back(std::move(op));
+				return;
+			}
+
+			op.offset = tokens_[begin].offset;
+			op.length = tokens_[end - 1].offset + tokens_[end - 1].length - op.offset;
+
+			size_t const decorated = end;
+			while (end > begin && is(end - 1, TokenKind::Decorator))
+				--end;
+			if (end == begin)
+			{
+				// a rounding control of its own, as in vaddps zmm0, zmm1, zmm2, {rn-sae}
+				if (line_.operands.empty())
+					error(tokens_[begin], "decorator without operand");
+				for (size_t k = begin; k < decorated; ++k)
+					if (!line_.operands.empty())
+						decorator(line_.operands.back(), k);
+				return;
+			}
+			for (size_t k = end; k < decorated; ++k)
+				decorator(op, k);
+
+			size_t i = begin;
+			while (i < end && is(i, TokenKind::Identifier) && isOperandKeyword(textOf(i)))
+			{
+				if (unsigned const width = sizeOf(textOf(i)))
+					op.width = width;
+				++i;
+			}
+
+			// segment override, as in fs:[rax]
+			if (i + 2 < end && is(i, TokenKind::Identifier) && is(i + 1, TokenKind::Colon) && is(i + 2, TokenKind::LeftBracket))
+				i += 2;
+
+			if (i < end && is(i, TokenKind::LeftBracket))
+				memory(op, i, end);
+			else if (i + 1 == end && is(i, TokenKind::Identifier))
+			{
+				if (auto const reg = Register::parse(textOf(i)))
+				{
+					op.kind = OperandKind::Register;
+					op.reg = *reg;
+				}
+				else
+				{
+					op.kind = OperandKind::Symbol;
+					op.symbol = std::string(textOf(i));
+				}
+			}
+			else if (i + 1 == end && isNumericLabelReference(i))
+			{
+				op.kind = OperandKind::Symbol;
+				op.symbol = std::string(textOf(i));
+			}
+			else if (i + 1 == end && is(i, TokenKind::Number))
+				immediate(op, i, false);
+			else if (i + 2 == end && (isOperator(i, '-') || isOperator(i, '+')) && is(i + 1, TokenKind::Number))
+				immediate(op, i + 1, isOperator(i, '-'));
+			else if (i == end)
+				error(tokens_[end - 1], "expected operand after size specifier");
+			else
+			{
+				bool const valid = std::none_of(tokens_.begin() + static_cast<ptrdiff_t>(i), tokens_.begin() + static_cast<ptrdiff_t>(end),
+												[](const Token& t) { return t.kind == TokenKind::Invalid; });
+				if (valid)
+					op.kind = OperandKind::Expression;
+			}
+
+			if (op.broadcast && op.kind != OperandKind::Memory && op.kind != OperandKind::Invalid)
+				error(op.offset, op.length, "broadcast requires a memory operand");
+
+			line_.operands.push_back(std::move(op));
+		}
+
+		/** Records the decorator at @p k, such as {k1}, {z}, {1to16} or {rn-sae}, on @p op. */
+		void decorator(ParsedOperand& op, size_t k)
+		{
+			std::string_view const braced = textOf(k);
+			std::string const name = lowercase(braced.substr(1, braced.size() - 2));
+
+			if (name == "z")
+				op.zeroing = true;
+			else if (name.size() == 2 && name[0] == 'k' && name[1] >= '1' && name[1] <= '7')
+				op.mask = *Register::parse(name);
+			else if (name.compare(0, 3, "1to") == 0)
+			{
+				auto const count = parseNumber(std::string_view(name).substr(3));
+				if (count && (*count == 2 || *count == 4 || *count == 8 || *count == 16 || *count == 32))
+					op.broadcast = static_cast<uint8_t>(*count);
+				else
+					error(tokens_[k], "broadcast must be 1to2, 1to4, 1to8, 1to16 or 1to32");
+			}
+			else if (name == "sae" || name == "rn-sae" || name == "rd-sae" || name == "ru-sae" || name == "rz-sae")
+				op.rounding = name;
+			else if (name == "k0")
+				error(tokens_[k], "k0 cannot be used as a mask");
+			else
+				error(tokens_[k], "unknown decorator");
+		}
+
+		void immediate(ParsedOperand& op, size_t k, bool negate)
+		{
+			if (auto const value = parseNumber(textOf(k)))
+			{
+				op.kind = OperandKind::Immediate;
+				op.value = negate ? -*value : *value;
+			}
+			else
+				error(tokens_[k], "invalid number");
+		}
+
+		/** Parses [base + index * scale + displacement], starting at the '[' at @p i. */
+		void memory(ParsedOperand& op, size_t i, size_t end)
+		{
+			size_t close = i + 1;
+			while (close < end && !is(close, TokenKind::RightBracket))
+				++close;
+			if (close == end)
+				error(tokens_[i], "missing ']'");
+			else if (close + 1 < end)
+				error(tokens_[close + 1].offset,
+					  tokens_[end - 1].offset + tokens_[end - 1].length - tokens_[close + 1].offset,
+					  "unexpected tokens after memory operand");
+
+			AddressingMode address;
+			bool valid = true;
+			bool negative = false;
+
+			auto const addIndex = [&](Register reg, int64_t scale, const Token& at) {
+				if (scale != 1 && scale != 2 && scale != 4 && scale != 8)
+				{
+					error(at, "scale must be 1, 2, 4 or 8");
+					valid = false;
+				}
+				else if (address.index)
+				{
+					error(at, "too many registers in address");
+					valid = false;
+				}
+				else
+				{
+					address.index = reg;
+					address.scale = static_cast<uint8_t>(scale);
+				}
+			};
+
+			for (size_t k = i + 1; k < close; ++k)
+			{
+				if (isOperator(k, '+') || isOperator(k, '-'))
+				{
+					negative = isOperator(k, '-');
+					continue;
+				}
+
+				bool const scaledBy = k + 2 < close && isOperator(k + 1, '*');
+				// nasm's rel keyword, or rip as a base, which Register does not know
+				if (is(k, TokenKind::Identifier) && (equalsIgnoreCase(textOf(k), "rel") || equalsIgnoreCase(textOf(k), "rip")))
+					address.ripRelative = true;
+				else if (is(k, TokenKind::Identifier) && isOperandKeyword(textOf(k)))
+					continue;
+				else if (auto const reg = is(k, TokenKind::Identifier) ? Register::parse(textOf(k)) : std::nullopt)
+				{
+					if (negative)
+					{
+						error(tokens_[k], "registers cannot be subtracted");
+						valid = false;
+					}
+					if (scaledBy && is(k + 2, TokenKind::Number))
+					{
+						addIndex(*reg, parseNumber(textOf(k + 2)).value_or(0), tokens_[k + 2]);
+						k += 2;
+					}
+					else if (!address.base)
+						address.base = *reg;
+					else
+						addIndex(*reg, 1, tokens_[k]);
+				}
+				else if (is(k, TokenKind::Number))
+				{
+					auto const value = parseNumber(textOf(k));
+					if (!value)
+					{
+						error(tokens_[k], "invalid number");
+						valid = false;
+					}
+					else if (scaledBy && is(k + 2, TokenKind::Identifier) && Register::parse(textOf(k + 2)))
+					{
+						addIndex(*Register::parse(textOf(k + 2)), *value, tokens_[k]);
+						k += 2;
+					}
+					else
+						address.displacement += negative ? -*value : *value;
+				}
+				else if (is(k, TokenKind::Identifier) && address.symbol.empty())
+					address.symbol = std::string(textOf(k));
+				else if (is(k, TokenKind::Invalid))
+					valid = false;
+				negative = false;
+			}
+
+			if (valid)
+			{
+				op.kind = OperandKind::Memory;
+				op.address = std::move(address);
+			}
+		}
+
+		ParsedLine& line_;
+		std::string_view text_;
+		const std::vector<Token>& tokens_;
+	};
+
+	uint64_t hashOf(std::string_view line) noexcept
+	{
+		return std::hash<std::string_view>()(line);
+	}
+}
+
+std::optional<int64_t> parseNumber(std::string_view text)
+{
+	std::string digits;
+	for (char const ch: text)
+		if (ch != '_')
+			digits.push_back(ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch);
+
+	auto const baseOf = [](char ch) -> unsigned {
+		switch (ch)
+		{
+			case 'x': case 'h': return 16;
+			case 'd': case 't': return 10;
+			case 'o': case 'q': return 8;
+			case 'b': case 'y': return 2;
+			default: return 0;
+		}
+	};
+
+	auto const valueOf = [](std::string_view digits, unsigned base) -> std::optional<int64_t> {
+		if (digits.empty())
+			return std::nullopt;
+		uint64_t value = 0;
+		for (char const ch: digits)
+		{
+			unsigned const digit = ch >= '0' && ch <= '9' ? unsigned(ch - '0') : ch >= 'a' && ch <= 'f' ? unsigned(ch - 'a' + 10) : 99;
+			if (digit >= base || value > (UINT64_MAX - digit) / base)
+				return std::nullopt;
+			value = value * base + digit;
+		}
+		return static_cast<int64_t>(value);
+	};
+
+	std::string_view const d = digits;
+	if (d.size() > 1 && d[0] == '$')
+		return valueOf(d.substr(1), 16);
+
+	// A prefix wins if the rest are digits of its base, so 0b10 is binary but 0bh is hex.
+	if (d.size() > 2 && d[0] == '0' && baseOf(d[1]))
+		if (auto const value = valueOf(d.substr(2), baseOf(d[1])))
+			return value;
+
+	if (d.size() > 1 && baseOf(d.back()))
+		if (auto const value = valueOf(d.substr(0, d.size() - 1), baseOf(d.back())))
+			return value;
+
+	return valueOf(d, 10);
+}
+
+ParsedLine parseLine(std::string_view line)
+{
+	ParsedLine result;
+	result.text = std::string(line);
+	result.tokens = tokenizeLine(result.text);
+	LineParser(result).parse();
+	return result;
+}
+
+// {{{ ParseCache
+struct ParseCache::Node
+{
+	LinePtr line;
+	uint32_t priority;
+	size_t count;  //!< lines in the whole subtree
+	NodePtr left;
+	NodePtr right;
+};
+
+ParseCache::ParseCache() = default;
+ParseCache::~ParseCache() = default;
+
+ParseCache::ParseCache(ParseCache&&) noexcept = default;
+ParseCache& ParseCache::operator=(ParseCache&&) noexcept = default;
+
+size_t ParseCache::lineCount() const noexcept
+{
+	return root_ ? root_->count : 0;
+}
+
+const ParseCache::LinePtr& ParseCache::line(size_t line) const
+{
+	Node const* node = root_.get();
+	for (;;)
+	{
+		size_t const leftCount = node->left ? node->left->count : 0;
+		if (line < leftCount)
+			node = node->left.get();
+		else if (line == leftCount)
+			return node->line;
+		else
+		{
+			line -= leftCount + 1;
+			node = node->right.get();
+		}
+	}
+}
+
+ParseCache::LinePtr ParseCache::lookup(std::string_view line)
+{
+	auto& slot = cache_[hashOf(line)];
+	if (LinePtr cached = slot.lock(); cached && cached->text == line)
+		return cached;
+
+	++parseCount_;
+	auto parsed = std::make_shared<const ParsedLine>(parseLine(line));
+	slot = parsed;
+	return parsed;
+}
+
+ParseCache::NodePtr ParseCache::makeNode(LinePtr line)
+{
+	// xorshift64, as for TextBuffer's pieces
+	seed_ ^= seed_ << 13;
+	seed_ ^= seed_ >> 7;
+	seed_ ^= seed_ << 17;
+
+	auto node = std::make_unique<Node>();
+	node->line = std::move(line);
+	node->priority = static_cast<uint32_t>(seed_ >> 32);
+	node->count = 1;
+	return node;
+}
+
+void ParseCache::update(Node& node) noexcept
+{
+	node.count = 1 + (node.left ? node.left->count : 0) + (node.right ? node.right->count : 0);
+}
+
+std::pair<ParseCache::NodePtr, ParseCache::NodePtr> ParseCache::split(NodePtr node, size_t count)
+{
+	if (!node)
+		return {};
+
+	size_t const leftCount = node->left ? node->left->count : 0;
+	if (count <= leftCount)
+	{
+		auto [a, b] = split(std::move(node->left), count);
+		node->left = std::move(b);
+		update(*node);
+		return {std::move(a), std::move(node)};
+	}
+
+	auto [a, b] = split(std::move(node->right), count - leftCount - 1);
+	node->right = std::move(a);
+	update(*node);
+	return {std::move(node), std::move(b)};
+}
+
+ParseCache::NodePtr ParseCache::merge(NodePtr left, NodePtr right)
+{
+	if (!left)
+		return right;
+	if (!right)
+		return left;
+
+	if (left->priority > right->priority)
+	{
+		left->right = merge(std::move(left->right), std::move(right));
+		update(*left);
+		return left;
+	}
+
+	right->left = merge(std::move(left), std::move(right->left));
+	update(*right);
+	return right;
+}
+
+void ParseCache::reset(std::string_view text)
+{
+	NodePtr lines;
+	size_t begin = 0;
+	for (;;)
+	{
+		size_t const end = text.find('\n', begin);
+		lines = merge(std::move(lines), makeNode(lookup(text.substr(begin, end == std::string_view::npos ? std::string_view::npos : end - begin))));
+		if (end == std::string_view::npos)
+			break;
+		begin = end + 1;
+	}
+	root_ = std::move(lines);
+
+	std::erase_if(cache_, [](auto const& entry) { return entry.second.expired(); });
+}
+
+template <typename Lines, typename LineText>
+std::pair<size_t, size_t> ParseCache::replace(const TextChange& change, const Lines& lines, LineText lineText)
+{
+	size_t const newCount = lines.lineCount();
+	size_t const oldCount = lineCount();
+	size_t const first = lines.positionOf(change.offset).line;
+	size_t const last = lines.positionOf(change.offset + change.inserted).line;
+
+	// lines after the change are the same before and after it
+	size_t const trailing = newCount - 1 - last;
+	if (oldCount == 0 || trailing >= oldCount || first > oldCount - 1 - trailing)
+	{
+		root_.reset();
+		for (size_t line = 0; line < newCount; ++line)
+			root_ = merge(std::move(root_), makeNode(lookup(lineText(line))));
+		std::erase_if(cache_, [](auto const& entry) { return entry.second.expired(); });
+		return {0, newCount - 1};
+	}
+	size_t const lastOld = oldCount - 1 - trailing;
+
+	NodePtr replacement;
+	for (size_t line = first; line <= last; ++line)
+		replacement = merge(std::move(replacement), makeNode(lookup(lineText(line))));
+
+	auto [before, rest] = split(std::move(root_), first);
+	auto [dropped, after] = split(std::move(rest), lastOld + 1 - first);
+	dropped.reset();
+	root_ = merge(merge(std::move(before), std::move(replacement)), std::move(after));
+
+	if (cache_.size() > 2 * lineCount() + 64)
+		std::erase_if(cache_, [](auto const& entry) { return entry.second.expired(); });
+
+	return {first, last};
+}
+
+std::pair<size_t, size_t> ParseCache::apply(const TextChange& change, std::string_view text, const LineTable& lines)
+{
+	return replace(change, lines, [&](size_t line) {
+		size_t const begin = lines.lineStart(line);
+		size_t const end = line + 1 < lines.lineCount() ? lines.lineStart(line + 1) - 1 : text.size();
+		return text.substr(begin, end - begin);
+	});
+}
+
+std::pair<size_t, size_t> ParseCache::apply(const TextChange& change, const TextBuffer& text)
+{
+	return replace(change, text, [&](size_t line) {
+		size_t const begin = text.lineStart(line);
+		size_t const end = line + 1 < text.lineCount() ? text.lineStart(line + 1) - 1 : text.size();
+		return text.substr(begin, end - begin);
+	});
+}
+// }}}
+
+std::vector<BasicBlock*> affectedBlocks(const PositionIndex& index, SourceRange range)
+{
+	std::vector<BasicBlock*> blocks;
+	std::unordered_set<const BasicBlock*> seen;
+
+	for (Value* node: index.findOverlapping(range))
+	{
+		BasicBlock* bb = dynamic_cast<BasicBlock*>(node);
+		if (auto* instr = dynamic_cast<Instr*>(node))
+			bb = instr->getBasicBlock();
+		if (bb && seen.insert(bb).second)
+			blocks.push_back(bb);
+	}
+
+	std::sort(blocks.begin(), blocks.end(), [&](const BasicBlock* a, const BasicBlock* b) {
+		return index.currentRange(a->sourceRange()).begin < index.currentRange(b->sourceRange()).begin;
+	});
+	return blocks;
+}
+
+}
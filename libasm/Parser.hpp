@@ -0,0 +1,177 @@
+#pragma once
+
+#include <libasm/AddressingMode.hpp>
+#include <libasm/Lexer.hpp>
+#include <libasm/PositionIndex.hpp>
+#include <libasm/Register.hpp>
+#include <libasm/SourceLocation.hpp>
+#include <libasm/TextBuffer.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * A syntax error within a single line, offsets relative to the line.
+ */
+struct SyntaxError
+{
+	uint32_t offset;
+	uint32_t length;
+	std::string message;
+};
+
+enum class OperandKind : uint8_t
+{
+	Register,   //!< a register, see ParsedOperand::reg
+	Immediate,  //!< a numeric constant, see ParsedOperand::value
+	Memory,     //!< a memory reference, see ParsedOperand::address
+	Symbol,     //!< a label or data symbol, see ParsedOperand::symbol
+	Expression, //!< anything else that parses, such as msg_len + 1
+	Invalid,    //!< could not be parsed, see the line's errors
+};
+
+/**
+ * A single operand of a parsed statement.
+ */
+struct ParsedOperand
+{
+	OperandKind kind;
+	uint32_t offset; //!< relative to the line
+	uint32_t length;
+	Register reg;
+	int64_t value = 0;
+	unsigned width = 0;                    //!< explicit size specifier in bits, 0 if none
+	std::optional<AddressingMode> address;
+	std::string symbol;                    //!< also GAS numeric local label references such as 1b or 2f
+	Register mask;                         //!< {k1} through {k7} opmask, none if absent
+	bool zeroing = false;                  //!< {z}, zeroing rather than merging masking
+	uint8_t broadcast = 0;                 //!< N of {1toN}, 0 if not broadcast
+	std::string rounding;                  //!< {rn-sae} and friends or {sae} without braces, which follow the last operand
+};
+
+/**
+ * A single parsed line.
+ *
+ * Parsing never fails: whatever could not be parsed is recorded as an error
+ * and, within operands, as an Invalid operand. The rest of the statement is
+ * still available, so that a typo in one operand neither drops the
+ * instruction nor the function it is part of.
+ */
+struct ParsedLine
+{
+	std::string text;              //!< the line's content, which the cache is keyed by
+	std::string label;             //!< label defined on this line, if any
+	uint32_t labelOffset = 0;
+	std::vector<std::string> prefixes;
+	std::string mnemonic;          //!< instruction mnemonic or directive, lowercased
+	uint32_t mnemonicOffset = 0;
+	bool isDirective = false;
+	std::vector<ParsedOperand> operands; //!< empty for directives, whose operands are left to their handlers
+	std::vector<Token> tokens;
+	std::vector<SyntaxError> errors;
+
+	/** Tests whether this is an instruction that could only be parsed partially. */
+	bool isPartial() const noexcept { return !errors.empty() && !mnemonic.empty() && !isDirective; }
+};
+
+/**
+ * Parses a single line of Intel syntax assembly (NASM or GAS).
+ */
+ParsedLine parseLine(std::string_view line);
+
+/**
+ * Parses the NASM numeric literal @p text: decimal, hex with a 0x, 0h or $
+ * prefix or h or x suffix, and likewise 0d/0t, 0o/0q and 0b/0y prefixes or
+ * d/t, o/q and b/y suffixes. Underscores are ignored, signs not accepted.
+ */
+std::optional<int64_t> parseNumber(std::string_view text);
+
+/**
+ * Parsed lines of one document, kept up to date edit by edit.
+ *
+ * Lines are cached by a hash of their content: an edit re-hashes only the
+ * lines it touches, and reuses the parse of any line whose content is
+ * already known, e.g. when lines are moved or an edit is undone. Lines with
+ * identical content share one ParsedLine.
+ *
+ * The parsed lines are kept in a treap ordered by line number, like the
+ * pieces of a TextBuffer, so that an edit costs O(log n) per changed line
+ * rather than shifting all lines after it.
+ */
+class ParseCache
+{
+public:
+	using LinePtr = std::shared_ptr<const ParsedLine>;
+
+	ParseCache();
+	~ParseCache();
+
+	ParseCache(ParseCache&&) noexcept;
+	ParseCache& operator=(ParseCache&&) noexcept;
+
+	/**
+	 * (Re-)parses all lines of @p text.
+	 */
+	void reset(std::string_view text);
+
+	/**
+	 * Updates the lines affected by @p change.
+	 *
+	 * @param text  the text after the change
+	 * @param lines the line table of @p text
+	 *
+	 * @returns the first and last line, after the change, whose content changed.
+	 */
+	std::pair<size_t, size_t> apply(const TextChange& change, std::string_view text, const LineTable& lines);
+
+	/**
+	 * Same as above, for an edited TextBuffer, which also locates the lines.
+	 * Only the changed lines are read back from it, so an edit costs
+	 * O(log n) per changed line whatever the size of the document.
+	 */
+	std::pair<size_t, size_t> apply(const TextChange& change, const TextBuffer& text);
+
+	size_t lineCount() const noexcept;
+
+	/** Retrieves the parse of @p line in O(log n), which must be less than lineCount(). */
+	const LinePtr& line(size_t line) const;
+
+	/** Number of lines actually parsed, as opposed to taken from the cache, since construction. */
+	size_t parseCount() const noexcept { return parseCount_; }
+
+private:
+	struct Node;
+	using NodePtr = std::unique_ptr<Node>;
+
+	LinePtr lookup(std::string_view line);
+	NodePtr makeNode(LinePtr line);
+
+	static void update(Node& node) noexcept;
+	static std::pair<NodePtr, NodePtr> split(NodePtr node, size_t count);
+	static NodePtr merge(NodePtr left, NodePtr right);
+
+	template <typename Lines, typename LineText>
+	std::pair<size_t, size_t> replace(const TextChange& change, const Lines& lines, LineText lineText);
+
+	NodePtr root_;
+	std::unordered_map<uint64_t, std::weak_ptr<const ParsedLine>> cache_;
+	size_t parseCount_ = 0;
+	uint64_t seed_ = 0x9e3779b97f4a7c15;
+};
+
+/**
+ * Retrieves the basic blocks covering @p range of the current text, in
+ * source order, which are the ones to re-lower after an edit of that range.
+ */
+std::vector<BasicBlock*> affectedBlocks(const PositionIndex& index, SourceRange range);
+
+}
@@ -0,0 +1,228 @@
+#include <libasm/PositionIndex.hpp>
+
+#include <algorithm>
+
+namespace asmlsp
+{
+
+namespace
+{
+	SourceRange forward(SourceRange range, const std::vector<TextChange>& changes) noexcept
+	{
+		for (TextChange const& change: changes)
+			range = SourceRange{change.forward(range.begin), change.forward(range.end)};
+		return range;
+	}
+}
+
+void PositionIndex::addFunction(FunctionDefinition& function)
+{
+	flush();
+
+	std::vector<Entry> added;
+	auto const add = [&](Value& node) {
+		SourceRange const range = node.sourceRange();
+		if (!range.empty())
+			added.push_back(Entry{range.begin, range.end, &node, &function, 0});
+	};
+
+	add(function);
+	for (auto const& bb: function.basicBlocks())
+	{
+		add(*bb);
+		for (auto const& instr: bb->instructions())
+			add(*instr);
+	}
+
+	if (added.empty())
+		return;
+
+	// outer entries first on equal start; stable to keep function < block < instruction
+	auto const outerFirst = [](const Entry& a, const Entry& b) {
+		return a.begin != b.begin ? a.begin < b.begin : a.end > b.end;
+	};
+	std::stable_sort(added.begin(), added.end(), outerFirst);
+
+	size_t const addedEnd = std::max_element(added.begin(), added.end(), [](auto const& a, auto const& b) { return a.end < b.end; })->end;
+	auto const at = std::lower_bound(entries_.begin(), entries_.end(), added.front(), outerFirst);
+	size_t const first = static_cast<size_t>(at - entries_.begin());
+	bool const fits = (at == entries_.end() || at->begin >= addedEnd)
+		&& (at == entries_.begin() || std::prev(at)->end <= added.front().begin);
+
+	entries_.insert(at, added.begin(), added.end());
+
+	if (fits)
+		computeParents(first, first + added.size());
+	else
+	{
+		// overlaps previously indexed text, e.g. a function that was not removed before re-indexing
+		std::stable_sort(entries_.begin(), entries_.end(), outerFirst);
+		computeParents(0, entries_.size());
+	}
+}
+
+void PositionIndex::removeFunction(const FunctionDefinition& function)
+{
+	flush();
+
+	auto const first = std::find_if(entries_.begin(), entries_.end(), [&](const Entry& e) { return e.function == &function; });
+	if (first == entries_.end())
+		return;
+
+	auto const last = std::find_if(first, entries_.end(), [&](const Entry& e) { return e.function != &function; });
+	bool const contiguous = std::none_of(last, entries_.end(), [&](const Entry& e) { return e.function == &function; });
+
+	if (contiguous)
+		entries_.erase(first, last);
+	else
+	{
+		entries_.erase(std::remove_if(first, entries_.end(), [&](const Entry& e) { return e.function == &function; }), entries_.end());
+		computeParents(0, entries_.size());
+	}
+}
+
+void PositionIndex::clear()
+{
+	entries_.clear();
+	pending_.clear();
+}
+
+PositionIndex::Match PositionIndex::find(size_t offset) const
+{
+	for (auto change = pending_.rbegin(); change != pending_.rend(); ++change)
+	{
+		if (change->isInserted(offset))
+			return {};
+		offset = change->backward(offset);
+	}
+
+	auto i = std::upper_bound(entries_.begin(), entries_.end(), offset, [](size_t offset, const Entry& e) { return offset < e.begin; });
+	if (i == entries_.begin())
+		return {};
+
+	size_t k = static_cast<size_t>(i - entries_.begin()) - 1;
+	while (!entries_[k].contains(offset))
+	{
+		if (entries_[k].parentDistance == 0)
+			return {};
+		k -= entries_[k].parentDistance;
+	}
+
+	Match match{entries_[k].node, -1};
+	if (auto const* instr = dynamic_cast<const CpuInstr*>(match.node))
+	{
+		auto const& ranges = instr->operandRanges();
+		for (size_t n = 0; n < ranges.size(); ++n)
+		{
+			if (ranges[n].contains(offset))
+			{
+				match.operand = static_cast<int>(n);
+				break;
+			}
+		}
+	}
+	return match;
+}
+
+std::vector<Value*> PositionIndex::findOverlapping(SourceRange range) const
+{
+	size_t const begin = toBase(range.begin, false);
+	size_t const end = toBase(range.end, true);
+
+	std::vector<Value*> result;
+	if (begin >= end)
+		return result;
+
+	auto const first = std::lower_bound(entries_.begin(), entries_.end(), begin, [](const Entry& e, size_t offset) { return e.begin < offset; });
+
+	// enclosing entries starting before the range
+	if (first != entries_.begin())
+	{
+		size_t k = static_cast<size_t>(first - entries_.begin()) - 1;
+		for (;;)
+		{
+			if (entries_[k].end > begin)
+				result.push_back(entries_[k].node);
+			if (entries_[k].parentDistance == 0)
+				break;
+			k -= entries_[k].parentDistance;
+		}
+		std::reverse(result.begin(), result.end());
+	}
+
+	for (auto i = first; i != entries_.end() && i->begin < end; ++i)
+		result.push_back(i->node);
+
+	return result;
+}
+
+SourceRange PositionIndex::currentRange(SourceRange range) const noexcept
+{
+	return forward(range, pending_);
+}
+
+void PositionIndex::apply(const TextChange& change)
+{
+	pending_.push_back(change);
+	if (pending_.size() >= MaxPendingChanges)
+		flush();
+}
+
+void PositionIndex::flush()
+{
+	if (pending_.empty())
+		return;
+
+	for (Entry& entry: entries_)
+	{
+		SourceRange const range = forward(SourceRange{entry.begin, entry.end}, pending_);
+		entry.begin = range.begin;
+		entry.end = range.end;
+		entry.node->setSourceRange(range);
+
+		if (auto* instr = dynamic_cast<CpuInstr*>(entry.node); instr && !instr->operandRanges().empty())
+		{
+			std::vector<SourceRange> operands = instr->operandRanges();
+			for (SourceRange& operand: operands)
+				if (!operand.empty())
+					operand = forward(operand, pending_);
+			instr->setOperandRanges(std::move(operands));
+		}
+	}
+	pending_.clear();
+
+	// nodes whose text got deleted entirely collapsed to empty ranges
+	auto const isEmpty = [](const Entry& e) { return e.begin == e.end; };
+	if (std::any_of(entries_.begin(), entries_.end(), isEmpty))
+	{
+		entries_.erase(std::remove_if(entries_.begin(), entries_.end(), isEmpty), entries_.end());
+		computeParents(0, entries_.size());
+	}
+}
+
+size_t PositionIndex::toBase(size_t offset, bool isEnd) const noexcept
+{
+	for (auto change = pending_.rbegin(); change != pending_.rend(); ++change)
+	{
+		if (change->isInserted(offset))
+			offset = isEnd ? change->offset + change->removed : change->offset;
+		else
+			offset = change->backward(offset);
+	}
+	return offset;
+}
+
+void PositionIndex::computeParents(size_t first, size_t last)
+{
+	std::vector<size_t> open;
+	for (size_t i = first; i < last; ++i)
+	{
+		while (!open.empty() && entries_[open.back()].end <= entries_[i].begin)
+			open.pop_back();
+
+		entries_[i].parentDistance = open.empty() ? 0 : static_cast<uint32_t>(i - open.back());
+		open.push_back(i);
+	}
+}
+
+}
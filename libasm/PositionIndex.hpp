@@ -0,0 +1,109 @@
+#pragma once
+
+#include <libasm/SSA.hpp>
+#include <libasm/SourceLocation.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Maps source offsets to the IR nodes lowered from them.
+ *
+ * This is the first step of every hover, definition and highlight request.
+ * Functions, basic blocks and instructions are kept in one array sorted by
+ * start offset, each entry knowing the distance to its enclosing entry. That
+ * forms an implicit interval tree over the properly nested source ranges, so
+ * a lookup is a binary search followed by a walk of at most a few parents.
+ *
+ * Edits are recorded as pending text changes rather than shifting every
+ * entry. Lookups translate the queried offset back through the pending
+ * changes, and only once enough changes accumulated they are folded into the
+ * entries, and into the source ranges of the nodes themselves, in one pass.
+ */
+class PositionIndex
+{
+public:
+	/**
+	 * Result of a lookup.
+	 */
+	struct Match
+	{
+		Value* node = nullptr;  //!< innermost node covering the offset
+		int operand = -1;       //!< index of the CpuInstr operand covering the offset, if any
+
+		explicit operator bool() const noexcept { return node != nullptr; }
+	};
+
+	/**
+	 * Indexes @p function along with its basic blocks and instructions.
+	 *
+	 * The source ranges of the nodes must be relative to the current text.
+	 * Inserting a function whose range lies between existing ones is a
+	 * single insertion into the sorted array.
+	 */
+	void addFunction(FunctionDefinition& function);
+
+	/**
+	 * Drops @p function and all of its nodes from the index, e.g. before
+	 * indexing its re-lowered replacement.
+	 */
+	void removeFunction(const FunctionDefinition& function);
+
+	void clear();
+
+	size_t size() const noexcept { return entries_.size(); }
+
+	/**
+	 * Retrieves the innermost node at @p offset of the current text.
+	 *
+	 * Offsets within text inserted since the node was lowered yield no match.
+	 */
+	Match find(size_t offset) const;
+
+	/**
+	 * Retrieves all nodes overlapping @p range of the current text, enclosing
+	 * nodes before the nodes they enclose.
+	 */
+	std::vector<Value*> findOverlapping(SourceRange range) const;
+
+	/**
+	 * Retrieves the range of @p range, as stored on an indexed node, in the current text.
+	 */
+	SourceRange currentRange(SourceRange range) const noexcept;
+
+	/**
+	 * Shifts all indexed ranges by the given text change.
+	 */
+	void apply(const TextChange& change);
+
+	/**
+	 * Folds all pending text changes into the indexed entries and the source
+	 * ranges of their nodes.
+	 */
+	void flush();
+
+private:
+	struct Entry
+	{
+		size_t begin;
+		size_t end;
+		Value* node;
+		const FunctionDefinition* function;
+		uint32_t parentDistance; //!< index distance to the enclosing entry, 0 if none
+
+		bool contains(size_t offset) const noexcept { return begin <= offset && offset < end; }
+	};
+
+	static constexpr size_t MaxPendingChanges = 32;
+
+	size_t toBase(size_t offset, bool isEnd) const noexcept;
+	void computeParents(size_t first, size_t last);
+
+	std::vector<Entry> entries_;
+	std::vector<TextChange> pending_;
+};
+
+}
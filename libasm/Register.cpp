@@ -0,0 +1,112 @@
+#include <libasm/Register.hpp>
+
+#include <array>
+#include <cctype>
+#include <charconv>
+
+namespace asmlsp
+{
+
+namespace
+{
+	constexpr std::array<std::string_view, 8> legacyNames64 = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi"};
+	constexpr std::array<std::string_view, 8> legacyNames32 = {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi"};
+	constexpr std::array<std::string_view, 8> legacyNames16 = {"ax", "cx", "dx", "bx", "sp", "bp", "si", "di"};
+	constexpr std::array<std::string_view, 8> legacyNames8 = {"al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil"};
+	constexpr std::array<std::string_view, 4> highNames8 = {"ah", "ch", "dh", "bh"};
+
+	template <size_t N>
+	std::optional<uint8_t> lookup(const std::array<std::string_view, N>& names, std::string_view name)
+	{
+		for (size_t i = 0; i < N; ++i)
+			if (names[i] == name)
+				return static_cast<uint8_t>(i);
+		return std::nullopt;
+	}
+
+	std::optional<uint8_t> parseIndex(std::string_view digits, unsigned limit)
+	{
+		unsigned value = 0;
+		auto const [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+		if (ec != std::errc() || end != digits.data() + digits.size() || digits.empty() || value >= limit)
+			return std::nullopt;
+		return static_cast<uint8_t>(value);
+	}
+}
+
+std::string Register::name() const
+{
+	auto const numbered = [this](std::string_view prefix, std::string_view suffix = "") {
+		return std::string(prefix) + std::to_string(index_) + std::string(suffix);
+	};
+
+	switch (kind_)
+	{
+		case RegisterKind::GP8Low: return index_ < 8 ? std::string(legacyNames8[index_]) : numbered("r", "b");
+		case RegisterKind::GP8High: return std::string(highNames8[index_]);
+		case RegisterKind::GP16: return index_ < 8 ? std::string(legacyNames16[index_]) : numbered("r", "w");
+		case RegisterKind::GP32: return index_ < 8 ? std::string(legacyNames32[index_]) : numbered("r", "d");
+		case RegisterKind::GP64: return index_ < 8 ? std::string(legacyNames64[index_]) : numbered("r");
+		case RegisterKind::XMM: return numbered("xmm");
+		case RegisterKind::YMM: return numbered("ymm");
+		case RegisterKind::ZMM: return numbered("zmm");
+		case RegisterKind::Mask: return numbered("k");
+		case RegisterKind::None: break;
+	}
+	return {};
+}
+
+std::optional<Register> Register::parse(std::string_view text)
+{
+	if (text.size() > 8)
+		return std::nullopt;
+
+	std::string name(text);
+	for (char& ch: name)
+		ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+
+	if (auto const i = lookup(legacyNames64, name))
+		return Register(RegisterKind::GP64, *i);
+	if (auto const i = lookup(legacyNames32, name))
+		return Register(RegisterKind::GP32, *i);
+	if (auto const i = lookup(legacyNames16, name))
+		return Register(RegisterKind::GP16, *i);
+	if (auto const i = lookup(legacyNames8, name))
+		return Register(RegisterKind::GP8Low, *i);
+	if (auto const i = lookup(highNames8, name))
+		return Register(RegisterKind::GP8High, *i);
+
+	std::string_view const s = name;
+	for (auto const& [prefix, kind]: {std::pair{std::string_view("xmm"), RegisterKind::XMM},
+									 std::pair{std::string_view("ymm"), RegisterKind::YMM},
+									 std::pair{std::string_view("zmm"), RegisterKind::ZMM}})
+		if (s.substr(0, 3) == prefix)
+			if (auto const i = parseIndex(s.substr(3), 32))
+				return Register(kind, *i);
+
+	if (s.size() >= 2 && s[0] == 'k')
+		if (auto const i = parseIndex(s.substr(1), 8))
+			return Register(RegisterKind::Mask, *i);
+
+	if (s.size() >= 2 && s[0] == 'r')
+	{
+		// r8 .. r15 with optional b/w/d size suffix
+		RegisterKind kind = RegisterKind::GP64;
+		std::string_view digits = s.substr(1);
+		switch (digits.back())
+		{
+			case 'b': kind = RegisterKind::GP8Low; break;
+			case 'w': kind = RegisterKind::GP16; break;
+			case 'd': kind = RegisterKind::GP32; break;
+			default: break;
+		}
+		if (kind != RegisterKind::GP64)
+			digits.remove_suffix(1);
+		if (auto const i = parseIndex(digits, 16); i && *i >= 8)
+			return Register(kind, *i);
+	}
+
+	return std::nullopt;
+}
+
+}
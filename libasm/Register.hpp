@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace asmlsp
+{
+
+/**
+ * Kind of a register name, i.e. which part of a physical register it denotes.
+ */
+enum class RegisterKind : uint8_t
+{
+	None,
+	GP8Low,  //!< al, cl, ..., spl, ..., r15b
+	GP8High, //!< ah, ch, dh, bh
+	GP16,    //!< ax, ..., r15w
+	GP32,    //!< eax, ..., r15d
+	GP64,    //!< rax, ..., r15
+	XMM,     //!< xmm0 .. xmm31
+	YMM,     //!< ymm0 .. ymm31
+	ZMM,     //!< zmm0 .. zmm31
+	Mask,    //!< k0 .. k7
+};
+
+/**
+ * An x86-64 register name.
+ *
+ * All names that alias the same physical register (such as al, ah, ax,
+ * eax and rax) share the same family(), and differ only in the bit range
+ * of that physical register they denote.
+ */
+class Register
+{
+public:
+	/** Number of distinct register families, see family(). */
+	static constexpr unsigned FamilyCount = 16 + 32 + 8;
+
+	constexpr Register() noexcept = default;
+	constexpr Register(RegisterKind kind, uint8_t index) noexcept: kind_{kind}, index_{index} {}
+
+	constexpr RegisterKind kind() const noexcept { return kind_; }
+	constexpr uint8_t index() const noexcept { return index_; }
+
+	constexpr bool isGeneralPurpose() const noexcept
+	{
+		return kind_ >= RegisterKind::GP8Low && kind_ <= RegisterKind::GP64;
+	}
+
+	constexpr bool isVector() const noexcept { return kind_ >= RegisterKind::XMM && kind_ <= RegisterKind::ZMM; }
+
+	/**
+	 * Physical register this name is part of, 0..15 for general purpose,
+	 * 16..47 for vector and 48..55 for mask registers.
+	 */
+	constexpr unsigned family() const noexcept
+	{
+		if (isGeneralPurpose())
+			return index_;
+		if (isVector())
+			return 16u + index_;
+		return 48u + index_;
+	}
+
+	/** Number of bits this name denotes. */
+	constexpr unsigned width() const noexcept
+	{
+		switch (kind_)
+		{
+			case RegisterKind::GP8Low:
+			case RegisterKind::GP8High: return 8;
+			case RegisterKind::GP16: return 16;
+			case RegisterKind::GP32: return 32;
+			case RegisterKind::GP64:
+			case RegisterKind::Mask: return 64;
+			case RegisterKind::XMM: return 128;
+			case RegisterKind::YMM: return 256;
+			case RegisterKind::ZMM: return 512;
+			case RegisterKind::None: break;
+		}
+		return 0;
+	}
+
+	/** Bit offset of this name within its physical register, 8 for ah..bh, 0 otherwise. */
+	constexpr unsigned offset() const noexcept { return kind_ == RegisterKind::GP8High ? 8 : 0; }
+
+	/**
+	 * Tests whether writing this register merges with the previous contents of
+	 * its physical register rather than replacing it.
+	 *
+	 * 32 bit writes zero-extend into the full 64 bit register and are therefore
+	 * not partial. Whether vector writes merge depends on the instruction's
+	 * encoding instead (legacy SSE merges, VEX and EVEX zero-extend).
+	 */
+	constexpr bool isPartial() const noexcept
+	{
+		return kind_ == RegisterKind::GP8Low || kind_ == RegisterKind::GP8High || kind_ == RegisterKind::GP16;
+	}
+
+	/** Tests whether both names share at least one bit of the same physical register. */
+	constexpr bool overlaps(Register other) const noexcept
+	{
+		return *this && other && family() == other.family() && offset() < other.offset() + other.width()
+			   && other.offset() < offset() + width();
+	}
+
+	/** Tests whether this name denotes every bit that @p other denotes. */
+	constexpr bool covers(Register other) const noexcept
+	{
+		return *this && other && family() == other.family() && offset() <= other.offset()
+			   && other.offset() + other.width() <= offset() + width();
+	}
+
+	constexpr explicit operator bool() const noexcept { return kind_ != RegisterKind::None; }
+
+	constexpr bool operator==(Register other) const noexcept
+	{
+		return kind_ == other.kind_ && index_ == other.index_;
+	}
+	constexpr bool operator!=(Register other) const noexcept { return !(*this == other); }
+
+	/** Retrieves the canonical lower-case assembler name, such as "eax" or "xmm7". */
+	std::string name() const;
+
+	/** Parses a register name case-insensitively. */
+	static std::optional<Register> parse(std::string_view name);
+
+private:
+	RegisterKind kind_ = RegisterKind::None;
+	uint8_t index_ = 0;
+};
+
+}
@@ -1,6 +1,15 @@
 #pragma once
 
+#include <libasm/AddressingMode.hpp>
+#include <libasm/Register.hpp>
+#include <libasm/SourceLocation.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -22,6 +31,11 @@ enum class LiteralType
 	Int,
 	UInt,
 	String,
+	Float32,
+	Float64,
+	Vector128,
+	Vector256,
+	Vector512,
 };
 
 class Value
@@ -38,9 +52,17 @@ public:
 	size_t useCount() const { return uses_.size(); }
 	void replaceAllUsesWith(Value* newUse);
 
+	/**
+	 * Source text this value was lowered from, empty for synthetic values
+	 * such as phi nodes or constants.
+	 */
+	const SourceRange& sourceRange() const noexcept { return sourceRange_; }
+	void setSourceRange(SourceRange range) noexcept { sourceRange_ = range; }
+
 private:
 	LiteralType type_;
 	std::string name_;
+	SourceRange sourceRange_;
 	std::vector<Instr*> uses_;  //! list of instructions that <b>use</b> this value.
 };
 
@@ -58,13 +80,44 @@ public:
 		Constant(Ty, name), value_(std::move(value)) {}
 
 	T get() const { return value_; }
+	const T& value() const noexcept { return value_; }
 
 private:
 	T value_;
 };
 
+/**
+ * Raw contents of a vector register, stored inline.
+ */
+template <size_t Bits>
+struct VectorBits
+{
+	static constexpr size_t Size = Bits / 8;
+
+	std::array<uint8_t, Size> bytes{};
+
+	/**
+	 * Reinterprets the \p i'th lane of type \p T, e.g. lane<uint32_t>(3).
+	 */
+	template <typename T>
+	T lane(size_t i) const noexcept
+	{
+		T value;
+		std::memcpy(&value, bytes.data() + i * sizeof(T), sizeof(T));
+		return value;
+	}
+
+	bool operator==(const VectorBits& other) const noexcept { return bytes == other.bytes; }
+	bool operator!=(const VectorBits& other) const noexcept { return bytes != other.bytes; }
+};
+
 using ConstantInt = ConstantValue<int64_t, LiteralType::Int>;
 using ConstantUInt = ConstantValue<uint64_t, LiteralType::UInt>;
+using ConstantFloat32 = ConstantValue<float, LiteralType::Float32>;
+using ConstantFloat64 = ConstantValue<double, LiteralType::Float64>;
+using ConstantVector128 = ConstantValue<VectorBits<128>, LiteralType::Vector128>;
+using ConstantVector256 = ConstantValue<VectorBits<256>, LiteralType::Vector256>;
+using ConstantVector512 = ConstantValue<VectorBits<512>, LiteralType::Vector512>;
 
 class Instr: public Value
 {
@@ -177,8 +230,85 @@ class CpuInstr: public Instr {
 
     FunctionDefinition* callee() const { return (FunctionDefinition*)operand(0); }
 
+    /**
+     * Retrieves the instruction set definition this instruction is an instance of.
+     */
+    InstructionDefinition* definition() const { return definition_; }
+
+    /**
+     * Registers written by this instruction, the primary destination first.
+     */
+    const std::vector<Register>& outputRegisters() const { return outputRegisters_; }
+
+    /**
+     * Register each operand is read through, or an invalid Register for
+     * non-register operands such as immediates. Indices match operands().
+     */
+    const std::vector<Register>& operandRegisters() const { return operandRegisters_; }
+
+    /**
+     * Source text of each operand as written. Indices match operands(), for
+     * operands not written explicitly (e.g. resolved load constants) the range is empty.
+     */
+    const std::vector<SourceRange>& operandRanges() const { return operandRanges_; }
+    void setOperandRanges(std::vector<SourceRange> ranges) { operandRanges_ = std::move(ranges); }
+
+    /**
+     * Number of trailing operands that are the previous values of partially
+     * written destinations, such as rax for mov al, 1, which the result is
+     * merged into. Their operandRegisters() entries name the written register.
+     */
+    size_t mergeOperandCount() const { return mergeOperandCount_; }
+    void setMergeOperandCount(size_t count) { mergeOperandCount_ = count; }
+
+    /**
+     * Tests whether operand \p n is an implicit merge operand, see mergeOperandCount().
+     */
+    bool isMergeOperand(size_t n) const { return n < operands().size() && n + mergeOperandCount_ >= operands().size(); }
+
+    /**
+     * Tests whether this instruction reads any part of the physical register \p reg.
+     */
+    bool readsRegister(Register reg) const
+    {
+        for (Register const r: operandRegisters_)
+            if (r && r.family() == reg.family())
+                return true;
+        return false;
+    }
+
+    void setRegisters(std::vector<Register> outputs, std::vector<Register> operandRegisters)
+    {
+        outputRegisters_ = std::move(outputs);
+        operandRegisters_ = std::move(operandRegisters);
+    }
+
+    /**
+     * Retrieves the address of this instruction's memory operand, if it has one.
+     */
+    const std::optional<AddressingMode>& memoryOperand() const { return memoryOperand_; }
+    void setMemoryOperand(std::optional<AddressingMode> address) { memoryOperand_ = std::move(address); }
+
+    /**
+     * Tests whether this is a dependency breaking idiom, such as xor eax, eax,
+     * whose result does not depend on the previous value of its operands.
+     *
+     * Such instructions are pure definitions without any operands.
+     */
+    bool isDependencyBreaking() const { return dependencyBreaking_; }
+    void setDependencyBreaking(bool value) { dependencyBreaking_ = value; }
+
     std::unique_ptr<Instr> clone() override;
     void accept(InstructionVisitor& v) override;
+
+  private:
+	InstructionDefinition* definition_ = nullptr;
+	std::vector<Register> outputRegisters_;
+	std::vector<Register> operandRegisters_;
+	std::vector<SourceRange> operandRanges_;
+	std::optional<AddressingMode> memoryOperand_;
+	bool dependencyBreaking_ = false;
+	size_t mergeOperandCount_ = 0;
 };
 
 class CallInstr: public Instr {
@@ -364,4 +494,65 @@ class BasicBlock: public Value
     friend class Instr;
 };
 
+/**
+ * The value a physical register holds upon entry of a function.
+ */
+class RegisterArgument: public Value
+{
+public:
+	explicit RegisterArgument(Register reg): Value(LiteralType::Void, reg.name()), register_(reg) {}
+
+	Register getRegister() const noexcept { return register_; }
+
+private:
+	Register register_;
+};
+
+/**
+ * A user defined function, i.e. a label that is the target of at least one call.
+ *
+ * The function owns its basic blocks, the first one being the entry block.
+ */
+class FunctionDefinition: public Value
+{
+public:
+	explicit FunctionDefinition(std::string name): Value(LiteralType::Void, std::move(name)) {}
+
+	/**
+	 * Retrieves the value the physical register of \p reg holds upon entry,
+	 * creating it on first use.
+	 */
+	RegisterArgument* argument(Register reg)
+	{
+		auto& arg = arguments_[reg.family()];
+		if (!arg)
+			arg = std::make_unique<RegisterArgument>(reg);
+		return arg.get();
+	}
+
+	/**
+	 * Retrieves the basic block that is executed first upon calling this function.
+	 */
+	BasicBlock* entryBlock() const { return blocks_.empty() ? nullptr : blocks_.front().get(); }
+
+	/**
+	 * Retrieves all basic blocks of this function in their linear code order.
+	 */
+	const std::vector<std::unique_ptr<BasicBlock>>& basicBlocks() const { return blocks_; }
+
+	/**
+	 * Appends given basic block, \p bb, taking over its ownership.
+	 */
+	BasicBlock* push_back(std::unique_ptr<BasicBlock> bb)
+	{
+		bb->setParent(*this);
+		blocks_.emplace_back(std::move(bb));
+		return blocks_.back().get();
+	}
+
+private:
+	std::vector<std::unique_ptr<BasicBlock>> blocks_;
+	std::array<std::unique_ptr<RegisterArgument>, Register::FamilyCount> arguments_;
+};
+
 }
@@ -0,0 +1,122 @@
+#include <libasm/Lexer.hpp>
+#include <libasm/Register.hpp>
+#include <libasm/SemanticTokens.hpp>
+
+#include <algorithm>
+
+namespace asmlsp
+{
+
+namespace
+{
+	SemanticTokenType labelType(const LabelIndex& labels, std::string_view name)
+	{
+		return labels.kindOf(name) == SymbolKind::Function ? SemanticTokenType::Function : SemanticTokenType::Label;
+	}
+
+	void classifyLine(std::string_view line, unsigned lineNumber, const LabelIndex& labels, std::vector<SemanticToken>& out)
+	{
+		std::vector<Token> const tokens = tokenizeLine(line);
+		bool expectStatement = true;
+
+		auto const push = [&](const Token& token, SemanticTokenType type, uint32_t modifiers = 0) {
+			out.push_back(SemanticToken{lineNumber, token.offset, token.length, type, modifiers});
+		};
+
+		for (size_t i = 0; i < tokens.size(); ++i)
+		{
+			Token const& token = tokens[i];
+			std::string_view const text = token.text(line);
+			bool const followedByColon = i + 1 < tokens.size() && tokens[i + 1].kind == TokenKind::Colon;
+
+			switch (token.kind)
+			{
+				case TokenKind::Comment: push(token, SemanticTokenType::Comment); break;
+				case TokenKind::String: push(token, SemanticTokenType::String); break;
+				case TokenKind::Number:
+					if (expectStatement && followedByColon)
+						push(token, SemanticTokenType::Label, SemanticTokenModifier::Declaration); // GAS numeric local label
+					else
+						push(token, SemanticTokenType::Number);
+					break;
+				case TokenKind::Decorator: push(token, SemanticTokenType::SizeSpecifier); break;
+				case TokenKind::Operator: push(token, SemanticTokenType::Operator); break;
+				case TokenKind::Invalid:
+					push(token, text.front() == '"' || text.front() == '\'' || text.front() == '`'
+						? SemanticTokenType::String : SemanticTokenType::Operator, SemanticTokenModifier::Invalid);
+					break;
+				case TokenKind::Identifier:
+					if (expectStatement && followedByColon && !Register::parse(text))
+						push(token, labelType(labels, text), SemanticTokenModifier::Declaration);
+					else if (expectStatement && labels.kindOf(text) == SymbolKind::Data)
+						push(token, SemanticTokenType::Label, SemanticTokenModifier::Declaration); // data definition without colon
+					else if (expectStatement)
+					{
+						bool const isPrefix = isInstructionPrefix(text);
+						push(token, isDirectiveName(text) ? SemanticTokenType::Directive : SemanticTokenType::Mnemonic);
+						expectStatement = isPrefix;
+					}
+					else if (Register::parse(text))
+						push(token, SemanticTokenType::Register);
+					else if (isOperandKeyword(text))
+						push(token, SemanticTokenType::SizeSpecifier);
+					else if (isDirectiveName(text) && text.front() != '.')
+						push(token, SemanticTokenType::Directive);
+					else
+						push(token, labelType(labels, text));
+					break;
+				case TokenKind::Comma:
+				case TokenKind::Colon:
+				case TokenKind::LeftBracket:
+				case TokenKind::RightBracket:
+					break;
+			}
+		}
+	}
+}
+
+std::vector<SemanticToken> semanticTokens(std::string_view source, const LineTable& lines,
+										  const LabelIndex& labels, SourceRange range)
+{
+	std::vector<SemanticToken> tokens;
+	if (lines.lineCount() == 0)
+		return tokens;
+
+	unsigned const first = lines.positionOf(range.begin).line;
+	unsigned const last = lines.positionOf(range.end).line;
+
+	for (unsigned line = first; line <= last && line < lines.lineCount(); ++line)
+	{
+		size_t const begin = lines.lineStart(line);
+		size_t end = line + 1 < lines.lineCount() ? lines.lineStart(line + 1) - 1 : source.size();
+		end = std::min(end, source.size());
+		if (begin <= end)
+			classifyLine(source.substr(begin, end - begin), line, labels, tokens);
+	}
+
+	return tokens;
+}
+
+std::vector<uint32_t> encodeSemanticTokens(const std::vector<SemanticToken>& tokens)
+{
+	std::vector<uint32_t> data;
+	data.reserve(tokens.size() * 5);
+
+	unsigned line = 0;
+	unsigned character = 0;
+	for (SemanticToken const& token: tokens)
+	{
+		unsigned const deltaLine = token.line - line;
+		data.push_back(deltaLine);
+		data.push_back(deltaLine == 0 ? token.character - character : token.character);
+		data.push_back(token.length);
+		data.push_back(static_cast<uint32_t>(token.type));
+		data.push_back(token.modifiers);
+		line = token.line;
+		character = token.character;
+	}
+
+	return data;
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <libasm/LabelIndex.hpp>
+#include <libasm/SourceLocation.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Semantic token types, in the order of the legend announced to the client.
+ */
+enum class SemanticTokenType : uint8_t
+{
+	Comment,
+	String,
+	Number,
+	Mnemonic,
+	Directive,
+	Function,
+	Label,
+	Register,
+	SizeSpecifier,
+	Operator,
+};
+
+/**
+ * LSP token type names of SemanticTokenType, indexed by its value.
+ */
+constexpr std::array<std::string_view, 10> semanticTokenTypeLegend = {
+	"comment", "string", "number", "keyword", "macro", "function", "label", "variable", "type", "operator",
+};
+
+/**
+ * Semantic token modifier bits, in the order of the legend announced to the client.
+ */
+struct SemanticTokenModifier
+{
+	enum : uint32_t
+	{
+		Declaration = 1 << 0, //!< label definition
+		Invalid = 1 << 1,     //!< token the lexer could not make sense of
+	};
+};
+
+constexpr std::array<std::string_view, 2> semanticTokenModifierLegend = {"declaration", "invalid"};
+
+struct SemanticToken
+{
+	unsigned line;
+	unsigned character;
+	unsigned length;
+	SemanticTokenType type;
+	uint32_t modifiers;
+};
+
+/**
+ * Classifies the tokens of all lines intersecting @p range.
+ *
+ * This works on the lexical level plus the document's LabelIndex, and thus
+ * is available before any function has been lowered to SSA.
+ *
+ * Meant to serve textDocument/semanticTokens/range, which nothing handles
+ * yet, as there is no language server in this tree.
+ */
+std::vector<SemanticToken> semanticTokens(std::string_view source, const LineTable& lines,
+										  const LabelIndex& labels, SourceRange range);
+
+/**
+ * Encodes tokens in LSP's relative format of five integers per token.
+ */
+std::vector<uint32_t> encodeSemanticTokens(const std::vector<SemanticToken>& tokens);
+
+}
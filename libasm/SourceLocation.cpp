@@ -0,0 +1,34 @@
+#include <libasm/SourceLocation.hpp>
+
+#include <algorithm>
+
+namespace asmlsp
+{
+
+LineTable::LineTable(std::string_view text):
+	lineStarts_{0},
+	length_{text.size()}
+{
+	for (size_t i = 0; i < text.size(); ++i)
+		if (text[i] == '\n')
+			lineStarts_.push_back(i + 1);
+}
+
+size_t LineTable::offsetOf(Position position) const
+{
+	if (position.line >= lineStarts_.size())
+		return length_;
+
+	size_t const begin = lineStarts_[position.line];
+	size_t const end = position.line + 1 < lineStarts_.size() ? lineStarts_[position.line + 1] - 1 : length_;
+	return std::min(begin + position.character, end);
+}
+
+Position LineTable::positionOf(size_t offset) const
+{
+	offset = std::min(offset, length_);
+	auto const i = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), offset) - 1;
+	return Position{static_cast<unsigned>(i - lineStarts_.begin()), static_cast<unsigned>(offset - *i)};
+}
+
+}
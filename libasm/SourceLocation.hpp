@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Half open byte range [begin, end) within a module's source text.
+ */
+struct SourceRange
+{
+	size_t begin = 0;
+	size_t end = 0;
+
+	size_t length() const noexcept { return end - begin; }
+	bool empty() const noexcept { return begin == end; }
+	bool contains(size_t offset) const noexcept { return begin <= offset && offset < end; }
+	bool contains(const SourceRange& other) const noexcept { return begin <= other.begin && other.end <= end; }
+
+	bool operator==(const SourceRange& other) const noexcept { return begin == other.begin && end == other.end; }
+	bool operator!=(const SourceRange& other) const noexcept { return !(*this == other); }
+};
+
+/**
+ * A zero based (line, character) position as used by LSP.
+ *
+ * Characters are counted in bytes, the server negotiates the utf-8 position encoding.
+ */
+struct Position
+{
+	unsigned line = 0;
+	unsigned character = 0;
+
+	bool operator==(const Position& other) const noexcept { return line == other.line && character == other.character; }
+	bool operator!=(const Position& other) const noexcept { return !(*this == other); }
+};
+
+/**
+ * A single replacement of source text, expressed in byte offsets.
+ *
+ * The text in [offset, offset + removed) got replaced by @c inserted bytes.
+ */
+struct TextChange
+{
+	size_t offset = 0;
+	size_t removed = 0;
+	size_t inserted = 0;
+
+	/** Maps an offset from before the change to after it; offsets within the removed text collapse to its start. */
+	size_t forward(size_t pos) const noexcept
+	{
+		if (pos < offset)
+			return pos;
+		if (pos >= offset + removed)
+			return pos - removed + inserted;
+		return offset;
+	}
+
+	/** Tests whether @p pos (after the change) lies within the inserted text. */
+	bool isInserted(size_t pos) const noexcept { return pos >= offset && pos < offset + inserted; }
+
+	/** Maps an offset from after the change back to before it. Must not be within the inserted text. */
+	size_t backward(size_t pos) const noexcept { return pos < offset ? pos : pos - inserted + removed; }
+};
+
+/**
+ * Replacement of a source range by new text, as in an LSP WorkspaceEdit.
+ */
+struct TextEdit
+{
+	SourceRange range;
+	std::string newText;
+};
+
+/**
+ * Maps between byte offsets and line/character positions of a source text
+ * that does not change, such as a Document::Snapshot. Text being edited maps
+ * positions through its TextBuffer instead.
+ */
+class LineTable
+{
+public:
+	explicit LineTable(std::string_view text = {});
+
+	size_t lineCount() const noexcept { return lineStarts_.size(); }
+	size_t lineStart(size_t line) const { return lineStarts_[line]; }
+
+	size_t offsetOf(Position position) const;
+	Position positionOf(size_t offset) const;
+
+private:
+	std::vector<size_t> lineStarts_;
+	size_t length_ = 0;
+};
+
+}
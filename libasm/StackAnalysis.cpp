@@ -0,0 +1,194 @@
+#include <libasm/Dataflow.hpp>
+#include <libasm/InstructionDefinition.hpp>
+#include <libasm/StackAnalysis.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace asmlsp
+{
+
+namespace
+{
+	std::optional<int64_t> constantOf(const Value* value)
+	{
+		if (auto const* i = dynamic_cast<const ConstantInt*>(value))
+			return i->get();
+		if (auto const* u = dynamic_cast<const ConstantUInt*>(value))
+			return static_cast<int64_t>(u->get());
+		return std::nullopt;
+	}
+
+	bool isStackPointer(Register reg) noexcept
+	{
+		static Register const rsp = *Register::parse("rsp");
+		return reg && reg.family() == rsp.family();
+	}
+
+	bool isFramePointer(Register reg) noexcept
+	{
+		static Register const rbp = *Register::parse("rbp");
+		return reg && reg.family() == rbp.family();
+	}
+
+	/**
+	 * Offset of rsp to its value on entry, before and after an instruction.
+	 */
+	struct StackState
+	{
+		std::optional<int64_t> rsp = 0;
+		std::optional<int64_t> rbp; //!< rsp offset rbp was set to by mov rbp, rsp
+	};
+
+	/** Applies @p instr to @p state. */
+	void step(const CpuInstr& instr, StackState& state)
+	{
+		if (!instr.definition())
+			return;
+
+		std::string const& mnemonic = instr.definition()->mnemonic();
+		auto const& outputs = instr.outputRegisters();
+		auto const& operands = instr.operands();
+		size_t const sources = operands.size() - instr.mergeOperandCount(); // merge operands trail the written ones
+		std::vector<Register> const registers(instr.operandRegisters().begin(),
+											  instr.operandRegisters().begin() + std::min(sources, instr.operandRegisters().size()));
+		bool const writesRsp = std::any_of(outputs.begin(), outputs.end(), isStackPointer);
+		unsigned const slot = !registers.empty() && registers.front() && registers.front().width() == 16 ? 2 : 8;
+
+		auto const adjust = [&](int64_t delta) {
+			if (state.rsp)
+				*state.rsp += delta;
+		};
+
+		if (mnemonic == "push")
+			adjust(-int64_t(slot));
+		else if (mnemonic == "pop")
+		{
+			adjust(slot);
+			if (!outputs.empty() && isFramePointer(outputs.front()))
+				state.rbp.reset();
+		}
+		else if (mnemonic == "pushf" || mnemonic == "pushfq")
+			adjust(-8);
+		else if (mnemonic == "popf" || mnemonic == "popfq")
+			adjust(8);
+		else if (mnemonic == "leave")
+			state.rsp = state.rbp ? std::optional{*state.rbp + 8} : std::nullopt;
+		else if (mnemonic == "mov" && !outputs.empty() && isFramePointer(outputs.front()))
+			state.rbp = !registers.empty() && isStackPointer(registers.back()) ? state.rsp : std::nullopt;
+		else if (mnemonic == "mov" && writesRsp)
+			state.rsp = !registers.empty() && isFramePointer(registers.back()) ? state.rbp : std::nullopt;
+		else if ((mnemonic == "sub" || mnemonic == "add") && writesRsp)
+		{
+			auto const amount = sources ? constantOf(operands[sources - 1]) : std::nullopt;
+			if (amount)
+				adjust(mnemonic == "sub" ? -*amount : *amount);
+			else
+				state.rsp.reset();
+		}
+		else if (mnemonic == "lea" && writesRsp)
+		{
+			auto const& address = instr.memoryOperand();
+			bool const relative = address && isStackPointer(address->base) && !address->index && state.rsp;
+			state.rsp = relative ? std::optional{*state.rsp + address->displacement} : std::nullopt;
+		}
+		else if (writesRsp)
+			state.rsp.reset(); // and rsp, -16 and the like
+		else if (!outputs.empty() && isFramePointer(outputs.front()))
+			state.rbp.reset();
+	}
+}
+
+std::unordered_map<const CpuInstr*, int64_t> stackOffsets(const FunctionDefinition& function)
+{
+	std::unordered_map<const CpuInstr*, int64_t> offsets;
+	BasicBlock* entry = function.entryBlock();
+	if (!entry)
+		return offsets;
+
+	std::vector<BasicBlock*> const order = reversePostOrder(entry);
+	std::unordered_map<const BasicBlock*, size_t> index;
+	for (size_t i = 0; i < order.size(); ++i)
+		index[order[i]] = i;
+
+	// A block's offsets only go from unvisited to known to unknown, so it is
+	// re-visited a bounded number of times, also around loops.
+	std::vector<std::optional<StackState>> in(order.size());
+	in[0] = StackState{};
+
+	std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> worklist;
+	std::vector<bool> queued(order.size(), false);
+	worklist.push(0);
+	queued[0] = true;
+
+	auto const meet = [](std::optional<int64_t>& into, std::optional<int64_t> other) {
+		if (into != other && into)
+		{
+			into.reset();
+			return true;
+		}
+		return false;
+	};
+
+	while (!worklist.empty())
+	{
+		size_t const i = worklist.top();
+		worklist.pop();
+		queued[i] = false;
+
+		StackState state = *in[i];
+		for (auto const& instr: order[i]->instructions())
+			if (auto const* cpu = dynamic_cast<const CpuInstr*>(instr.get()))
+				step(*cpu, state);
+
+		for (BasicBlock* succ: order[i]->successors())
+		{
+			size_t const s = index.at(succ);
+			bool changed = !in[s];
+			if (changed)
+				in[s] = state;
+			else
+				changed = meet(in[s]->rsp, state.rsp) | meet(in[s]->rbp, state.rbp);
+
+			if (changed && !queued[s])
+			{
+				queued[s] = true;
+				worklist.push(s);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		StackState state = *in[i];
+		for (auto const& instr: order[i]->instructions())
+		{
+			auto const* cpu = dynamic_cast<const CpuInstr*>(instr.get());
+			if (!cpu)
+				continue;
+
+			std::optional<int64_t> const before = state.rsp;
+			step(*cpu, state);
+			bool const addresses = cpu->memoryOperand() && isStackPointer(cpu->memoryOperand()->base);
+			if (state.rsp && (state.rsp != before || addresses))
+				offsets.emplace(cpu, *state.rsp);
+		}
+	}
+
+	return offsets;
+}
+
+std::optional<int64_t> frameSize(const std::unordered_map<const CpuInstr*, int64_t>& offsets)
+{
+	if (offsets.empty())
+		return std::nullopt;
+
+	int64_t lowest = 0;
+	for (auto const& [instr, offset]: offsets)
+		lowest = std::min(lowest, offset);
+	return -lowest;
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <libasm/SSA.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+namespace asmlsp
+{
+
+/**
+ * Tracks the offset of rsp relative to its value on function entry.
+ *
+ * Understood are push and pop, add, sub and lea adjusting rsp by a constant,
+ * and rbp based frames set up by mov rbp, rsp and torn down by leave or
+ * mov rsp, rbp. Any other write to rsp, such as aligning it, makes the offset
+ * unknown. A block's offset is unknown unless all its predecessors agree on
+ * it, including those reached through back edges, so a loop that pushes
+ * without popping leaves the offsets in its body unknown.
+ *
+ * @returns the offset after each instruction that changes rsp or addresses
+ *          memory relative to it, for those where it is known.
+ */
+std::unordered_map<const CpuInstr*, int64_t> stackOffsets(const FunctionDefinition& function);
+
+/**
+ * Number of bytes the function allocates below the return address, from the
+ * result of stackOffsets(), or nothing if it never touches the stack.
+ */
+std::optional<int64_t> frameSize(const std::unordered_map<const CpuInstr*, int64_t>& offsets);
+
+}
@@ -0,0 +1,352 @@
+#include <libasm/SymbolIndex.hpp>
+#include <libasm/ThreadPool.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+namespace asmlsp
+{
+
+namespace
+{
+	/** Below this many symbols per shard, parallel search costs more than it saves. */
+	constexpr size_t ParallelSearchThreshold = 8192;
+
+	char lower(char ch) noexcept
+	{
+		return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+	}
+
+	std::string lowercase(std::string_view text)
+	{
+		std::string result(text.size(), '\0');
+		std::transform(text.begin(), text.end(), result.begin(), lower);
+		return result;
+	}
+
+	uint32_t trigram(const char* p) noexcept
+	{
+		return uint32_t(uint8_t(lower(p[0]))) << 16 | uint32_t(uint8_t(lower(p[1]))) << 8 | uint8_t(lower(p[2]));
+	}
+
+	std::vector<uint32_t> trigramsOf(std::string_view text)
+	{
+		std::vector<uint32_t> result;
+		for (size_t i = 0; i + 3 <= text.size(); ++i)
+			result.push_back(trigram(text.data() + i));
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return result;
+	}
+
+	bool isBoundary(char ch) noexcept
+	{
+		return ch == '_' || ch == '.' || ch == '@' || ch == '$';
+	}
+
+	/**
+	 * Ranks @p name (lowercased) against @p query (lowercased), 0 meaning no match.
+	 */
+	int score(std::string_view name, std::string_view query, size_t trigramHits, size_t trigramCount)
+	{
+		int const extra = static_cast<int>(std::min<size_t>(name.size() - std::min(name.size(), query.size()), 100));
+
+		if (name == query)
+			return 1000;
+
+		if (size_t const pos = name.find(query); pos != std::string_view::npos)
+		{
+			if (pos == 0)
+				return 900 - extra;
+			int const boundary = isBoundary(name[pos - 1]) ? 50 : 0;
+			return 700 + boundary - static_cast<int>(std::min<size_t>(pos, 100)) - extra / 2;
+		}
+
+		// subsequence, preferring matches at word boundaries and few gaps
+		size_t q = 0;
+		int gaps = 0;
+		int boundaries = 0;
+		for (size_t i = 0; i < name.size() && q < query.size(); ++i)
+		{
+			if (name[i] == query[q])
+			{
+				if (i == 0 || isBoundary(name[i - 1]))
+					++boundaries;
+				++q;
+			}
+			else if (q > 0)
+				++gaps;
+		}
+		if (q == query.size())
+			return std::max(200, 500 - 5 * gaps + 20 * boundaries - extra / 4);
+
+		// typo tolerant: enough shared trigrams
+		if (trigramCount != 0)
+			return static_cast<int>(100 * trigramHits / trigramCount);
+
+		return 0;
+	}
+}
+
+// {{{ Shard
+struct SymbolIndex::Shard
+{
+	struct Entry
+	{
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint32_t document;
+		SymbolKind kind;
+		bool alive;
+		SourceRange range;
+	};
+
+	/**
+	 * Ascending symbol ids, delta and varint encoded.
+	 */
+	struct Postings
+	{
+		std::string bytes;
+		uint32_t last = 0;
+
+		void append(uint32_t id)
+		{
+			uint32_t delta = id - last;
+			last = id;
+			while (delta >= 0x80)
+			{
+				bytes.push_back(static_cast<char>(0x80 | (delta & 0x7f)));
+				delta >>= 7;
+			}
+			bytes.push_back(static_cast<char>(delta));
+		}
+
+		template <typename F>
+		void forEach(F f) const
+		{
+			uint32_t id = 0;
+			size_t i = 0;
+			while (i < bytes.size())
+			{
+				uint32_t delta = 0;
+				for (unsigned shift = 0; i < bytes.size(); shift += 7)
+				{
+					auto const byte = static_cast<uint8_t>(bytes[i++]);
+					delta |= uint32_t(byte & 0x7f) << shift;
+					if (byte < 0x80)
+						break;
+				}
+				id += delta;
+				f(id);
+			}
+		}
+	};
+
+	mutable std::shared_mutex mutex;
+	std::string names; //!< interned symbol names, lowercased
+	std::vector<std::string> displayNames;
+	std::vector<Entry> entries;
+	std::vector<std::string> documents;
+	std::unordered_map<std::string, uint32_t> documentIds;
+	std::unordered_map<uint32_t, std::vector<uint32_t>> documentSymbols;
+	std::unordered_map<uint32_t, Postings> postings;
+	size_t live = 0;
+
+	std::string_view nameOf(const Entry& entry) const
+	{
+		return std::string_view(names).substr(entry.nameOffset, entry.nameLength);
+	}
+
+	uint32_t documentId(const std::string& document)
+	{
+		auto [i, inserted] = documentIds.try_emplace(document, static_cast<uint32_t>(documents.size()));
+		if (inserted)
+			documents.push_back(document);
+		return i->second;
+	}
+
+	void add(uint32_t document, const Symbol& symbol)
+	{
+		auto const id = static_cast<uint32_t>(entries.size());
+		entries.push_back(Entry{static_cast<uint32_t>(names.size()), static_cast<uint32_t>(symbol.name.size()),
+								document, symbol.kind, true, symbol.range});
+		names += lowercase(symbol.name);
+		displayNames.push_back(symbol.name);
+		documentSymbols[document].push_back(id);
+		++live;
+
+		for (uint32_t const t: trigramsOf(symbol.name))
+			postings[t].append(id);
+	}
+
+	void removeDocument(uint32_t document)
+	{
+		auto const i = documentSymbols.find(document);
+		if (i == documentSymbols.end())
+			return;
+
+		for (uint32_t const id: i->second)
+			entries[id].alive = false;
+		live -= i->second.size();
+		documentSymbols.erase(i);
+
+		if (live < entries.size() / 2)
+			compact();
+	}
+
+	/** Rebuilds the shard from its live symbols, renumbering them. */
+	void compact()
+	{
+		std::vector<std::pair<std::string, Symbol>> symbols;
+		symbols.reserve(live);
+		for (size_t id = 0; id < entries.size(); ++id)
+			if (entries[id].alive)
+				symbols.emplace_back(documents[entries[id].document],
+									 Symbol{std::move(displayNames[id]), entries[id].kind, entries[id].range});
+
+		names.clear();
+		displayNames.clear();
+		entries.clear();
+		documents.clear();
+		documentIds.clear();
+		documentSymbols.clear();
+		postings.clear();
+		live = 0;
+
+		for (auto const& [document, symbol]: symbols)
+			add(documentId(document), symbol);
+	}
+
+	std::vector<SymbolMatch> search(const std::string& query, size_t limit) const
+	{
+		std::shared_lock lock(mutex);
+
+		std::vector<std::pair<int, uint32_t>> scored;
+		std::vector<uint32_t> const trigrams = trigramsOf(query);
+
+		if (trigrams.empty())
+		{
+			for (size_t id = 0; id < entries.size(); ++id)
+				if (entries[id].alive)
+					if (int const s = score(nameOf(entries[id]), query, 0, 0); s > 0)
+						scored.emplace_back(s, static_cast<uint32_t>(id));
+		}
+		else
+		{
+			std::vector<uint16_t> hits(entries.size(), 0);
+			for (uint32_t const t: trigrams)
+				if (auto const p = postings.find(t); p != postings.end())
+					p->second.forEach([&](uint32_t id) { ++hits[id]; });
+
+			// a single typo spoils up to three trigrams, a transposition four
+			size_t const threshold = std::max((trigrams.size() + 1) / 2, trigrams.size() > 4 ? trigrams.size() - 4 : 1);
+			for (size_t id = 0; id < entries.size(); ++id)
+				if (hits[id] >= threshold && entries[id].alive)
+					if (int const s = score(nameOf(entries[id]), query, hits[id], trigrams.size()); s > 0)
+						scored.emplace_back(s, static_cast<uint32_t>(id));
+		}
+
+		auto const better = [&](auto const& a, auto const& b) {
+			return a.first != b.first ? a.first > b.first : nameOf(entries[a.second]) < nameOf(entries[b.second]);
+		};
+		size_t const n = std::min(limit, scored.size());
+		std::partial_sort(scored.begin(), scored.begin() + static_cast<ptrdiff_t>(n), scored.end(), better);
+
+		std::vector<SymbolMatch> result;
+		result.reserve(n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			Entry const& entry = entries[scored[i].second];
+			result.push_back(SymbolMatch{displayNames[scored[i].second], entry.kind, documents[entry.document], entry.range, scored[i].first});
+		}
+		return result;
+	}
+};
+// }}}
+
+SymbolIndex::SymbolIndex(size_t shardCount)
+{
+	if (shardCount == 0)
+		shardCount = std::max(1u, std::thread::hardware_concurrency());
+
+	for (size_t i = 0; i < shardCount; ++i)
+		shards_.emplace_back(std::make_unique<Shard>());
+}
+
+SymbolIndex::~SymbolIndex() = default;
+
+SymbolIndex::Shard& SymbolIndex::shardOf(const std::string& document) const
+{
+	return *shards_[std::hash<std::string>()(document) % shards_.size()];
+}
+
+void SymbolIndex::update(const std::string& document, const std::vector<Symbol>& symbols)
+{
+	Shard& shard = shardOf(document);
+	std::unique_lock lock(shard.mutex);
+
+	uint32_t const id = shard.documentId(document);
+	shard.removeDocument(id);
+
+	// compaction may have renumbered the documents
+	uint32_t const current = shard.documentId(document);
+	for (Symbol const& symbol: symbols)
+		shard.add(current, symbol);
+}
+
+void SymbolIndex::remove(const std::string& document)
+{
+	Shard& shard = shardOf(document);
+	std::unique_lock lock(shard.mutex);
+
+	if (auto const i = shard.documentIds.find(document); i != shard.documentIds.end())
+		shard.removeDocument(i->second);
+}
+
+std::vector<SymbolMatch> SymbolIndex::search(std::string_view query, size_t limit) const
+{
+	std::string const q = lowercase(query);
+	std::vector<SymbolMatch> matches;
+	if (limit == 0)
+		return matches;
+
+	if (shards_.size() > 1 && size() / shards_.size() >= ParallelSearchThreshold)
+	{
+		std::vector<std::vector<SymbolMatch>> partial(shards_.size());
+		TaskGroup group;
+		for (size_t i = 0; i < shards_.size(); ++i)
+			group.run([&, i]() { partial[i] = shards_[i]->search(q, limit); }, TaskPriority::Interactive);
+		group.wait();
+		for (auto& p: partial)
+			for (SymbolMatch& m: p)
+				matches.emplace_back(std::move(m));
+	}
+	else
+	{
+		for (auto const& shard: shards_)
+			for (SymbolMatch& m: shard->search(q, limit))
+				matches.emplace_back(std::move(m));
+	}
+
+	auto const better = [](const SymbolMatch& a, const SymbolMatch& b) {
+		return a.score != b.score ? a.score > b.score : a.name < b.name;
+	};
+	size_t const n = std::min(limit, matches.size());
+	std::partial_sort(matches.begin(), matches.begin() + static_cast<ptrdiff_t>(n), matches.end(), better);
+	matches.resize(n);
+	return matches;
+}
+
+size_t SymbolIndex::size() const
+{
+	size_t total = 0;
+	for (auto const& shard: shards_)
+	{
+		std::shared_lock lock(shard->mutex);
+		total += shard->live;
+	}
+	return total;
+}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <libasm/SourceLocation.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Kind of a named source entity.
+ */
+enum class SymbolKind : uint8_t
+{
+	Function, //!< label that is the target of a call
+	Label,    //!< any other code label
+	Data,     //!< data symbol
+	Section,
+	Macro,
+};
+
+/**
+ * A named source entity of a single document.
+ */
+struct Symbol
+{
+	std::string name;
+	SymbolKind kind;
+	SourceRange range;
+};
+
+/**
+ * Result of a workspace symbol search.
+ */
+struct SymbolMatch
+{
+	std::string name;
+	SymbolKind kind;
+	std::string document;
+	SourceRange range;
+	int score; //!< higher is better
+};
+
+/**
+ * Fuzzy searchable index of the symbols of all documents in the workspace.
+ *
+ * Documents are distributed over shards, each with its own lock, that are
+ * searched in parallel. Within a shard, every symbol gets an ascending id and
+ * each trigram of its lowercased name a posting list of those ids, delta and
+ * varint encoded. Ids are never reused, so indexing a document merely appends
+ * to posting lists. Symbols of replaced documents are tombstoned, and a shard
+ * is rebuilt once half of its symbols are dead.
+ *
+ * A query selects the symbols sharing all but four (and at least half) of
+ * its trigrams, which tolerates a typo, and ranks them by exact, prefix,
+ * substring and subsequence matches. Queries shorter than a trigram scan
+ * their shards.
+ */
+class SymbolIndex
+{
+public:
+	/**
+	 * @param shardCount number of shards, 0 for one per hardware thread
+	 */
+	explicit SymbolIndex(size_t shardCount = 0);
+	~SymbolIndex();
+
+	/**
+	 * Replaces all symbols of @p document.
+	 */
+	void update(const std::string& document, const std::vector<Symbol>& symbols);
+
+	void remove(const std::string& document);
+
+	/**
+	 * Retrieves the @p limit best matches for @p query, best first.
+	 */
+	std::vector<SymbolMatch> search(std::string_view query, size_t limit) const;
+
+	/** Number of live symbols. */
+	size_t size() const;
+
+private:
+	struct Shard;
+
+	Shard& shardOf(const std::string& document) const;
+
+	std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}
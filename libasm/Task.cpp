@@ -0,0 +1,30 @@
+#include <libasm/Task.hpp>
+
+namespace asmlsp
+{
+
+void detail::resume(std::shared_ptr<TaskContext> context, std::coroutine_handle<> handle)
+{
+	ThreadPool& pool = *context->pool;
+	TaskPriority const priority = context->priority;
+	pool.submit(
+		[context = std::move(context), handle]() {
+			// the root owns all frames of the task, down to the one suspended
+			if (context->token.isCancelled())
+				context->root.destroy();
+			else
+				handle.resume();
+		},
+		priority);
+}
+
+void spawn(Task<void> task, ThreadPool& pool, TaskPriority priority, CancellationToken token)
+{
+	auto const handle = std::exchange(task.handle_, {});
+	auto context = std::make_shared<detail::TaskContext>(detail::TaskContext{&pool, priority, std::move(token), handle});
+	handle.promise().context = context;
+	handle.promise().detached = true;
+	detail::resume(std::move(context), handle);
+}
+
+}
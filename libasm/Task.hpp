@@ -0,0 +1,301 @@
+#pragma once
+
+#include <libasm/ThreadPool.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Asynchronous request handling with C++20 coroutines.
+ *
+ * A request handler is a Task that co_awaits the results it depends on,
+ * such as an AsyncValue resolved once a document version is parsed, its SSA
+ * built or its liveness computed. Instead of blocking a worker, a waiting
+ * task is a suspended coroutine frame of a few hundred bytes, so thousands
+ * of requests may be in flight. It resumes on the ThreadPool, at the
+ * priority it was spawned with, once the value is there.
+ *
+ * A spawned task that is cancelled is dropped rather than resumed: its
+ * frames are destroyed, unwinding its locals, at its next resumption or
+ * `co_await cancellationPoint`.
+ */
+
+template <typename T = void>
+class Task;
+
+namespace detail
+{
+	/** What all coroutine frames of one spawned task share. */
+	struct TaskContext
+	{
+		ThreadPool* pool;
+		TaskPriority priority;
+		CancellationToken token;
+		std::coroutine_handle<> root;
+	};
+
+	/** Resumes @p handle on the pool, or drops the task if cancelled. */
+	void resume(std::shared_ptr<TaskContext> context, std::coroutine_handle<> handle);
+
+	struct TaskPromiseBase
+	{
+		std::coroutine_handle<> continuation = std::noop_coroutine();
+		std::shared_ptr<TaskContext> context;
+		std::exception_ptr error;
+		bool detached = false; //!< the root of a spawned task, freeing itself when done
+
+		struct FinalAwaiter
+		{
+			bool await_ready() const noexcept { return false; }
+
+			template <typename P>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<P> self) noexcept
+			{
+				TaskPromiseBase& promise = self.promise();
+				if (!promise.detached)
+					return promise.continuation;
+				self.destroy();
+				return std::noop_coroutine();
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		std::suspend_always initial_suspend() const noexcept { return {}; }
+		FinalAwaiter final_suspend() const noexcept { return {}; }
+		void unhandled_exception() noexcept { error = std::current_exception(); }
+	};
+
+	template <typename T>
+	struct TaskPromise: TaskPromiseBase
+	{
+		std::optional<T> value;
+
+		Task<T> get_return_object() noexcept;
+
+		template <typename U>
+		void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+		T take()
+		{
+			if (error)
+				std::rethrow_exception(error);
+			return std::move(*value);
+		}
+	};
+
+	template <>
+	struct TaskPromise<void>: TaskPromiseBase
+	{
+		Task<void> get_return_object() noexcept;
+
+		void return_void() const noexcept {}
+
+		void take() const
+		{
+			if (error)
+				std::rethrow_exception(error);
+		}
+	};
+}
+
+/**
+ * Lazily started coroutine producing a @p T.
+ *
+ * A task runs once co_awaited by another task, inheriting its pool,
+ * priority and cancellation, or once passed to spawn(). Exceptions
+ * propagate to the awaiting task.
+ */
+template <typename T>
+class Task
+{
+public:
+	using promise_type = detail::TaskPromise<T>;
+
+	Task(Task&& other) noexcept: handle_{std::exchange(other.handle_, {})} {}
+
+	Task& operator=(Task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (handle_)
+				handle_.destroy();
+			handle_ = std::exchange(other.handle_, {});
+		}
+		return *this;
+	}
+
+	~Task()
+	{
+		if (handle_)
+			handle_.destroy();
+	}
+
+private:
+	struct Awaiter
+	{
+		std::coroutine_handle<promise_type> handle;
+
+		bool await_ready() const noexcept { return false; }
+
+		template <typename P>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<P> awaiting) noexcept
+		{
+			handle.promise().continuation = awaiting;
+			handle.promise().context = awaiting.promise().context;
+			return handle;
+		}
+
+		T await_resume() { return handle.promise().take(); }
+	};
+
+public:
+	Awaiter operator co_await() && noexcept { return Awaiter{handle_}; }
+
+private:
+	friend promise_type;
+	friend void spawn(Task<void> task, ThreadPool& pool, TaskPriority priority, CancellationToken token);
+
+	explicit Task(std::coroutine_handle<promise_type> handle) noexcept: handle_{handle} {}
+
+	std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+Task<T> detail::TaskPromise<T>::get_return_object() noexcept
+{
+	return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+inline Task<void> detail::TaskPromise<void>::get_return_object() noexcept
+{
+	return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+/**
+ * Starts @p task on @p pool. The task owns itself from here on, and is
+ * dropped without being resumed again once @p token is cancelled. An
+ * exception escaping it is discarded, so request handlers report their
+ * errors themselves.
+ */
+void spawn(Task<void> task, ThreadPool& pool = ThreadPool::instance(), TaskPriority priority = TaskPriority::Normal,
+		   CancellationToken token = {});
+
+/**
+ * Drops the awaiting task right here if it was cancelled, continues otherwise.
+ */
+struct CancellationPoint
+{
+	bool await_ready() const noexcept { return false; }
+
+	template <typename P>
+	bool await_suspend(std::coroutine_handle<P> awaiting) const noexcept
+	{
+		std::shared_ptr<detail::TaskContext> const context = awaiting.promise().context;
+		if (!context->token.isCancelled())
+			return false;
+		context->root.destroy();
+		return true;
+	}
+
+	void await_resume() const noexcept {}
+};
+
+inline constexpr CancellationPoint cancellationPoint{};
+
+/**
+ * A value some task waits for, resolved exactly once by its producer, e.g.
+ * the SSA of a document version. Copies share the same value.
+ *
+ * co_await yields the value, or rethrows the exception it failed with.
+ * Thread safe.
+ */
+template <typename T>
+class AsyncValue
+{
+public:
+	AsyncValue(): state_{std::make_shared<State>()} {}
+
+	void set(T value) { resolve([&](State& state) { state.value.emplace(std::move(value)); }); }
+	void fail(std::exception_ptr error) { resolve([&](State& state) { state.error = std::move(error); }); }
+
+	bool ready() const noexcept { return state_->ready.load(std::memory_order_acquire); }
+
+	/** Blocks the calling thread until resolved, for callers outside of tasks. */
+	const T& wait() const
+	{
+		std::unique_lock lock(state_->mutex);
+		state_->resolved.wait(lock, [&]() { return state_->ready.load(std::memory_order_relaxed); });
+		return state_->get();
+	}
+
+	auto operator co_await() const noexcept { return Awaiter{state_}; }
+
+private:
+	struct State
+	{
+		std::mutex mutex;
+		std::condition_variable resolved;
+		std::atomic<bool> ready = false;
+		std::optional<T> value;
+		std::exception_ptr error;
+		std::vector<std::pair<std::coroutine_handle<>, std::shared_ptr<detail::TaskContext>>> waiters;
+
+		const T& get() const
+		{
+			if (error)
+				std::rethrow_exception(error);
+			return *value;
+		}
+	};
+
+	struct Awaiter
+	{
+		std::shared_ptr<State> state;
+
+		bool await_ready() const noexcept { return state->ready.load(std::memory_order_acquire); }
+
+		template <typename P>
+		bool await_suspend(std::coroutine_handle<P> awaiting)
+		{
+			std::lock_guard lock(state->mutex);
+			if (state->ready.load(std::memory_order_relaxed))
+				return false;
+			state->waiters.emplace_back(awaiting, awaiting.promise().context);
+			return true;
+		}
+
+		const T& await_resume() const { return state->get(); }
+	};
+
+	template <typename F>
+	void resolve(F assign)
+	{
+		decltype(State::waiters) waiters;
+		{
+			std::lock_guard lock(state_->mutex);
+			if (state_->ready.load(std::memory_order_relaxed))
+				return;
+			assign(*state_);
+			state_->ready.store(true, std::memory_order_release);
+			waiters.swap(state_->waiters);
+		}
+		state_->resolved.notify_all();
+		for (auto& [handle, context]: waiters)
+			detail::resume(std::move(context), handle);
+	}
+
+	std::shared_ptr<State> state_;
+};
+
+}
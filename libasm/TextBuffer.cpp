@@ -0,0 +1,312 @@
+#include <libasm/TextBuffer.hpp>
+
+#include <algorithm>
+
+namespace asmlsp
+{
+
+namespace
+{
+	size_t countNewlines(std::string_view text) noexcept
+	{
+		return static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+	}
+}
+
+struct TextBuffer::Node
+{
+	bool added;          //!< refers to added_ rather than original_
+	size_t start;
+	size_t length;
+	size_t newlines;
+	uint32_t priority;
+
+	size_t totalLength;  //!< of the whole subtree
+	size_t totalNewlines;
+	size_t totalPieces;
+
+	NodePtr left;
+	NodePtr right;
+};
+
+TextBuffer::TextBuffer(std::string text):
+	original_{std::move(text)}
+{
+	root_ = makePieces(false, 0, original_.size());
+}
+
+TextBuffer::~TextBuffer() = default;
+
+TextBuffer::TextBuffer(TextBuffer&&) noexcept = default;
+TextBuffer& TextBuffer::operator=(TextBuffer&&) noexcept = default;
+
+size_t TextBuffer::size() const noexcept
+{
+	return root_ ? root_->totalLength : 0;
+}
+
+size_t TextBuffer::lineCount() const noexcept
+{
+	return (root_ ? root_->totalNewlines : 0) + 1;
+}
+
+size_t TextBuffer::pieceCount() const noexcept
+{
+	return root_ ? root_->totalPieces : 0;
+}
+
+std::string_view TextBuffer::pieceText(const Node& node) const noexcept
+{
+	return std::string_view(node.added ? added_ : original_).substr(node.start, node.length);
+}
+
+void TextBuffer::update(Node& node) noexcept
+{
+	node.totalLength = node.length;
+	node.totalNewlines = node.newlines;
+	node.totalPieces = 1;
+	for (Node const* child: {node.left.get(), node.right.get()})
+	{
+		if (!child)
+			continue;
+		node.totalLength += child->totalLength;
+		node.totalNewlines += child->totalNewlines;
+		node.totalPieces += child->totalPieces;
+	}
+}
+
+TextBuffer::NodePtr TextBuffer::makePiece(bool added, size_t start, size_t length)
+{
+	// xorshift64, priorities need not be secure, just independent of the text
+	seed_ ^= seed_ << 13;
+	seed_ ^= seed_ >> 7;
+	seed_ ^= seed_ << 17;
+
+	auto node = std::make_unique<Node>();
+	node->added = added;
+	node->start = start;
+	node->length = length;
+	node->newlines = countNewlines(pieceText(*node));
+	node->priority = static_cast<uint32_t>(seed_ >> 32);
+	update(*node);
+	return node;
+}
+
+TextBuffer::NodePtr TextBuffer::makePieces(bool added, size_t start, size_t length)
+{
+	NodePtr result;
+	for (size_t offset = 0; offset < length; offset += MaxPieceLength)
+		result = merge(std::move(result), makePiece(added, start + offset, std::min(MaxPieceLength, length - offset)));
+	return result;
+}
+
+std::pair<TextBuffer::NodePtr, TextBuffer::NodePtr> TextBuffer::split(NodePtr node, size_t offset)
+{
+	if (!node)
+		return {};
+
+	size_t const leftLength = node->left ? node->left->totalLength : 0;
+	if (offset <= leftLength)
+	{
+		auto [a, b] = split(std::move(node->left), offset);
+		node->left = std::move(b);
+		update(*node);
+		return {std::move(a), std::move(node)};
+	}
+
+	if (offset >= leftLength + node->length)
+	{
+		auto [a, b] = split(std::move(node->right), offset - leftLength - node->length);
+		node->right = std::move(a);
+		update(*node);
+		return {std::move(node), std::move(b)};
+	}
+
+	// the split point lies within this node's piece
+	size_t const within = offset - leftLength;
+	NodePtr tail = makePiece(node->added, node->start + within, node->length - within);
+	tail->priority = node->priority; // keeps the heap order with the right subtree it takes over
+	node->length = within;
+	node->newlines -= tail->newlines;
+	tail->right = std::move(node->right);
+	update(*tail);
+	update(*node);
+	return {std::move(node), std::move(tail)};
+}
+
+TextBuffer::NodePtr TextBuffer::merge(NodePtr left, NodePtr right)
+{
+	if (!left)
+		return right;
+	if (!right)
+		return left;
+
+	if (left->priority > right->priority)
+	{
+		left->right = merge(std::move(left->right), std::move(right));
+		update(*left);
+		return left;
+	}
+
+	right->left = merge(std::move(left), std::move(right->left));
+	update(*right);
+	return right;
+}
+
+bool TextBuffer::extendLast(Node* node, size_t start, std::string_view text)
+{
+	if (!node)
+		return false;
+
+	if (node->right ? !extendLast(node->right.get(), start, text)
+					: !(node->added && node->start + node->length == start && node->length + text.size() <= MaxPieceLength))
+		return false;
+
+	if (!node->right)
+	{
+		node->length += text.size();
+		node->newlines += countNewlines(text);
+	}
+	update(*node);
+	return true;
+}
+
+size_t TextBuffer::lineStart(size_t line) const
+{
+	if (line == 0)
+		return 0;
+
+	// find the line-th newline
+	Node const* node = root_.get();
+	size_t offset = 0;
+	while (node)
+	{
+		size_t const leftNewlines = node->left ? node->left->totalNewlines : 0;
+		size_t const leftLength = node->left ? node->left->totalLength : 0;
+		if (line <= leftNewlines)
+		{
+			node = node->left.get();
+			continue;
+		}
+
+		line -= leftNewlines;
+		offset += leftLength;
+		if (line <= node->newlines)
+		{
+			std::string_view const text = pieceText(*node);
+			for (size_t i = 0; i < text.size(); ++i)
+				if (text[i] == '\n' && --line == 0)
+					return offset + i + 1;
+		}
+
+		line -= node->newlines;
+		offset += node->length;
+		node = node->right.get();
+	}
+	return size();
+}
+
+size_t TextBuffer::offsetOf(Position position) const
+{
+	if (position.line >= lineCount())
+		return size();
+
+	size_t const begin = lineStart(position.line);
+	size_t const end = position.line + 1 < lineCount() ? lineStart(position.line + 1) - 1 : size();
+	return std::min(begin + position.character, end);
+}
+
+Position TextBuffer::positionOf(size_t offset) const
+{
+	offset = std::min(offset, size());
+
+	// count the newlines before offset
+	size_t line = 0;
+	size_t remaining = offset;
+	Node const* node = root_.get();
+	while (node)
+	{
+		size_t const leftLength = node->left ? node->left->totalLength : 0;
+		if (remaining < leftLength)
+		{
+			node = node->left.get();
+			continue;
+		}
+
+		remaining -= leftLength;
+		line += node->left ? node->left->totalNewlines : 0;
+		if (remaining < node->length)
+		{
+			line += countNewlines(pieceText(*node).substr(0, remaining));
+			break;
+		}
+
+		remaining -= node->length;
+		line += node->newlines;
+		node = node->right.get();
+	}
+
+	return Position{static_cast<unsigned>(line), static_cast<unsigned>(offset - lineStart(line))};
+}
+
+TextChange TextBuffer::replace(size_t offset, size_t removed, std::string_view text)
+{
+	offset = std::min(offset, size());
+	removed = std::min(removed, size() - offset);
+
+	auto [before, rest] = split(std::move(root_), offset);
+	auto [dropped, after] = split(std::move(rest), removed);
+	dropped.reset();
+
+	size_t const start = added_.size();
+	added_ += text;
+	if (!text.empty() && !extendLast(before.get(), start, text))
+		before = merge(std::move(before), makePieces(true, start, text.size()));
+
+	root_ = merge(std::move(before), std::move(after));
+	return TextChange{offset, removed, text.size()};
+}
+
+TextChange TextBuffer::replace(Position start, Position end, std::string_view text)
+{
+	size_t const begin = offsetOf(start);
+	return replace(begin, std::max(begin, offsetOf(end)) - begin, text);
+}
+
+std::string TextBuffer::substr(size_t offset, size_t length) const
+{
+	std::string result;
+	offset = std::min(offset, size());
+	length = std::min(length, size() - offset);
+	result.reserve(length);
+
+	// in-order walk of the pieces overlapping [offset, offset + length)
+	auto const walk = [&](auto const& self, const Node* node, size_t base) -> void {
+		if (!node || result.size() == length)
+			return;
+		size_t const leftLength = node->left ? node->left->totalLength : 0;
+		size_t const pieceBegin = base + leftLength;
+		if (offset < pieceBegin)
+			self(self, node->left.get(), base);
+
+		size_t const pieceEnd = pieceBegin + node->length;
+		if (offset < pieceEnd && offset + length > pieceBegin)
+		{
+			size_t const from = std::max(offset, pieceBegin) - pieceBegin;
+			size_t const to = std::min(offset + length, pieceEnd) - pieceBegin;
+			result += pieceText(*node).substr(from, to - from);
+		}
+
+		if (offset + length > pieceEnd)
+			self(self, node->right.get(), pieceEnd);
+	};
+	walk(walk, root_.get(), 0);
+	return result;
+}
+
+std::string TextBuffer::text() const
+{
+	return substr(0, size());
+}
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <libasm/SourceLocation.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace asmlsp
+{
+
+/**
+ * Editable document text, stored as a piece table.
+ *
+ * The text is a sequence of pieces, each referring to a slice of either the
+ * original text or an append-only buffer of all inserted text. The pieces
+ * are the nodes of a treap ordered by text position, each knowing the byte
+ * and newline counts of its subtree. Replacing a range, and mapping between
+ * offsets and line/character positions, thus takes O(log n) regardless of
+ * the document's size; no text is ever moved.
+ *
+ * Pieces are at most MaxPieceLength bytes, which bounds the scan within a
+ * piece, and consecutive typing extends the last inserted piece rather than
+ * adding one per keystroke.
+ */
+class TextBuffer
+{
+public:
+	static constexpr size_t MaxPieceLength = 4096;
+
+	explicit TextBuffer(std::string text = {});
+	~TextBuffer();
+
+	TextBuffer(TextBuffer&&) noexcept;
+	TextBuffer& operator=(TextBuffer&&) noexcept;
+
+	size_t size() const noexcept;
+	size_t lineCount() const noexcept;
+
+	/** Offset of the first byte of @p line, the text's size if out of range. */
+	size_t lineStart(size_t line) const;
+
+	/** Same semantics as LineTable::offsetOf(). */
+	size_t offsetOf(Position position) const;
+
+	/** Same semantics as LineTable::positionOf(). */
+	Position positionOf(size_t offset) const;
+
+	/**
+	 * Replaces @p removed bytes at @p offset by @p text.
+	 *
+	 * @returns the change, to be forwarded to everything storing offsets into this text,
+	 *          such as PositionIndex::apply().
+	 */
+	TextChange replace(size_t offset, size_t removed, std::string_view text);
+
+	/**
+	 * Replaces the text between two positions, as sent by LSP incremental synchronization.
+	 */
+	TextChange replace(Position start, Position end, std::string_view text);
+
+	std::string substr(size_t offset, size_t length) const;
+	std::string text() const;
+
+	/** Number of pieces, i.e. nodes of the tree. */
+	size_t pieceCount() const noexcept;
+
+private:
+	struct Node;
+	using NodePtr = std::unique_ptr<Node>;
+
+	std::string_view pieceText(const Node& node) const noexcept;
+	NodePtr makePiece(bool added, size_t start, size_t length);
+	NodePtr makePieces(bool added, size_t start, size_t length);
+
+	static void update(Node& node) noexcept;
+	std::pair<NodePtr, NodePtr> split(NodePtr node, size_t offset);
+	static NodePtr merge(NodePtr left, NodePtr right);
+	bool extendLast(Node* node, size_t start, std::string_view text);
+
+	std::string original_;
+	std::string added_;
+	NodePtr root_;
+	uint64_t seed_ = 0x9e3779b97f4a7c15;
+};
+
+}
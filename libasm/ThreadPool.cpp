@@ -0,0 +1,502 @@
+#include <libasm/ThreadPool.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace asmlsp
+{
+
+namespace
+{
+	thread_local ThreadPool* currentPool = nullptr;
+	thread_local size_t currentWorker = 0;
+
+	constexpr size_t InjectionCapacity = 1024;
+}
+
+// {{{ WorkStealingDeque
+/**
+ * Chase-Lev deque, as formalized for weak memory models by Lê et al.,
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+ *
+ * Only the owning worker pushes and pops at the bottom, any thread steals
+ * from the top. Outgrown arrays are kept until destruction, as thieves may
+ * still read from them.
+ */
+class ThreadPool::WorkStealingDeque
+{
+public:
+	WorkStealingDeque(): array_{new Array(64)} { arrays_.emplace_back(array_.load(std::memory_order_relaxed)); }
+
+	void push(Job* job)
+	{
+		int64_t const b = bottom_.load(std::memory_order_relaxed);
+		int64_t const t = top_.load(std::memory_order_acquire);
+		Array* a = array_.load(std::memory_order_relaxed);
+		if (b - t > a->size - 1)
+		{
+			a = a->grow(b, t);
+			arrays_.emplace_back(a);
+			array_.store(a, std::memory_order_release);
+		}
+		a->put(b, job);
+		// a release store rather than the paper's fence, pairing with the thieves' acquire load of bottom
+		bottom_.store(b + 1, std::memory_order_release);
+	}
+
+	Job* pop()
+	{
+		int64_t const b = bottom_.load(std::memory_order_relaxed) - 1;
+		Array* a = array_.load(std::memory_order_relaxed);
+		bottom_.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top_.load(std::memory_order_relaxed);
+
+		if (t > b)
+		{
+			bottom_.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = a->get(b);
+		if (t == b)
+		{
+			// last element, race against thieves
+			if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				job = nullptr;
+			bottom_.store(b + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job* steal()
+	{
+		int64_t t = top_.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t const b = bottom_.load(std::memory_order_acquire);
+		if (t >= b)
+			return nullptr;
+
+		Job* job = array_.load(std::memory_order_acquire)->get(t);
+		if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr; // lost the race, the caller moves on
+		return job;
+	}
+
+private:
+	struct Array
+	{
+		int64_t size;
+		std::unique_ptr<std::atomic<Job*>[]> slots;
+
+		explicit Array(int64_t n): size{n}, slots{new std::atomic<Job*>[static_cast<size_t>(n)]} {}
+
+		Job* get(int64_t i) const noexcept { return slots[static_cast<size_t>(i & (size - 1))].load(std::memory_order_relaxed); }
+		void put(int64_t i, Job* job) noexcept { slots[static_cast<size_t>(i & (size - 1))].store(job, std::memory_order_relaxed); }
+
+		Array* grow(int64_t bottom, int64_t top) const
+		{
+			auto* a = new Array(2 * size);
+			for (int64_t i = top; i < bottom; ++i)
+				a->put(i, get(i));
+			return a;
+		}
+	};
+
+	alignas(64) std::atomic<int64_t> top_ = 0;
+	alignas(64) std::atomic<int64_t> bottom_ = 0;
+	std::atomic<Array*> array_;
+	std::vector<std::unique_ptr<Array>> arrays_; //!< owned by the worker
+};
+// }}}
+
+// {{{ InjectionQueue
+/**
+ * Bounded lock-free multi-producer multi-consumer queue after Dmitry Vyukov,
+ * with a locked overflow list for bursts beyond its capacity.
+ */
+class ThreadPool::InjectionQueue
+{
+public:
+	InjectionQueue(): cells_{new Cell[InjectionCapacity]}
+	{
+		for (size_t i = 0; i < InjectionCapacity; ++i)
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	void push(Job* job)
+	{
+		if (tryPush(job))
+			return;
+		std::lock_guard lock(overflowMutex_);
+		overflow_.push_back(job);
+		overflowSize_.fetch_add(1, std::memory_order_release);
+	}
+
+	Job* pop()
+	{
+		if (Job* job = tryPop())
+			return job;
+		if (overflowSize_.load(std::memory_order_acquire) == 0)
+			return nullptr;
+
+		std::lock_guard lock(overflowMutex_);
+		if (overflow_.empty())
+			return nullptr;
+		Job* job = overflow_.front();
+		overflow_.pop_front();
+		overflowSize_.fetch_sub(1, std::memory_order_release);
+		return job;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		Job* job = nullptr;
+	};
+
+	bool tryPush(Job* job)
+	{
+		size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell& cell = cells_[pos & (InjectionCapacity - 1)];
+			size_t const sequence = cell.sequence.load(std::memory_order_acquire);
+			auto const diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+			if (diff == 0)
+			{
+				if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.job = job;
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+				return false; // full
+			else
+				pos = enqueuePos_.load(std::memory_order_relaxed);
+		}
+	}
+
+	Job* tryPop()
+	{
+		size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell& cell = cells_[pos & (InjectionCapacity - 1)];
+			size_t const sequence = cell.sequence.load(std::memory_order_acquire);
+			auto const diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+			if (diff == 0)
+			{
+				if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					Job* job = cell.job;
+					cell.sequence.store(pos + InjectionCapacity, std::memory_order_release);
+					return job;
+				}
+			}
+			else if (diff < 0)
+				return nullptr; // empty
+			else
+				pos = dequeuePos_.load(std::memory_order_relaxed);
+		}
+	}
+
+	std::unique_ptr<Cell[]> cells_;
+	alignas(64) std::atomic<size_t> enqueuePos_ = 0;
+	alignas(64) std::atomic<size_t> dequeuePos_ = 0;
+
+	std::mutex overflowMutex_;
+	std::deque<Job*> overflow_;
+	std::atomic<size_t> overflowSize_ = 0;
+};
+// }}}
+
+// {{{ ThreadPool
+struct ThreadPool::Worker
+{
+	std::array<WorkStealingDeque, PriorityCount> deques;
+};
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	backgroundLimit_ = std::max<size_t>(1, threads / 4);
+
+	for (auto& queue: injected_)
+		queue = std::make_unique<InjectionQueue>();
+	for (size_t i = 0; i < threads; ++i)
+		workers_.emplace_back(std::make_unique<Worker>());
+	for (size_t i = 0; i < threads; ++i)
+		threads_.emplace_back([this, i]() { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(sleepMutex_);
+		stop_ = true;
+	}
+	sleep_.notify_all();
+	for (std::thread& thread: threads_)
+		thread.join();
+
+	// discard what was never run
+	for (auto const& worker: workers_)
+		for (WorkStealingDeque& deque: worker->deques)
+			while (Job* job = deque.pop())
+				delete job;
+	for (auto const& queue: injected_)
+		while (Job* job = queue->pop())
+			delete job;
+	for (; !timers_.empty(); timers_.pop())
+		delete timers_.top().job;
+}
+
+ThreadPool& ThreadPool::instance()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::submit(Task task, TaskPriority priority)
+{
+	push(new Job{std::move(task), priority});
+}
+
+void ThreadPool::submitAt(std::chrono::steady_clock::time_point due, Task task, TaskPriority priority)
+{
+	std::lock_guard lock(sleepMutex_);
+	timers_.push(Timer{due, new Job{std::move(task), priority}});
+	timerCount_.store(timers_.size());
+	sleep_.notify_one(); // to wait until the new timer, should it be the earliest
+}
+
+void ThreadPool::releaseDueTimers()
+{
+	if (timerCount_.load(std::memory_order_relaxed) == 0)
+		return;
+
+	std::vector<Job*> due;
+	{
+		std::lock_guard lock(sleepMutex_);
+		auto const now = std::chrono::steady_clock::now();
+		for (; !timers_.empty() && timers_.top().due <= now; timers_.pop())
+			due.push_back(timers_.top().job);
+		timerCount_.store(timers_.size());
+	}
+
+	for (Job* job: due)
+		push(job);
+}
+
+void ThreadPool::push(Job* job)
+{
+	auto const p = static_cast<size_t>(job->priority);
+
+	queued_[p].fetch_add(1, std::memory_order_seq_cst);
+	if (currentPool == this)
+		workers_[currentWorker]->deques[p].push(job);
+	else
+		injected_[p]->push(job);
+
+	wakeOne();
+}
+
+void ThreadPool::wakeOne()
+{
+	if (sleeping_.load(std::memory_order_seq_cst) == 0)
+		return;
+	std::lock_guard lock(sleepMutex_);
+	sleep_.notify_one();
+}
+
+bool ThreadPool::hasRunnableJobs() const noexcept
+{
+	return queued_[0].load() + queued_[1].load() != 0
+		|| (queued_[2].load() != 0 && runningBackground_.load() < backgroundLimit_);
+}
+
+ThreadPool::Job* ThreadPool::findJob(Worker* self, TaskPriority lowest)
+{
+	for (size_t p = 0; p <= static_cast<size_t>(lowest); ++p)
+	{
+		if (queued_[p].load(std::memory_order_relaxed) == 0)
+			continue;
+
+		bool const background = p == static_cast<size_t>(TaskPriority::Background);
+		if (background)
+		{
+			// reserve a background slot before taking a job
+			size_t running = runningBackground_.load();
+			do
+			{
+				if (running >= backgroundLimit_)
+					break;
+			} while (!runningBackground_.compare_exchange_weak(running, running + 1));
+			if (running >= backgroundLimit_)
+				continue;
+		}
+
+		Job* job = self ? self->deques[p].pop() : nullptr;
+		if (!job)
+			job = injected_[p]->pop();
+		for (size_t i = 0; !job && i < workers_.size(); ++i)
+		{
+			Worker* victim = workers_[(currentWorker + 1 + i) % workers_.size()].get();
+			if (victim != self)
+				job = victim->deques[p].steal();
+		}
+
+		if (job)
+		{
+			queued_[p].fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+		if (background)
+			runningBackground_.fetch_sub(1);
+	}
+	return nullptr;
+}
+
+void ThreadPool::run(Job* job)
+{
+	try
+	{
+		job->task();
+	}
+	catch (...)
+	{
+		// plain submitted tasks have nobody to report to, TaskGroup captures its own
+	}
+
+	if (job->priority == TaskPriority::Background)
+	{
+		runningBackground_.fetch_sub(1);
+		if (queued_[static_cast<size_t>(TaskPriority::Background)].load() != 0)
+			wakeOne();
+	}
+	delete job;
+}
+
+bool ThreadPool::runPendingTask(TaskPriority lowest)
+{
+	Worker* self = currentPool == this ? workers_[currentWorker].get() : nullptr;
+	if (Job* job = findJob(self, lowest))
+	{
+		run(job);
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+	currentPool = this;
+	currentWorker = index;
+	Worker* self = workers_[index].get();
+
+	for (;;)
+	{
+		releaseDueTimers();
+		if (Job* job = findJob(self, TaskPriority::Background))
+		{
+			run(job);
+			continue;
+		}
+
+		std::unique_lock lock(sleepMutex_);
+		if (stop_)
+			return;
+		// Announce sleeping before the last check: submit() counts a job
+		// before wakeOne() reads sleeping_, so either this check sees the
+		// job or wakeOne() sees this worker and notifies it under the lock.
+		sleeping_.fetch_add(1, std::memory_order_seq_cst);
+		if (!hasRunnableJobs())
+		{
+			if (timers_.empty())
+				sleep_.wait(lock);
+			else
+				sleep_.wait_until(lock, timers_.top().due);
+		}
+		sleeping_.fetch_sub(1, std::memory_order_seq_cst);
+	}
+}
+// }}}
+
+// {{{ TaskGroup
+TaskGroup::TaskGroup(ThreadPool& pool, CancellationToken parent):
+	pool_{pool},
+	parent_{std::move(parent)}
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	try
+	{
+		wait();
+	}
+	catch (...)
+	{
+	}
+}
+
+void TaskGroup::run(std::function<void()> task, TaskPriority priority)
+{
+	if (isCancelled())
+		return;
+
+	pool_.submit(track(std::move(task), priority), priority);
+}
+
+void TaskGroup::runAt(std::chrono::steady_clock::time_point due, std::function<void()> task, TaskPriority priority)
+{
+	if (isCancelled())
+		return;
+
+	pool_.submitAt(due, track(std::move(task), priority), priority);
+}
+
+ThreadPool::Task TaskGroup::track(std::function<void()> task, TaskPriority priority)
+{
+	// run() may be called from several tasks of the group at once
+	TaskPriority lowest = lowest_.load(std::memory_order_relaxed);
+	while (lowest < priority && !lowest_.compare_exchange_weak(lowest, priority, std::memory_order_relaxed))
+		;
+	state_->pending.fetch_add(1);
+	return [state = state_, task = std::move(task), token = cancellation_.token(), parent = parent_]() {
+		if (!token.isCancelled() && !parent.isCancelled())
+		{
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				std::lock_guard lock(state->mutex);
+				if (!state->error)
+					state->error = std::current_exception();
+			}
+		}
+		if (state->pending.fetch_sub(1) == 1)
+			state->pending.notify_all();
+	};
+}
+
+void TaskGroup::wait()
+{
+	for (size_t pending; (pending = state_->pending.load()) != 0;)
+		if (!pool_.runPendingTask(lowest_.load(std::memory_order_relaxed)))
+			state_->pending.wait(pending);
+
+	std::lock_guard lock(state_->mutex);
+	if (state_->error)
+		std::rethrow_exception(std::exchange(state_->error, nullptr));
+}
+// }}}
+
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Urgency of a task. Workers always run the most urgent task available.
+ */
+enum class TaskPriority : uint8_t
+{
+	Interactive, //!< a request the user waits for, such as hover or completion
+	Normal,      //!< analyses, batch work
+	Background,  //!< indexing; runs on a limited number of workers at a time
+};
+
+/**
+ * Cooperative cancellation flag, shared between a CancellationSource and
+ * the tasks it may cancel. A default constructed token is never cancelled.
+ */
+class CancellationToken
+{
+public:
+	CancellationToken() = default;
+
+	bool isCancelled() const noexcept { return flag_ && flag_->load(std::memory_order_relaxed); }
+
+private:
+	friend class CancellationSource;
+	explicit CancellationToken(std::shared_ptr<std::atomic<bool>> flag): flag_{std::move(flag)} {}
+
+	std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+class CancellationSource
+{
+public:
+	CancellationSource(): flag_{std::make_shared<std::atomic<bool>>(false)} {}
+
+	CancellationToken token() const { return CancellationToken(flag_); }
+	void cancel() noexcept { flag_->store(true, std::memory_order_relaxed); }
+	bool isCancelled() const noexcept { return flag_->load(std::memory_order_relaxed); }
+
+private:
+	std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+/**
+ * Work-stealing thread pool shared by all of libasm and the server.
+ *
+ * Every worker owns one Chase-Lev deque per priority: tasks submitted from
+ * a worker go to its own deque, which it pops LIFO for locality while idle
+ * workers steal FIFO from the other end. Tasks submitted from other threads
+ * go to a lock-free bounded multi-producer queue per priority. A worker
+ * looks for work in the order of priority first, then own deque, injection
+ * queue and other workers' deques.
+ *
+ * At most a quarter of the workers (at least one) run Background tasks at
+ * any time, so that a flood of indexing work leaves workers free for
+ * interactive requests.
+ */
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	/**
+	 * @param threads number of workers, 0 for one per hardware thread
+	 */
+	explicit ThreadPool(size_t threads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * The process wide pool, sized to the cores available.
+	 */
+	static ThreadPool& instance();
+
+	size_t size() const noexcept { return workers_.size(); }
+
+	void submit(Task task, TaskPriority priority = TaskPriority::Normal);
+
+	/**
+	 * Submits @p task once @p due has passed, without occupying a worker
+	 * until then. Idle workers sleep until the earliest such time.
+	 */
+	void submitAt(std::chrono::steady_clock::time_point due, Task task, TaskPriority priority = TaskPriority::Normal);
+
+	/**
+	 * Runs a single queued task of at least the given urgency on the calling
+	 * thread, if there is one. Used by threads waiting for tasks to help out.
+	 *
+	 * @returns whether a task was run.
+	 */
+	bool runPendingTask(TaskPriority lowest = TaskPriority::Background);
+
+private:
+	static constexpr size_t PriorityCount = 3;
+
+	struct Job
+	{
+		Task task;
+		TaskPriority priority;
+	};
+
+	struct Timer
+	{
+		std::chrono::steady_clock::time_point due;
+		Job* job;
+
+		bool operator>(const Timer& other) const noexcept { return due > other.due; }
+	};
+
+	class WorkStealingDeque;
+	class InjectionQueue;
+	struct Worker;
+
+	void push(Job* job);
+	void releaseDueTimers();
+	Job* findJob(Worker* self, TaskPriority lowest);
+	void run(Job* job);
+	void workerLoop(size_t index);
+	bool hasRunnableJobs() const noexcept;
+	void wakeOne();
+
+	std::vector<std::unique_ptr<Worker>> workers_;
+	std::array<std::unique_ptr<InjectionQueue>, PriorityCount> injected_;
+	std::array<std::atomic<size_t>, PriorityCount> queued_{};
+	std::atomic<size_t> runningBackground_ = 0;
+	size_t backgroundLimit_ = 1;
+
+	std::mutex sleepMutex_;
+	std::condition_variable sleep_;
+	std::atomic<size_t> sleeping_ = 0;
+	std::atomic<bool> stop_ = false;
+	std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_; //!< guarded by sleepMutex_
+	std::atomic<size_t> timerCount_ = 0; //!< size of timers_, to skip the lock while there are none
+	std::vector<std::thread> threads_;
+};
+
+/**
+ * A set of tasks that are waited for together, and cancelled together.
+ *
+ * The first exception thrown by a task is rethrown by wait(). Tasks not yet
+ * started when the group is cancelled are skipped; running ones are
+ * expected to check token() now and then. While waiting, the waiting thread
+ * runs queued tasks itself rather than blocking a worker. run() may be
+ * called from several threads at once, including the group's own tasks.
+ */
+class TaskGroup
+{
+public:
+	explicit TaskGroup(ThreadPool& pool = ThreadPool::instance(), CancellationToken parent = {});
+
+	/** Waits for all tasks, swallowing their exceptions. */
+	~TaskGroup();
+
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	void run(std::function<void()> task, TaskPriority priority = TaskPriority::Normal);
+
+	/**
+	 * Runs @p task once @p due has passed, see ThreadPool::submitAt(). Until
+	 * then, wait() waits for it without running it early.
+	 */
+	void runAt(std::chrono::steady_clock::time_point due, std::function<void()> task,
+			   TaskPriority priority = TaskPriority::Normal);
+
+	void wait();
+
+	void cancel() noexcept { cancellation_.cancel(); }
+	bool isCancelled() const noexcept { return cancellation_.isCancelled() || parent_.isCancelled(); }
+
+	/** Token of this group, for tasks to poll. */
+	CancellationToken token() const { return cancellation_.token(); }
+
+private:
+	struct State
+	{
+		std::atomic<size_t> pending = 0;
+		std::mutex mutex;
+		std::exception_ptr error;
+	};
+
+	/** Accounts for @p task in pending and wraps it to skip it once cancelled. */
+	ThreadPool::Task track(std::function<void()> task, TaskPriority priority);
+
+	ThreadPool& pool_;
+	CancellationToken parent_;
+	CancellationSource cancellation_;
+	std::shared_ptr<State> state_ = std::make_shared<State>();
+	std::atomic<TaskPriority> lowest_ = TaskPriority::Interactive; //!< least urgent priority of any task run, from any thread
+};
+
+}
@@ -0,0 +1,300 @@
+#include <libasm/UninitializedRegisterAnalysis.hpp>
+#include <libasm/Dataflow.hpp>
+#include <libasm/InstructionDefinition.hpp>
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <unordered_set>
+
+namespace asmlsp
+{
+
+namespace
+{
+	// register families, see Register::family()
+	constexpr unsigned Rax = 0, Rcx = 1, Rdx = 2, Rbx = 3, Rsp = 4, Rbp = 5, Rsi = 6, Rdi = 7;
+	constexpr unsigned R8 = 8, R9 = 9, R12 = 12, R13 = 13, R14 = 14, R15 = 15;
+	constexpr unsigned Xmm0 = 16;
+
+	RegisterSet setOf(std::initializer_list<unsigned> families)
+	{
+		RegisterSet set;
+		for (unsigned const family: families)
+			set.set(family);
+		return set;
+	}
+
+	RegisterSet vectorRange(unsigned first, unsigned last)
+	{
+		RegisterSet set;
+		for (unsigned i = first; i <= last; ++i)
+			set.set(Xmm0 + i);
+		return set;
+	}
+
+	bool isCall(const Instr& instr)
+	{
+		if (dynamic_cast<const CallInstr*>(&instr))
+			return true;
+		auto const* cpu = dynamic_cast<const CpuInstr*>(&instr);
+		return cpu && cpu->definition() && cpu->definition()->hasFlag(InstructionFlags::Call);
+	}
+
+	bool isIdentifierChar(char ch) noexcept
+	{
+		return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_';
+	}
+
+	/**
+	 * Applies @p instr to the set of defined registers. Calls report the
+	 * families they lose through @p killed.
+	 */
+	RegisterSet transfer(const CallingConvention& convention, const Instr& instr, RegisterSet defined, RegisterSet* killed = nullptr)
+	{
+		if (isCall(instr))
+		{
+			RegisterSet const after = (defined & convention.preserved) | convention.results;
+			if (killed)
+				*killed = defined & ~after;
+			return after;
+		}
+
+		if (auto const* cpu = dynamic_cast<const CpuInstr*>(&instr))
+			for (Register const reg: cpu->outputRegisters())
+				if (reg)
+					defined.set(reg.family()); // partial writes count, so as not to flag the usual mov al, ...; movzx eax, al
+		return defined;
+	}
+}
+
+// {{{ CallingConvention
+const CallingConvention& CallingConvention::systemV()
+{
+	static CallingConvention const convention{
+		setOf({Rdi, Rsi, Rdx, Rcx, R8, R9}) | vectorRange(0, 7),
+		setOf({Rbx, Rsp, Rbp, R12, R13, R14, R15}),
+		setOf({Rax, Rdx, Xmm0, Xmm0 + 1}),
+	};
+	return convention;
+}
+
+const CallingConvention& CallingConvention::microsoftX64()
+{
+	static CallingConvention const convention{
+		setOf({Rcx, Rdx, R8, R9}) | vectorRange(0, 3),
+		setOf({Rbx, Rsp, Rbp, Rsi, Rdi, R12, R13, R14, R15}) | vectorRange(6, 15),
+		setOf({Rax, Xmm0}),
+	};
+	return convention;
+}
+
+std::optional<RegisterSet> parseNatspecArguments(std::string_view comment)
+{
+	constexpr std::string_view Tag = "@param";
+
+	RegisterSet arguments;
+	bool found = false;
+	for (size_t pos = comment.find(Tag); pos != std::string_view::npos; pos = comment.find(Tag, pos + Tag.size()))
+	{
+		size_t begin = pos + Tag.size();
+		if (begin < comment.size() && isIdentifierChar(comment[begin]))
+			continue; // e.g. @params
+		while (begin < comment.size() && (comment[begin] == ' ' || comment[begin] == '\t'))
+			++begin;
+		size_t end = begin;
+		while (end < comment.size() && isIdentifierChar(comment[end]))
+			++end;
+
+		if (auto const reg = Register::parse(comment.substr(begin, end - begin)))
+		{
+			arguments.set(reg->family());
+			found = true;
+		}
+	}
+
+	if (!found)
+		return std::nullopt;
+	return arguments;
+}
+// }}}
+
+// {{{ UninitializedRegisterAnalysis
+void UninitializedRegisterAnalysis::setArguments(const FunctionDefinition& function, RegisterSet arguments)
+{
+	arguments_[&function] = arguments;
+}
+
+void UninitializedRegisterAnalysis::invalidate(const FunctionDefinition& function)
+{
+	auto const i = reads_.find(&function);
+	if (i == reads_.end())
+		return;
+	for (UninitializedRead const& read: i->second)
+		byInstr_.erase(read.instr);
+	reads_.erase(i);
+}
+
+const std::vector<UninitializedRead>& UninitializedRegisterAnalysis::reads(const FunctionDefinition& function) const
+{
+	static const std::vector<UninitializedRead> none;
+	auto const i = reads_.find(&function);
+	return i != reads_.end() ? i->second : none;
+}
+
+std::vector<Diagnostic> UninitializedRegisterAnalysis::diagnostics(const FunctionDefinition& function) const
+{
+	std::vector<Diagnostic> result;
+	for (UninitializedRead const& read: reads(function))
+	{
+		std::string message = "'" + read.reg.name() + (read.definite ? "' is read uninitialized" : "' may be read uninitialized");
+		if (read.clobber)
+		{
+			auto const* call = dynamic_cast<const CallInstr*>(read.clobber);
+			message += call && call->callee() ? ", not preserved by the call to '" + call->callee()->name() + "'"
+											  : ", not preserved by a preceding call";
+		}
+		else if (!read.definite || read.path.size() > 1)
+			message += " along " + describePath(read);
+		result.emplace_back(Diagnostic{Severity::Warning, "uninitialized-register", std::move(message), read.instr});
+	}
+	return result;
+}
+
+const UninitializedRead* UninitializedRegisterAnalysis::readAt(const CpuInstr& instr, size_t operand) const
+{
+	auto const i = byInstr_.find(&instr);
+	if (i == byInstr_.end())
+		return nullptr;
+
+	for (UninitializedRead const* read: i->second)
+		if (read->operand == operand)
+			return read;
+	return nullptr;
+}
+
+void UninitializedRegisterAnalysis::analyze(const FunctionDefinition& function)
+{
+	invalidate(function);
+	std::vector<UninitializedRead>& reads = reads_[&function];
+
+	BasicBlock* entry = function.entryBlock();
+	if (!entry)
+		return;
+
+	auto const arguments = arguments_.find(&function);
+	RegisterSet const entryState = (arguments != arguments_.end() ? arguments->second : convention_.arguments) | convention_.preserved;
+
+	auto const transferBlock = [&](BasicBlock& bb, RegisterSet defined) {
+		for (auto const& instr: bb.instructions())
+			defined = transfer(convention_, *instr, defined);
+		return defined;
+	};
+
+	auto const must = solveForward(entry, entryState, RegisterSet{}.set(), MeetOperator::Intersection, transferBlock);
+	auto const may = solveForward(entry, entryState, RegisterSet{}, MeetOperator::Union, transferBlock);
+
+	// Call in the block that last lost a register before its end, if any.
+	auto const clobberAtEnd = [&](BasicBlock& bb, unsigned family) -> const Instr* {
+		auto const& code = bb.instructions();
+		for (auto i = code.rbegin(); i != code.rend(); ++i)
+		{
+			if (isCall(**i))
+				return convention_.preserved.test(family) || convention_.results.test(family) ? nullptr : i->get();
+			if (auto const* cpu = dynamic_cast<const CpuInstr*>(i->get()))
+				for (Register const reg: cpu->outputRegisters())
+					if (reg && reg.family() == family)
+						return nullptr;
+		}
+		return nullptr;
+	};
+
+	// Walks back from @p bb along predecessors that leave @p family undefined.
+	auto const offendingPath = [&](BasicBlock* bb, unsigned family, UninitializedRead& read) {
+		std::unordered_set<const BasicBlock*> visited{bb};
+		read.path.push_back(bb);
+		while (bb != entry)
+		{
+			BasicBlock* next = nullptr;
+			for (BasicBlock* pred: bb->predecessors())
+			{
+				if (!must.contains(pred) || must.out(pred).test(family) || visited.count(pred))
+					continue;
+				// prefer predecessors that never define it, they make the more telling path
+				if (!next || (may.out(next).test(family) && !may.out(pred).test(family)))
+					next = pred;
+			}
+			if (!next)
+				break;
+
+			visited.insert(next);
+			read.path.push_back(next);
+			if ((read.clobber = clobberAtEnd(*next, family)))
+				break;
+			bb = next;
+		}
+		std::reverse(read.path.begin(), read.path.end());
+	};
+
+	for (BasicBlock* bb: must.order())
+	{
+		RegisterSet defined = must.in(bb);
+		RegisterSet possiblyDefined = may.in(bb);
+		std::array<const Instr*, Register::FamilyCount> killedBy{};
+
+		for (auto const& instr: bb->instructions())
+		{
+			auto const* cpu = dynamic_cast<const CpuInstr*>(instr.get());
+			if (cpu && !cpu->isDependencyBreaking())
+			{
+				RegisterSet reported;
+				auto const& registers = cpu->operandRegisters();
+				for (size_t operand = 0; operand < registers.size(); ++operand)
+				{
+					Register const reg = registers[operand];
+					// merging mov al, 1 into an undefined rax is fine, see transfer()
+					if (!reg || cpu->isMergeOperand(operand) || defined.test(reg.family()) || reported.test(reg.family()))
+						continue;
+					reported.set(reg.family());
+
+					UninitializedRead read{cpu, operand, reg, !possiblyDefined.test(reg.family()), killedBy[reg.family()], {}};
+					if (read.clobber)
+						read.path.push_back(bb);
+					else
+						offendingPath(bb, reg.family(), read);
+					reads.emplace_back(std::move(read));
+				}
+			}
+
+			RegisterSet killed;
+			RegisterSet const after = transfer(convention_, *instr, defined, &killed);
+			for (unsigned family = 0; family < Register::FamilyCount; ++family)
+			{
+				if (killed.test(family))
+					killedBy[family] = instr.get();
+				else if (after.test(family) && !defined.test(family))
+					killedBy[family] = nullptr;
+			}
+			defined = after;
+			possiblyDefined = transfer(convention_, *instr, possiblyDefined);
+		}
+	}
+
+	for (UninitializedRead const& read: reads)
+		byInstr_[read.instr].push_back(&read);
+}
+// }}}
+
+std::string describePath(const UninitializedRead& read)
+{
+	std::string text;
+	for (size_t i = 0; i < read.path.size(); ++i)
+	{
+		if (i)
+			text += " -> ";
+		text += read.path[i]->name();
+	}
+	return text;
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <libasm/Diagnostic.hpp>
+#include <libasm/Register.hpp>
+#include <libasm/SSA.hpp>
+
+#include <bitset>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Set of physical registers, indexed by Register::family().
+ */
+using RegisterSet = std::bitset<Register::FamilyCount>;
+
+/**
+ * What a function may rely on upon entry, and what survives a call.
+ */
+struct CallingConvention
+{
+	RegisterSet arguments; //!< defined by the caller upon entry
+	RegisterSet preserved; //!< callee-saved: hold the caller's values upon entry, and survive calls
+	RegisterSet results;   //!< defined after a call returns
+
+	/** System V AMD64, as used on Linux, BSD and macOS. */
+	static const CallingConvention& systemV();
+
+	/** Microsoft x64. */
+	static const CallingConvention& microsoftX64();
+};
+
+/**
+ * Retrieves the registers named by the <tt>@param</tt> tags of a natspec
+ * comment, such as "; @param rdi source buffer", which then replace the
+ * calling convention's argument registers of the function it documents.
+ *
+ * @returns nothing if @p comment has no <tt>@param</tt> tag naming a register.
+ */
+std::optional<RegisterSet> parseNatspecArguments(std::string_view comment);
+
+/**
+ * A read of a register that is not defined on every path reaching it.
+ */
+struct UninitializedRead
+{
+	const CpuInstr* instr;
+	size_t operand;                       //!< index into the instruction's operandRegisters()
+	Register reg;
+	bool definite;                        //!< undefined on every path, not just some
+	const Instr* clobber;                 //!< call the offending path lost the register at, nullptr if undefined since entry
+	std::vector<const BasicBlock*> path;  //!< one offending path, from the entry block or the clobbering call's block to the read
+};
+
+/**
+ * Finds reads of registers that may hold undefined content.
+ *
+ * Forward must-dataflow over a bitset of physical registers (see
+ * solveForward()). Upon entry, the calling convention's argument and
+ * callee-saved registers are defined. Writing any part of a register defines
+ * it, and a call leaves only callee-saved and result registers defined.
+ * A second may-dataflow tells reads that are undefined on every path from
+ * those undefined on some.
+ *
+ * Results are kept per function until invalidated, so the analysis runs once
+ * per edit of a function and hover merely looks the offending path up.
+ */
+class UninitializedRegisterAnalysis
+{
+public:
+	explicit UninitializedRegisterAnalysis(const CallingConvention& convention = CallingConvention::systemV()):
+		convention_{convention}
+	{
+	}
+
+	/**
+	 * Overrides the registers @p function's callers define, e.g. from
+	 * parseNatspecArguments(). Takes effect with the next analyze().
+	 */
+	void setArguments(const FunctionDefinition& function, RegisterSet arguments);
+
+	/**
+	 * (Re-)analyzes @p function.
+	 */
+	void analyze(const FunctionDefinition& function);
+
+	bool contains(const FunctionDefinition& function) const { return reads_.count(&function) != 0; }
+
+	void invalidate(const FunctionDefinition& function);
+
+	/**
+	 * Retrieves the uninitialized reads of @p function in code order, none if not analyzed.
+	 */
+	const std::vector<UninitializedRead>& reads(const FunctionDefinition& function) const;
+
+	std::vector<Diagnostic> diagnostics(const FunctionDefinition& function) const;
+
+	/**
+	 * Retrieves the finding for operand @p operand of @p instr, if any, e.g. for hover.
+	 */
+	const UninitializedRead* readAt(const CpuInstr& instr, size_t operand) const;
+
+private:
+	CallingConvention convention_;
+	std::unordered_map<const FunctionDefinition*, RegisterSet> arguments_;
+	std::unordered_map<const FunctionDefinition*, std::vector<UninitializedRead>> reads_;
+	std::unordered_map<const CpuInstr*, std::vector<const UninitializedRead*>> byInstr_; //!< into reads_
+};
+
+/**
+ * Renders the offending path of @p read, such as "entry -> .L2 -> .L4".
+ */
+std::string describePath(const UninitializedRead& read);
+
+}
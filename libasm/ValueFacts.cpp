@@ -0,0 +1,279 @@
+#include <libasm/Dataflow.hpp>
+#include <libasm/InstructionDefinition.hpp>
+#include <libasm/ValueFacts.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace asmlsp
+{
+
+namespace
+{
+	std::optional<int64_t> constantOf(const Value* value)
+	{
+		if (auto const* i = dynamic_cast<const ConstantInt*>(value))
+			return i->get();
+		if (auto const* u = dynamic_cast<const ConstantUInt*>(value))
+			return static_cast<int64_t>(u->get());
+		return std::nullopt;
+	}
+
+	KnownRange unsignedBits(unsigned bits)
+	{
+		return KnownRange{0, bits >= 63 ? INT64_MAX : (int64_t{1} << bits) - 1};
+	}
+
+	/**
+	 * Range of the value @p range holds once written to a register of @p width
+	 * bits, which zero-extends or truncates it, e.g. {-1, -1} to {0xFFFFFFFF,
+	 * 0xFFFFFFFF} in a 32-bit register.
+	 */
+	KnownRange truncate(KnownRange range, unsigned width)
+	{
+		if (width >= 64)
+			return range;
+		KnownRange const all = unsignedBits(width);
+		if (range.isConstant())
+			return KnownRange{range.min & all.max, range.min & all.max};
+		if (range.min >= 0 && range.max <= all.max)
+			return range;
+		return all;
+	}
+
+	/** Value range of a non-phi instruction, from the ranges already known for its operands. */
+	std::optional<KnownRange> rangeOf(const CpuInstr& instr, const std::unordered_map<const Value*, ValueInfo>& info)
+	{
+		if (!instr.definition() || instr.outputRegisters().empty() || !instr.outputRegisters().front().isGeneralPurpose())
+			return std::nullopt;
+
+		if (instr.isDependencyBreaking())
+			return instr.definition()->hasFlag(InstructionFlags::ZeroIdiom) ? std::optional{KnownRange{0, 0}} : std::nullopt;
+
+		std::string const& mnemonic = instr.definition()->mnemonic();
+		unsigned const width = instr.outputRegisters().front().width();
+		// without the previous values partial writes merge into, see CpuInstr::mergeOperandCount()
+		std::vector<Value*> const operands(instr.operands().begin(), instr.operands().end() - instr.mergeOperandCount());
+
+		if (mnemonic == "mov" || mnemonic == "movabs")
+		{
+			// a load, whose operands are the address rather than the value
+			if (operands.empty() || instr.memoryOperand())
+				return std::nullopt;
+			if (auto const constant = constantOf(operands.back()))
+				return truncate(KnownRange{*constant, *constant}, width);
+			if (operands.size() == 1)
+				if (auto const i = info.find(operands.front()); i != info.end() && i->second.range)
+					return truncate(*i->second.range, width);
+			return std::nullopt;
+		}
+
+		if (mnemonic == "movzx")
+		{
+			// with a memory source, the operand registers form the address
+			unsigned const sourceWidth = !instr.memoryOperand() && !instr.operandRegisters().empty() && instr.operandRegisters().front()
+				? instr.operandRegisters().front().width()
+				: instr.definition()->memoryWidth();
+			return sourceWidth ? std::optional{unsignedBits(sourceWidth)} : std::nullopt;
+		}
+
+		if (mnemonic == "and")
+		{
+			for (Value const* operand: operands)
+				if (auto const mask = constantOf(operand); mask && *mask >= 0)
+					return KnownRange{0, *mask};
+			return std::nullopt;
+		}
+
+		if (mnemonic.compare(0, 3, "set") == 0)
+			return KnownRange{0, 1};
+
+		if (mnemonic == "popcnt" || mnemonic == "lzcnt" || mnemonic == "tzcnt")
+			return KnownRange{0, static_cast<int64_t>(width)};
+
+		return std::nullopt;
+	}
+}
+
+void ValueFacts::analyze(const FunctionDefinition& function)
+{
+	invalidate(function);
+
+	BasicBlock* entry = function.entryBlock();
+	if (!entry)
+	{
+		values_[&function];
+		return;
+	}
+
+	// linear code positions, used for live range extents
+	std::vector<const Instr*> code;
+	std::unordered_map<const Instr*, size_t> position;
+	for (auto const& bb: function.basicBlocks())
+	{
+		for (auto const& instr: bb->instructions())
+		{
+			position.emplace(instr.get(), code.size());
+			code.push_back(instr.get());
+		}
+	}
+
+	std::vector<BasicBlock*> const order = reversePostOrder(entry);
+	std::unordered_map<const BasicBlock*, size_t> rpo;
+	for (size_t i = 0; i < order.size(); ++i)
+		rpo[order[i]] = i;
+
+	auto const isBackEdge = [&](const BasicBlock* from, const BasicBlock* to) {
+		return rpo.count(from) && rpo.count(to) && rpo.at(to) <= rpo.at(from);
+	};
+
+	// block a phi operand flows in from
+	auto const incomingBlock = [&](const PhiNode& phi, size_t operand) -> BasicBlock* {
+		BasicBlock* bb = phi.getBasicBlock();
+		size_t const skip = bb == entry ? 1 : 0;
+		if (operand < skip || operand - skip >= bb->predecessors().size())
+			return nullptr;
+		return bb->predecessors()[operand - skip];
+	};
+
+	struct Extent
+	{
+		size_t first = SIZE_MAX;
+		size_t last = 0;
+
+		void extend(size_t pos) { first = std::min(first, pos); last = std::max(last, pos); }
+	};
+
+	std::vector<const Value*>& values = values_[&function];
+	std::unordered_map<const Value*, Extent> extents;
+	auto const infoFor = [&](const Value* value) -> ValueInfo& {
+		auto [i, inserted] = info_.try_emplace(value);
+		if (inserted)
+			values.push_back(value);
+		return i->second;
+	};
+
+	auto const carry = [&](ValueInfo& vi, const BasicBlock* header) {
+		if (!vi.carriedLoop || rpo.at(header) > rpo.at(vi.carriedLoop))
+			vi.carriedLoop = header;
+	};
+
+	// loop extents: from the header up to the last back edge source
+	std::unordered_map<const BasicBlock*, Extent> loops;
+	for (auto const& bb: function.basicBlocks())
+		for (BasicBlock* pred: bb->predecessors())
+			if (isBackEdge(pred, bb.get()) && !bb->empty() && !pred->empty())
+			{
+				loops[bb.get()].extend(position.at(bb->front()));
+				loops[bb.get()].extend(position.at(pred->back()));
+			}
+
+	// definitions and uses
+	for (auto const& bb: function.basicBlocks())
+	{
+		for (auto const& instr: bb->instructions())
+		{
+			ValueInfo& def = infoFor(instr.get());
+			def.useCount = instr->useCount();
+			extents[instr.get()].extend(position.at(instr.get()));
+
+			auto const* phi = dynamic_cast<const PhiNode*>(instr.get());
+			for (size_t n = 0; n < instr->operands().size(); ++n)
+			{
+				Value const* operand = instr->operand(n);
+				if (!operand || dynamic_cast<const Constant*>(operand))
+					continue;
+
+				ValueInfo& use = infoFor(operand);
+				use.useCount = operand->useCount();
+
+				if (!phi)
+				{
+					extents[operand].extend(position.at(instr.get()));
+					continue;
+				}
+
+				// a phi operand is live until the end of the block it flows in from
+				BasicBlock const* from = incomingBlock(*phi, n);
+				if (from && !from->empty())
+					extents[operand].extend(position.at(from->back()));
+				if (from && isBackEdge(from, bb.get()))
+				{
+					carry(use, bb.get());
+					carry(def, bb.get());
+				}
+			}
+		}
+	}
+
+	for (const Value* value: values)
+	{
+		ValueInfo& vi = info_.at(value);
+		Extent extent = extents[value];
+		if (vi.carriedLoop)
+			if (auto const loop = loops.find(vi.carriedLoop); loop != loops.end())
+			{
+				extent.extend(loop->second.first);
+				extent.extend(loop->second.last);
+			}
+
+		if (extent.first == SIZE_MAX)
+			continue;
+
+		// values live on entry have no first instruction
+		vi.firstInstr = dynamic_cast<const Instr*>(value) ? code[extent.first] : nullptr;
+		vi.lastInstr = code[extent.last];
+	}
+
+	// value ranges; phis are revisited once their back edge definitions are known
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		for (BasicBlock* bb: order)
+		{
+			for (auto const& instr: bb->instructions())
+			{
+				ValueInfo& vi = info_.at(instr.get());
+				if (auto* phi = dynamic_cast<PhiNode*>(instr.get()))
+				{
+					std::optional<KnownRange> hull;
+					for (Value const* def: definitions_.reachingDefinitions(phi))
+					{
+						auto const i = info_.find(def);
+						if (i == info_.end() || !i->second.range)
+						{
+							hull.reset();
+							break;
+						}
+						KnownRange const& r = *i->second.range;
+						hull = hull ? KnownRange{std::min(hull->min, r.min), std::max(hull->max, r.max)} : r;
+					}
+					vi.range = hull;
+				}
+				else if (pass == 0)
+				{
+					if (auto const* cpu = dynamic_cast<const CpuInstr*>(instr.get()))
+						vi.range = rangeOf(*cpu, info_);
+				}
+			}
+		}
+	}
+}
+
+void ValueFacts::invalidate(const FunctionDefinition& function)
+{
+	auto const i = values_.find(&function);
+	if (i == values_.end())
+		return;
+
+	for (const Value* value: i->second)
+		info_.erase(value);
+	values_.erase(i);
+}
+
+const ValueInfo* ValueFacts::infoOf(const Value* value) const
+{
+	auto const i = info_.find(value);
+	return i != info_.end() ? &i->second : nullptr;
+}
+
+}
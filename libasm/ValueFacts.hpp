@@ -0,0 +1,69 @@
+#pragma once
+
+#include <libasm/DefinitionResolver.hpp>
+#include <libasm/SSA.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Inclusive range of signed integer values a register may hold.
+ */
+struct KnownRange
+{
+	int64_t min;
+	int64_t max;
+
+	bool isConstant() const noexcept { return min == max; }
+};
+
+/**
+ * Facts about a single SSA value, as shown when hovering a register.
+ */
+struct ValueInfo
+{
+	size_t useCount = 0;
+	const Instr* firstInstr = nullptr;     //!< first instruction of the live range in code order, nullptr if live on entry
+	const Instr* lastInstr = nullptr;      //!< last instruction of the live range in code order
+	std::optional<KnownRange> range;       //!< known value or value range of general purpose registers
+	const BasicBlock* carriedLoop = nullptr; //!< header of the innermost loop the value is carried around
+};
+
+/**
+ * Per function cache of ValueInfo for every value.
+ *
+ * Analyzing is done once after a function has been lowered, off the request
+ * path. Consumers like hover only look results up, and simply show less for
+ * functions not analyzed yet rather than computing anything on demand.
+ */
+class ValueFacts
+{
+public:
+	explicit ValueFacts(DefinitionResolver& definitions): definitions_{definitions} {}
+
+	/**
+	 * (Re-)computes the facts of all values of @p function.
+	 */
+	void analyze(const FunctionDefinition& function);
+
+	bool contains(const FunctionDefinition& function) const { return values_.count(&function) != 0; }
+
+	void invalidate(const FunctionDefinition& function);
+
+	/**
+	 * Retrieves the facts of @p value, or nullptr if its function was not analyzed.
+	 */
+	const ValueInfo* infoOf(const Value* value) const;
+
+private:
+	DefinitionResolver& definitions_;
+	std::unordered_map<const FunctionDefinition*, std::vector<const Value*>> values_;
+	std::unordered_map<const Value*, ValueInfo> info_;
+};
+
+}
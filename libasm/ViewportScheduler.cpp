@@ -0,0 +1,112 @@
+#include <libasm/ViewportScheduler.hpp>
+
+#include <algorithm>
+
+namespace asmlsp
+{
+
+void ViewportScheduler::schedule(const std::string& document, std::vector<SourceRange> functions)
+{
+	std::sort(functions.begin(), functions.end(), [](SourceRange a, SourceRange b) { return a.begin < b.begin; });
+
+	std::lock_guard lock(mutex_);
+	Document& doc = documents_[document];
+	doc.functions = std::move(functions);
+	doc.done.assign(doc.functions.size(), false);
+	doc.remaining = doc.functions.size();
+	resetCursors(doc);
+}
+
+void ViewportScheduler::setViewport(const std::string& document, SourceRange visible)
+{
+	std::lock_guard lock(mutex_);
+	Document& doc = documents_[document];
+	doc.viewport = visible;
+	doc.focus = ++clock_;
+	resetCursors(doc);
+}
+
+void ViewportScheduler::remove(const std::string& document)
+{
+	std::lock_guard lock(mutex_);
+	documents_.erase(document);
+}
+
+void ViewportScheduler::resetCursors(Document& doc)
+{
+	if (!doc.viewport)
+	{
+		doc.below = 0;
+		doc.above = 0;
+		return;
+	}
+
+	// the first function ending after the viewport's begin is the topmost one that may intersect it
+	auto const first = std::partition_point(doc.functions.begin(), doc.functions.end(),
+											[&](SourceRange f) { return f.end <= doc.viewport->begin; });
+	doc.below = static_cast<size_t>(first - doc.functions.begin());
+	doc.above = doc.below;
+}
+
+std::optional<size_t> ViewportScheduler::take(Document& doc)
+{
+	while (doc.below < doc.functions.size() && doc.done[doc.below])
+		++doc.below;
+	while (doc.above > 0 && doc.done[doc.above - 1])
+		--doc.above;
+
+	bool const hasBelow = doc.below < doc.functions.size();
+	bool const hasAbove = doc.above > 0;
+	if (!hasBelow && !hasAbove)
+		return std::nullopt;
+
+	size_t index;
+	if (!hasAbove)
+		index = doc.below;
+	else if (!hasBelow)
+		index = doc.above - 1;
+	else
+	{
+		// functions intersecting the viewport lie below the cursor and have distance 0
+		SourceRange const visible = *doc.viewport;
+		size_t const distanceBelow = doc.functions[doc.below].begin > visible.end
+			? doc.functions[doc.below].begin - visible.end : 0;
+		size_t const distanceAbove = visible.begin - std::min(visible.begin, doc.functions[doc.above - 1].end);
+		index = distanceBelow <= distanceAbove ? doc.below : doc.above - 1;
+	}
+
+	doc.done[index] = true;
+	--doc.remaining;
+	return index;
+}
+
+std::optional<ViewportScheduler::Job> ViewportScheduler::next()
+{
+	std::lock_guard lock(mutex_);
+
+	// most recently focused first, never focused ones last
+	std::pair<const std::string, Document>* best = nullptr;
+	for (auto& entry: documents_)
+		if (entry.second.remaining != 0 && (!best || entry.second.focus > best->second.focus))
+			best = &entry;
+
+	if (!best)
+		return std::nullopt;
+
+	auto const index = take(best->second);
+	if (!index)
+		return std::nullopt;
+
+	return Job{best->first, best->second.functions[*index]};
+}
+
+size_t ViewportScheduler::pending() const
+{
+	std::lock_guard lock(mutex_);
+	size_t total = 0;
+	for (auto const& [name, doc]: documents_)
+		total += doc.remaining;
+	return total;
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <libasm/SourceLocation.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace asmlsp
+{
+
+/**
+ * Orders the functions awaiting analysis so that what the user is looking at
+ * is analyzed first.
+ *
+ * Functions intersecting the visible range of the most recently scrolled
+ * document come first, then the remaining functions of that document by
+ * their distance to the viewport, alternating between above and below. Other
+ * documents follow in the order their viewports were last set; documents
+ * that were never shown are processed from their beginning.
+ *
+ * Thread safe, so that a server can update the viewport while workers pull
+ * jobs. No such server or worker loop exists yet, so nothing schedules or
+ * pulls jobs so far.
+ */
+class ViewportScheduler
+{
+public:
+	struct Job
+	{
+		std::string document;
+		SourceRange range; //!< function to analyze
+	};
+
+	/**
+	 * Replaces the functions of @p document awaiting analysis.
+	 */
+	void schedule(const std::string& document, std::vector<SourceRange> functions);
+
+	/**
+	 * Moves the focus to @p visible of @p document.
+	 */
+	void setViewport(const std::string& document, SourceRange visible);
+
+	void remove(const std::string& document);
+
+	/**
+	 * Retrieves and removes the most urgent job, if any.
+	 */
+	std::optional<Job> next();
+
+	/** Number of jobs not yet handed out. */
+	size_t pending() const;
+
+private:
+	struct Document
+	{
+		std::vector<SourceRange> functions; //!< sorted by begin
+		std::vector<bool> done;
+		std::optional<SourceRange> viewport;
+		uint64_t focus = 0;    //!< when the viewport was set, 0 for never
+		size_t below = 0;      //!< next candidate at or after the viewport
+		size_t above = 0;      //!< one past the next candidate before the viewport
+		size_t remaining = 0;
+	};
+
+	void resetCursors(Document& document);
+	std::optional<size_t> take(Document& document);
+
+	mutable std::mutex mutex_;
+	std::unordered_map<std::string, Document> documents_;
+	uint64_t clock_ = 0;
+};
+
+}
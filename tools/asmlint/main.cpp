@@ -0,0 +1,348 @@
+#include <libasm/ContentCache.hpp>
+#include <libasm/Lint.hpp>
+#include <libasm/ThreadPool.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace asmlsp;
+
+namespace
+{
+	/** Bump whenever lint results for the same input may change, invalidating all caches. */
+	constexpr unsigned LintVersion = 3;
+
+	enum class Format
+	{
+		Text,
+		Json,
+		Sarif,
+	};
+
+	struct Options
+	{
+		std::vector<std::string> paths;
+		Format format = Format::Text;
+		size_t jobs = 0;
+		std::string cacheFile;
+		std::optional<Dialect> dialect;  //!< by file extension if not given
+		std::vector<std::string> extensions = {".asm", ".s", ".S", ".nasm", ".inc"};
+	};
+
+	struct FileResult
+	{
+		std::string path;
+		uint64_t hash = 0;
+		bool readable = true;
+		std::vector<SourceDiagnostic> diagnostics;
+	};
+
+	void usage()
+	{
+		std::cerr << "Usage: asmlint [options] <file or directory>...\n"
+					 "\n"
+					 "Options:\n"
+					 "  --format=text|json|sarif  output format (default: text)\n"
+					 "  --jobs=N                  number of parallel jobs (default: all cores)\n"
+					 "  --cache=FILE              reuse results of unchanged files across runs\n"
+					 "  --dialect=nasm|gas        label rules (default: gas for .s and .S files, nasm otherwise)\n"
+					 "\n"
+					 "Exits with 1 if any error was found, 2 on invalid usage.\n";
+	}
+
+	std::optional<Options> parseArguments(int argc, char* argv[])
+	{
+		Options options;
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string_view const arg = argv[i];
+			if (arg == "--format=text")
+				options.format = Format::Text;
+			else if (arg == "--format=json")
+				options.format = Format::Json;
+			else if (arg == "--format=sarif")
+				options.format = Format::Sarif;
+			else if (arg.substr(0, 7) == "--jobs=")
+			{
+				std::string_view const jobs = arg.substr(7);
+				auto const [end, error] = std::from_chars(jobs.data(), jobs.data() + jobs.size(), options.jobs);
+				if (error != std::errc() || end != jobs.data() + jobs.size())
+					return std::nullopt;
+			}
+			else if (arg == "--dialect=nasm")
+				options.dialect = Dialect::Nasm;
+			else if (arg == "--dialect=gas")
+				options.dialect = Dialect::Gas;
+			else if (arg.substr(0, 8) == "--cache=")
+				options.cacheFile = std::string(arg.substr(8));
+			else if (!arg.empty() && arg.front() == '-')
+				return std::nullopt;
+			else
+				options.paths.emplace_back(arg);
+		}
+		if (options.paths.empty())
+			return std::nullopt;
+		return options;
+	}
+
+	std::vector<std::string> collectFiles(const Options& options)
+	{
+		namespace fs = std::filesystem;
+
+		auto const matches = [&](const fs::path& path) {
+			std::string const extension = path.extension().string();
+			return std::find(options.extensions.begin(), options.extensions.end(), extension) != options.extensions.end();
+		};
+
+		std::vector<std::string> files;
+		for (std::string const& path: options.paths)
+		{
+			std::error_code ec;
+			if (!fs::is_directory(path, ec))
+			{
+				files.push_back(path);
+				continue;
+			}
+			for (auto i = fs::recursive_directory_iterator(path, fs::directory_options::skip_permission_denied, ec);
+				 !ec && i != fs::recursive_directory_iterator(); i.increment(ec))
+			{
+				if (i->is_directory(ec) && i->path().filename().string().front() == '.')
+					i.disable_recursion_pending();
+				else if (i->is_regular_file(ec) && matches(i->path()))
+					files.push_back(i->path().string());
+			}
+		}
+		std::sort(files.begin(), files.end());
+		files.erase(std::unique(files.begin(), files.end()), files.end());
+		return files;
+	}
+
+	// {{{ result cache
+	// One line per file, "F <hash> <path>", followed by one line per diagnostic,
+	// "D <line> <character> <end line> <end character> <severity> <code>\t<message>".
+	using Cache = std::unordered_map<std::string, FileResult>;
+
+	Cache loadCache(const std::string& filename)
+	{
+		Cache cache;
+		std::ifstream in(filename);
+		std::string header;
+		if (!std::getline(in, header) || header != "asmlint-cache " + std::to_string(LintVersion))
+			return cache;
+
+		FileResult* current = nullptr;
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::istringstream fields(line);
+			char kind = 0;
+			fields >> kind;
+			if (kind == 'F')
+			{
+				FileResult result;
+				fields >> result.hash;
+				fields.get();
+				std::getline(fields, result.path);
+				current = &(cache[result.path] = std::move(result));
+			}
+			else if (kind == 'D' && current)
+			{
+				SourceDiagnostic d;
+				int severity = 0;
+				fields >> d.start.line >> d.start.character >> d.end.line >> d.end.character >> severity >> d.code;
+				d.severity = static_cast<Severity>(severity);
+				fields.get();
+				std::getline(fields, d.message);
+				current->diagnostics.push_back(std::move(d));
+			}
+		}
+		return cache;
+	}
+
+	void saveCache(const std::string& filename, const std::vector<FileResult>& results)
+	{
+		std::string const temporary = filename + ".tmp";
+		{
+			std::ofstream out(temporary);
+			out << "asmlint-cache " << LintVersion << '\n';
+			for (FileResult const& result: results)
+			{
+				if (!result.readable)
+					continue;
+				out << "F " << result.hash << ' ' << result.path << '\n';
+				for (SourceDiagnostic const& d: result.diagnostics)
+					out << "D " << d.start.line << ' ' << d.start.character << ' ' << d.end.line << ' ' << d.end.character << ' '
+						<< static_cast<int>(d.severity) << ' ' << d.code << '\t' << d.message << '\n';
+			}
+		}
+		std::filesystem::rename(temporary, filename);
+	}
+	// }}}
+
+	/** FNV-1a, which unlike std::hash yields the same value in every build, as cached hashes must. */
+	uint64_t fnv1a(std::string_view text) noexcept
+	{
+		uint64_t hash = 0xcbf29ce484222325;
+		for (char const ch: text)
+			hash = (hash ^ static_cast<uint8_t>(ch)) * 0x100000001b3;
+		return hash;
+	}
+
+	FileResult lintFile(const std::string& path, Dialect dialect, const Cache& cache)
+	{
+		FileResult result;
+		result.path = path;
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			result.readable = false;
+			result.diagnostics.push_back(SourceDiagnostic{{}, {}, Severity::Error, "io-error", "cannot read file"});
+			return result;
+		}
+		std::ostringstream contents;
+		contents << file.rdbuf();
+		std::string const source = std::move(contents).str();
+		result.hash = hashCombine(fnv1a(source), static_cast<uint64_t>(dialect));
+
+		if (auto const cached = cache.find(path); cached != cache.end() && cached->second.hash == result.hash)
+			return cached->second;
+
+		result.diagnostics = lintSource(source, dialect);
+		return result;
+	}
+
+	// {{{ output
+	std::string escape(std::string_view text)
+	{
+		std::string out;
+		for (char const ch: text)
+		{
+			switch (ch)
+			{
+				case '"': out += "\\\""; break;
+				case '\\': out += "\\\\"; break;
+				case '\n': out += "\\n"; break;
+				case '\t': out += "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(ch) < 0x20)
+					{
+						char buf[8];
+						std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+						out += buf;
+					}
+					else
+						out += ch;
+			}
+		}
+		return out;
+	}
+
+	const char* levelOf(Severity severity)
+	{
+		switch (severity)
+		{
+			case Severity::Error: return "error";
+			case Severity::Warning: return "warning";
+			case Severity::Information:
+			case Severity::Hint: return "note";
+		}
+		return "none";
+	}
+
+	void writeText(std::ostream& out, const std::vector<FileResult>& results)
+	{
+		for (FileResult const& result: results)
+			for (SourceDiagnostic const& d: result.diagnostics)
+				out << result.path << ':' << d.start.line + 1 << ':' << d.start.character + 1 << ": " << levelOf(d.severity)
+					<< ": " << d.message << " [" << d.code << "]\n";
+	}
+
+	void writeJson(std::ostream& out, const std::vector<FileResult>& results)
+	{
+		out << "[";
+		bool first = true;
+		for (FileResult const& result: results)
+		{
+			for (SourceDiagnostic const& d: result.diagnostics)
+			{
+				out << (first ? "\n" : ",\n") << "  {\"file\": \"" << escape(result.path) << "\", \"range\": {\"start\": {\"line\": "
+					<< d.start.line << ", \"character\": " << d.start.character << "}, \"end\": {\"line\": " << d.end.line
+					<< ", \"character\": " << d.end.character << "}}, \"severity\": " << static_cast<int>(d.severity)
+					<< ", \"code\": \"" << escape(d.code) << "\", \"message\": \"" << escape(d.message) << "\"}";
+				first = false;
+			}
+		}
+		out << "\n]\n";
+	}
+
+	void writeSarif(std::ostream& out, const std::vector<FileResult>& results)
+	{
+		out << "{\n  \"version\": \"2.1.0\",\n"
+			   "  \"$schema\": \"https://json.schemastore.org/sarif-2.1.0.json\",\n"
+			   "  \"runs\": [{\n    \"tool\": {\"driver\": {\"name\": \"asmlint\"}},\n    \"results\": [";
+		bool first = true;
+		for (FileResult const& result: results)
+		{
+			for (SourceDiagnostic const& d: result.diagnostics)
+			{
+				out << (first ? "\n" : ",\n") << "      {\"ruleId\": \"" << escape(d.code) << "\", \"level\": \"" << levelOf(d.severity)
+					<< "\", \"message\": {\"text\": \"" << escape(d.message) << "\"}, \"locations\": [{\"physicalLocation\": {"
+					<< "\"artifactLocation\": {\"uri\": \"" << escape(result.path) << "\"}, \"region\": {\"startLine\": "
+					<< d.start.line + 1 << ", \"startColumn\": " << d.start.character + 1 << ", \"endLine\": " << d.end.line + 1
+					<< ", \"endColumn\": " << d.end.character + 1 << "}}}]}";
+				first = false;
+			}
+		}
+		out << "\n    ]\n  }]\n}\n";
+	}
+	// }}}
+}
+
+int main(int argc, char* argv[])
+{
+	std::optional<Options> const options = parseArguments(argc, argv);
+	if (!options)
+	{
+		usage();
+		return 2;
+	}
+
+	std::vector<std::string> const files = collectFiles(*options);
+	Cache const cache = options->cacheFile.empty() ? Cache{} : loadCache(options->cacheFile);
+
+	std::vector<FileResult> results(files.size());
+	{
+		ThreadPool pool(std::max<size_t>(1, std::min(files.size(), options->jobs ? options->jobs : std::thread::hardware_concurrency())));
+		TaskGroup group(pool);
+		for (size_t i = 0; i < files.size(); ++i)
+			group.run([&, i]() { results[i] = lintFile(files[i], options->dialect.value_or(dialectOf(files[i])), cache); });
+		group.wait();
+	}
+
+	if (!options->cacheFile.empty())
+		saveCache(options->cacheFile, results);
+
+	switch (options->format)
+	{
+		case Format::Text: writeText(std::cout, results); break;
+		case Format::Json: writeJson(std::cout, results); break;
+		case Format::Sarif: writeSarif(std::cout, results); break;
+	}
+
+	bool const failed = std::any_of(results.begin(), results.end(), [](const FileResult& result) {
+		return std::any_of(result.diagnostics.begin(), result.diagnostics.end(),
+						   [](const SourceDiagnostic& d) { return d.severity == Severity::Error; });
+	});
+	return failed ? 1 : 0;
+}